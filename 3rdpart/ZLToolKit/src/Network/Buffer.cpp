@@ -45,7 +45,57 @@ int sendmsg(int fd, const struct msghdr *msg, int flags) {
 }
 #endif // defined(_WIN32)
 
+#if defined(ENABLE_SENDMMSG)
+//sendmmsg单次最多发送的数据报个数
+static constexpr size_t kMaxMmsgCount = 256;
+
+ssize_t BufferList::send_mmsg_l(int fd, int flags) {
+    auto count = std::min(_iovec.size() - _iovec_off, kMaxMmsgCount);
+    _mmsg.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto &msg = _mmsg[i].msg_hdr;
+        auto buffer = static_cast<BufferSock *>(_udp_pkt[_iovec_off + i]);
+        msg.msg_name = buffer->_addr;
+        msg.msg_namelen = buffer->_addr_len;
+        msg.msg_iov = &(_iovec[_iovec_off + i]);
+        msg.msg_iovlen = 1;
+        msg.msg_control = NULL;
+        msg.msg_controllen = 0;
+        msg.msg_flags = flags;
+        _mmsg[i].msg_len = 0;
+    }
+
+    int sent;
+    do {
+        sent = sendmmsg(fd, _mmsg.data(), (unsigned int) count, flags);
+    } while (-1 == sent && UV_EINTR == get_uv_error(true));
+
+    if (sent <= 0) {
+        //一个数据报都未发送
+        return -1;
+    }
+
+    ssize_t n = 0;
+    for (int i = 0; i < sent; ++i) {
+        n += _iovec[_iovec_off + i].iov_len;
+    }
+    if (n >= (ssize_t)_remainSize) {
+        //全部写完了
+        reset();
+        return n;
+    }
+    //部分数据报发送成功
+    reOffset(n);
+    return n;
+}
+#endif //defined(ENABLE_SENDMMSG)
+
 ssize_t BufferList::send_l(int fd, int flags,bool udp) {
+#if defined(ENABLE_SENDMMSG)
+    if (udp && _iovec.size() - _iovec_off > 1) {
+        return send_mmsg_l(fd, flags);
+    }
+#endif
     ssize_t n;
     do {
         struct msghdr msg;
@@ -72,8 +122,7 @@ ssize_t BufferList::send_l(int fd, int flags,bool udp) {
 
     if(n >= (ssize_t)_remainSize){
         //全部写完了
-        _iovec_off = _iovec.size();
-        _remainSize = 0;
+        reset();
         return n;
     }
 
@@ -126,15 +175,41 @@ void BufferList::reOffset(size_t n) {
     }
 }
 
-BufferList::BufferList(List<Buffer::Ptr> &list) : _iovec(list.size()) {
-    _pkt_list.swap(list);
-    auto it = _iovec.begin();
-    _pkt_list.for_each([&](Buffer::Ptr &buffer){
-        it->iov_base = buffer->data();
-        it->iov_len = (decltype(it->iov_len))buffer->size();
-        _remainSize += it->iov_len;
-        ++it;
+BufferList::BufferList(List<Buffer::Ptr> &list) {
+    append(list);
+}
+
+void BufferList::reset() {
+    //释放已发送的数据，iovec数组只清空不释放内存，以便下次复用
+    _iovec.clear();
+    _iovec_off = 0;
+    _remainSize = 0;
+    _pkt_list.clear();
+#if defined(ENABLE_SENDMMSG)
+    _udp_pkt.clear();
+#endif
+}
+
+void BufferList::append(List<Buffer::Ptr> &list) {
+    if (_iovec_off) {
+        //回收已经发送完毕的iovec，未发送部分移至数组头部
+        _iovec.erase(_iovec.begin(), _iovec.begin() + _iovec_off);
+#if defined(ENABLE_SENDMMSG)
+        _udp_pkt.erase(_udp_pkt.begin(), _udp_pkt.begin() + _iovec_off);
+#endif
+        _iovec_off = 0;
+    }
+    list.for_each([&](Buffer::Ptr &buffer) {
+        struct iovec iov;
+        iov.iov_base = buffer->data();
+        iov.iov_len = (decltype(iov.iov_len)) buffer->size();
+        _remainSize += iov.iov_len;
+        _iovec.emplace_back(iov);
+#if defined(ENABLE_SENDMMSG)
+        _udp_pkt.emplace_back(buffer.get());
+#endif
     });
+    _pkt_list.append(list);
 }
 
 BufferSock::BufferSock(Buffer::Ptr buffer,struct sockaddr *addr, int addr_len){
@@ -85,6 +85,33 @@ private:
 
 typedef BufferOffset<string> BufferString;
 
+//引用另一个Buffer的部分数据，不拷贝
+class BufferPartial : public Buffer {
+public:
+    typedef std::shared_ptr<BufferPartial> Ptr;
+
+    BufferPartial(const Buffer::Ptr &buffer, size_t offset, size_t size) {
+        _buffer = buffer;
+        _data = buffer->data() + offset;
+        _size = size;
+    }
+
+    ~BufferPartial() override {}
+
+    char *data() const override {
+        return _data;
+    }
+
+    size_t size() const override {
+        return _size;
+    }
+
+private:
+    char *_data;
+    size_t _size;
+    Buffer::Ptr _buffer;
+};
+
 //指针式缓存对象，
 class BufferRaw : public Buffer{
 public:
@@ -425,6 +452,11 @@ struct msghdr {
 #define IOV_MAX 1024
 #endif
 
+#if defined(__linux__) || defined(__linux)
+//linux下udp批量发送采用sendmmsg，一次系统调用发送多个数据报
+#define ENABLE_SENDMMSG
+#endif
+
 class BufferList;
 class BufferSock : public Buffer{
 public:
@@ -444,6 +476,7 @@ private:
 class BufferList : public noncopyable {
 public:
     typedef std::shared_ptr<BufferList> Ptr;
+    BufferList() = default;
     BufferList(List<Buffer::Ptr> &list);
     ~BufferList() {}
 
@@ -451,15 +484,30 @@ public:
     size_t count();
     ssize_t send(int fd, int flags, bool udp);
 
+    /**
+     * 把list中的数据追加到末尾(list会被清空)，
+     * 已发送部分的iovec会被回收，iovec数组的内存可以反复复用
+     */
+    void append(List<Buffer::Ptr> &list);
+
 private:
     void reOffset(size_t n);
+    void reset();
     ssize_t send_l(int fd, int flags, bool udp);
+#if defined(ENABLE_SENDMMSG)
+    ssize_t send_mmsg_l(int fd, int flags);
+#endif
 
 private:
     size_t _iovec_off = 0;
     size_t _remainSize = 0;
     vector<struct iovec> _iovec;
     List<Buffer::Ptr> _pkt_list;
+#if defined(ENABLE_SENDMMSG)
+    //udp每个数据报的目标地址，下标与_iovec一一对应
+    vector<Buffer *> _udp_pkt;
+    vector<struct mmsghdr> _mmsg;
+#endif
 };
 
 }//namespace toolkit
@@ -234,6 +234,10 @@ bool Socket::attachEvent(const SockFD::Ptr &sock, bool is_udp) {
 
         if (event & Event_Read) {
             strong_self->onRead(strong_sock, is_udp);
+            if (!strong_self->_poller->isCurrentThread()) {
+                //socket在on_read回调中被迁移到其他poller线程，剩余事件由新线程处理
+                return;
+            }
         }
         if (event & Event_Write) {
             strong_self->onWriteAble(strong_sock);
@@ -257,8 +261,10 @@ ssize_t Socket::onRead(const SockFD::Ptr &sock, bool is_udp) noexcept{
 
     struct sockaddr addr;
     socklen_t len = sizeof(struct sockaddr);
+    //socket在on_read回调中可能被迁移到其他poller线程，此后不能在本线程继续读取
+    auto poller = _poller.get();
 
-    while (_enable_recv) {
+    while (_enable_recv && poller == _poller.get()) {
         do {
             nread = recvfrom(sock_fd, data, capacity, 0, &addr, &len);
         } while (-1 == nread && UV_EINTR == get_uv_error(true));
@@ -310,7 +316,8 @@ bool Socket::emitErr(const SockException& err) noexcept{
     closeSock();
 
     weak_ptr<Socket> weak_self = shared_from_this();
-    _poller->async([weak_self, err]() {
+    //可能在其他线程触发
+    getPollerSafe()->async([weak_self, err]() {
         auto strong_self = weak_self.lock();
         if (!strong_self) {
             return;
@@ -363,6 +370,7 @@ ssize_t Socket::send(Buffer::Ptr buf, struct sockaddr *addr, socklen_t addr_len,
         LOCK_GUARD(_mtx_send_buf_waiting);
         _send_buf_waiting.emplace_back(sock->type() == SockNum::Sock_UDP ? std::make_shared<BufferSock>(std::move(buf), addr, addr_len) : buf);
     }
+    _send_buf_bytes += size;
 
     if(try_flush){
         if (_sendable) {
@@ -409,13 +417,15 @@ size_t Socket::getSendBufferCount(){
 
     {
         LOCK_GUARD(_mtx_send_buf_sending);
-        _send_buf_sending.for_each([&](BufferList::Ptr &buf) {
-            ret += buf->count();
-        });
+        ret += _send_buf_sending.count();
     }
     return ret;
 }
 
+size_t Socket::getSendBufferBytes() {
+    return _send_buf_bytes;
+}
+
 uint64_t Socket::elapsedTimeAfterFlushed(){
     return _send_flush_ticker.elapsedTime();
 }
@@ -443,17 +453,17 @@ bool Socket::listen(const SockFD::Ptr &sock){
     return true;
 }
 
-bool Socket::listen(uint16_t port, const string &local_ip, int backlog) {
-    int sock = SockUtil::listen(port, local_ip.data(), backlog);
+bool Socket::listen(uint16_t port, const string &local_ip, int backlog, bool reuse_port) {
+    int sock = SockUtil::listen(port, local_ip.data(), backlog, reuse_port);
     if (sock == -1) {
         return false;
     }
     return listen(makeSock(sock, SockNum::Sock_TCP));
 }
 
-bool Socket::bindUdpSock(uint16_t port, const string &local_ip) {
+bool Socket::bindUdpSock(uint16_t port, const string &local_ip, bool reuse_port) {
     closeSock();
-    int fd = SockUtil::bindUdpSock(port, local_ip.data());
+    int fd = SockUtil::bindUdpSock(port, local_ip.data(), reuse_port);
     if (fd == -1) {
         return false;
     }
@@ -588,80 +598,64 @@ string Socket::getIdentifier() const{
 }
 
 bool Socket::flushData(const SockFD::Ptr &sock, bool poller_thread) {
-    decltype(_send_buf_sending) send_buf_sending_tmp;
+    int fd = sock->rawFd();
+    bool is_udp = sock->type() == SockNum::Sock_UDP;
+    bool empty_buffer = false;
+    bool all_sent = false;
+    int err = 0;
     {
-        //转移出二级缓存
+        //持锁发送，防止多个线程同时flush导致数据乱序(未开启锁时本身就只能在poller线程发送)
         LOCK_GUARD(_mtx_send_buf_sending);
-        if(!_send_buf_sending.empty()){
-            send_buf_sending_tmp.swap(_send_buf_sending);
+        if (_send_buf_sending.empty()) {
+            //上次的数据已经全部写入socket
+            _send_flush_ticker.resetTime();
         }
-    }
-
-    if (send_buf_sending_tmp.empty()) {
-        _send_flush_ticker.resetTime();
-        do {
-            {
-                //二级发送缓存为空，那么我们接着消费一级缓存中的数据
-                LOCK_GUARD(_mtx_send_buf_waiting);
-                if (!_send_buf_waiting.empty()) {
-                    //把一级缓中数数据放置到二级缓存中并清空
-                    send_buf_sending_tmp.emplace_back(std::make_shared<BufferList>(_send_buf_waiting));
-                    break;
-                }
-            }
-            //如果一级缓存也为空,那么说明所有数据均写入socket了
-            if (poller_thread) {
-                //poller线程触发该函数，那么该socket应该已经加入了可写事件的监听；
-                //那么在数据列队清空的情况下，我们需要关闭监听以免触发无意义的事件回调
-                stopWriteAbleEvent(sock);
-                onFlushed(sock);
+        {
+            //把一级缓存中的数据全部追加到二级缓存，合并为一次writev/sendmmsg
+            LOCK_GUARD(_mtx_send_buf_waiting);
+            if (!_send_buf_waiting.empty()) {
+                _send_buf_sending.append(_send_buf_waiting);
             }
-            return true;
-        } while (0);
-    }
+        }
 
-    int fd = sock->rawFd();
-    bool is_udp = sock->type() == SockNum::Sock_UDP;
-    while (!send_buf_sending_tmp.empty()) {
-        auto &packet = send_buf_sending_tmp.front();
-        auto n = packet->send(fd, _sock_flags, is_udp);
-        if (n > 0) {
-            //全部或部分发送成功
-            if (packet->empty()) {
-                //全部发送成功
-                send_buf_sending_tmp.pop_front();
-                continue;
-            }
-            //部分发送成功
-            if (!poller_thread) {
-                //如果该函数是poller线程触发的，那么该socket应该已经加入了可写事件的监听，所以我们不需要再次加入监听
-                startWriteAbleEvent(sock);
+        if (_send_buf_sending.empty()) {
+            //一级、二级缓存均为空,说明所有数据均写入socket了
+            empty_buffer = true;
+        } else {
+            auto n = _send_buf_sending.send(fd, _sock_flags, is_udp);
+            if (n > 0) {
+                //全部或部分发送成功
+                _send_buf_bytes -= n;
+                all_sent = _send_buf_sending.empty();
+            } else {
+                //一个都没发送成功
+                err = get_uv_error(true);
             }
-            break;
         }
+    }
 
-        //一个都没发送成功
-        int err = get_uv_error(true);
-        if (err == UV_EAGAIN) {
-            //等待下一次发送
-            if (!poller_thread) {
-                //如果该函数是poller线程触发的，那么该socket应该已经加入了可写事件的监听，所以我们不需要再次加入监听
-                startWriteAbleEvent(sock);
-            }
-            break;
+    if (empty_buffer) {
+        if (poller_thread) {
+            //poller线程触发该函数，那么该socket应该已经加入了可写事件的监听；
+            //那么在数据列队清空的情况下，我们需要关闭监听以免触发无意义的事件回调
+            stopWriteAbleEvent(sock);
+            onFlushed(sock);
         }
+        return true;
+    }
+
+    if (err && err != UV_EAGAIN) {
         //其他错误代码，发生异常
         onError(sock);
         return false;
     }
 
-    //回滚未发送完毕的数据
-    if (!send_buf_sending_tmp.empty()) {
-        //有剩余数据
-        LOCK_GUARD(_mtx_send_buf_sending);
-        send_buf_sending_tmp.swap(_send_buf_sending);
-        _send_buf_sending.append(send_buf_sending_tmp);
-        //二级缓存未全部发送完毕，说明该socket不可写，直接返回
+    if (!all_sent) {
+        //部分发送成功或者socket写缓存已满，等待下一次发送
+        if (!poller_thread) {
+            //如果该函数是poller线程触发的，那么该socket应该已经加入了可写事件的监听，所以我们不需要再次加入监听
+            startWriteAbleEvent(sock);
+        }
         return true;
     }
 
@@ -741,10 +735,77 @@ bool Socket::isSocketBusy() const{
     return !_sendable.load();
 }
 
+int Socket::flushAll() {
+    SockFD::Ptr sock;
+    {
+        LOCK_GUARD(_mtx_sock_fd);
+        sock = _sock_fd;
+    }
+    if (!sock) {
+        return -1;
+    }
+    if (!_sendable) {
+        //socket不可写，等待可写事件触发后自动发送
+        return 0;
+    }
+    return flushData(sock, false) ? 0 : -1;
+}
+
+bool Socket::moveToPoller(const EventPoller::Ptr &poller, function<void()> cb) {
+    if (!_enable_move || !poller || poller == _poller || !_poller->isCurrentThread()) {
+        return false;
+    }
+    SockFD::Ptr sock;
+    {
+        LOCK_GUARD(_mtx_sock_fd);
+        if (!_sock_fd || _sock_fd->type() != SockNum::Sock_TCP) {
+            return false;
+        }
+        //复制的SockFD与原对象共用同一个fd，原对象析构时只移除本poller的监听，不会关闭fd
+        sock = std::make_shared<SockFD>(*_sock_fd, poller);
+        _sock_fd = sock;
+        lock_guard<mutex> lck_poller(_mtx_poller);
+        _poller = poller;
+    }
+
+    weak_ptr<Socket> weak_self = shared_from_this();
+    poller->async([weak_self, sock, cb]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return;
+        }
+        bool closed;
+        {
+            LOCK_GUARD(strong_self->_mtx_sock_fd);
+            closed = strong_self->_sock_fd != sock;
+        }
+        //迁移期间socket已经关闭时不再监听事件，但是仍然执行cb，onErr事件已经投递到新poller线程，随后触发
+        if (!closed && !strong_self->attachEvent(sock, false)) {
+            strong_self->emitErr(SockException(Err_other, "add event to poller failed when move socket"));
+        }
+        if (cb) {
+            cb();
+        }
+    }, false);
+    return true;
+}
+
+void Socket::enableMoveToPoller() {
+    _enable_move = true;
+}
+
 const EventPoller::Ptr &Socket::getPoller() const{
     return _poller;
 }
 
+EventPoller::Ptr Socket::getPollerSafe() const {
+    if (!_enable_move) {
+        return _poller;
+    }
+    lock_guard<mutex> lck(_mtx_poller);
+    return _poller;
+}
+
 bool Socket::cloneFromListenSocket(const Socket &other){
     SockFD::Ptr sock;
     {
@@ -813,7 +874,26 @@ SocketHelper::SocketHelper(const Socket::Ptr &sock) {
 SocketHelper::~SocketHelper() {}
 
 void SocketHelper::setPoller(const EventPoller::Ptr &poller){
+    lock_guard<recursive_mutex> lck(_mtx_poller);
+    _poller = poller;
+}
+
+void SocketHelper::enableSwitchPoller() {
+    _enable_switch = true;
+}
+
+bool SocketHelper::switchPoller(const EventPoller::Ptr &poller, const function<bool()> &start) {
+    if (!_enable_switch) {
+        return false;
+    }
+    lock_guard<recursive_mutex> lck(_mtx_poller);
+    auto old_poller = std::move(_poller);
     _poller = poller;
+    if (!start()) {
+        _poller = std::move(old_poller);
+        return false;
+    }
+    return true;
 }
 
 void SocketHelper::setSock(const Socket::Ptr &sock) {
@@ -823,7 +903,7 @@ void SocketHelper::setSock(const Socket::Ptr &sock) {
     _local_ip.clear();
     _sock = sock;
     if (_sock) {
-        _poller = _sock->getPoller();
+        setPoller(_sock->getPoller());
     }
 }
 
@@ -832,6 +912,14 @@ const EventPoller::Ptr& SocketHelper::getPoller() const {
     return _poller;
 }
 
+EventPoller::Ptr SocketHelper::getPollerSafe() const {
+    if (!_enable_switch) {
+        return _poller;
+    }
+    lock_guard<recursive_mutex> lck(_mtx_poller);
+    return _poller;
+}
+
 const Socket::Ptr& SocketHelper::getSock() const{
     return _sock;
 }
@@ -898,11 +986,18 @@ bool SocketHelper::isSocketBusy() const {
 }
 
 Task::Ptr SocketHelper::async(TaskIn task, bool may_sync) {
-    return _poller->async(std::move(task), may_sync);
+    if (!_enable_switch) {
+        //所属poller线程不会改变，无需加锁
+        return _poller->async(std::move(task), may_sync);
+    }
+    return getPollerSafe()->async(std::move(task), may_sync);
 }
 
 Task::Ptr SocketHelper::async_first(TaskIn task, bool may_sync) {
-    return _poller->async_first(std::move(task), may_sync);
+    if (!_enable_switch) {
+        return _poller->async_first(std::move(task), may_sync);
+    }
+    return getPollerSafe()->async_first(std::move(task), may_sync);
 }
 
 void SocketHelper::setSendFlushFlag(bool try_flush) {
@@ -927,7 +1022,7 @@ void SocketHelper::setOnCreateSocket(Socket::onCreateSocket cb){
 }
 
 Socket::Ptr SocketHelper::createSocket(){
-    return _on_create_socket(_poller);
+    return _on_create_socket(getPollerSafe());
 }
 
 }  // namespace toolkit
@@ -291,17 +291,19 @@ public:
      * @param port 监听端口，0则随机
      * @param local_ip 监听的网卡ip
      * @param backlog tcp最大积压数
+     * @param reuse_port 是否开启SO_REUSEPORT
      * @return 是否成功
      */
-    virtual bool listen(uint16_t port, const string &local_ip = "0.0.0.0", int backlog = 1024);
+    virtual bool listen(uint16_t port, const string &local_ip = "0.0.0.0", int backlog = 1024, bool reuse_port = false);
 
     /**
      * 创建udp套接字,udp是无连接的，所以可以作为服务器和客户端
      * @param port 绑定的端口为0则随机
      * @param local_ip 绑定的网卡ip
+     * @param reuse_port 是否开启SO_REUSEPORT，多个socket绑定同一端口时使用
      * @return 是否成功
      */
-    virtual bool bindUdpSock(uint16_t port, const string &local_ip = "0.0.0.0");
+    virtual bool bindUdpSock(uint16_t port, const string &local_ip = "0.0.0.0", bool reuse_port = false);
 
     ////////////设置事件回调////////////
 
@@ -396,8 +398,31 @@ public:
      */
     virtual bool isSocketBusy() const;
 
+    /**
+     * 立即发送所有未发送的数据(send时try_flush为false的数据)
+     * @return -1代表失败(socket已断开或发送出错)，0代表成功或socket不可写(可写后自动发送)
+     */
+    int flushAll();
+
+    /**
+     * 允许本socket迁移到其他poller线程，必须在其他线程访问本对象之前调用
+     * 未开启时moveToPoller返回false，所属poller线程永不改变，访问poller无需加锁
+     */
+    void enableMoveToPoller();
+
+    /**
+     * 把tcp socket迁移到其他poller线程，必须在当前poller线程调用
+     * 调用后立即停止在本poller线程的事件监听，然后在新poller线程中重新监听并执行cb，
+     * 期间(cb执行前)不能再访问本对象，未发送的数据会在迁移后继续发送
+     * @param poller 目标poller线程
+     * @param cb 迁移完成后在新poller线程中执行的回调，返回true时cb一定会被执行(迁移期间socket被关闭时也会执行，onErr事件随后触发)
+     * @return 是否开始迁移
+     */
+    bool moveToPoller(const EventPoller::Ptr &poller, function<void()> cb);
+
     /**
      * 获取poller线程对象
+     * 开启迁移后只能在所属poller线程调用
      * @return poller线程对象
      */
     virtual const EventPoller::Ptr &getPoller() const;
@@ -434,6 +459,11 @@ public:
      */
     virtual size_t getSendBufferCount();
 
+    /**
+     * 获取发送缓存中尚未写入socket的字节数
+     */
+    virtual size_t getSendBufferBytes();
+
     /**
      * 获取上次socket发送缓存清空至今的毫秒数,单位毫秒
      */
@@ -460,6 +490,8 @@ private:
     bool listen(const SockFD::Ptr &sock);
     bool flushData(const SockFD::Ptr &sock, bool poller_thread);
     bool attachEvent(const SockFD::Ptr &sock, bool is_udp = false);
+    //任意线程获取poller线程对象，开启迁移后需要加锁
+    EventPoller::Ptr getPollerSafe() const;
 
 private:
     //send socket时的flag
@@ -483,7 +515,12 @@ private:
     //socket fd的抽象类
     SockFD::Ptr _sock_fd;
     //本socket绑定的poller线程，事件触发于此线程
+    //开启迁移后会在所属poller线程修改，此时其他线程需要加锁访问
     EventPoller::Ptr _poller;
+    //是否允许迁移到其他poller线程
+    atomic<bool> _enable_move{false};
+    //开启迁移后跨线程访问_poller时需要上锁
+    mutable mutex _mtx_poller;
     //跨线程访问_sock_fd时需要上锁
     mutable MutexWrapper<recursive_mutex> _mtx_sock_fd;
 
@@ -504,10 +541,13 @@ private:
     List<Buffer::Ptr> _send_buf_waiting;
     //一级发送缓存锁
     MutexWrapper<recursive_mutex> _mtx_send_buf_waiting;
-    //二级发送缓存, socket可写时，会把二级缓存批量写入到socket
-    List<BufferList::Ptr> _send_buf_sending;
+    //二级发送缓存, socket可写时，会把一级缓存追加至此并通过一次writev/sendmmsg批量写入到socket，
+    //其iovec数组常驻复用，避免每次flush重新分配
+    BufferList _send_buf_sending;
     //二级发送缓存锁
     MutexWrapper<recursive_mutex> _mtx_send_buf_sending;
+    //一级、二级发送缓存中尚未写入socket的字节数
+    atomic<size_t> _send_buf_bytes {0};
 };
 
 class SockSender {
@@ -546,6 +586,7 @@ public:
     ///////////////////// Socket util functions /////////////////////
     /**
      * 获取poller线程
+     * 开启迁移后只能在所属poller线程调用，其他线程请通过async()投递任务
      */
     const EventPoller::Ptr& getPoller() const;
 
@@ -613,9 +654,23 @@ public:
 
 protected:
     void setPoller(const EventPoller::Ptr &poller);
+    /**
+     * 允许所属poller线程被切换，必须在其他线程访问本对象之前调用
+     * 未开启时访问poller无需加锁
+     */
+    void enableSwitchPoller();
+    /**
+     * 切换所属poller线程并执行start，start返回false时恢复原poller线程
+     * 两者在同一把锁内执行，其他线程此后通过async()投递的任务一定排在start投递到新线程的任务之后
+     */
+    bool switchPoller(const EventPoller::Ptr &poller, const function<bool()> &start);
     void setSock(const Socket::Ptr &sock);
     const Socket::Ptr& getSock() const;
 
+private:
+    //任意线程获取poller线程对象，开启切换后需要加锁
+    EventPoller::Ptr getPollerSafe() const;
+
 private:
     bool _try_flush = true;
     uint16_t _peer_port = 0;
@@ -623,7 +678,11 @@ private:
     string _peer_ip;
     string _local_ip;
     Socket::Ptr _sock;
+    //开启切换后会在所属poller线程修改，其他线程会通过async()访问，需要上锁
     EventPoller::Ptr _poller;
+    //是否允许切换所属poller线程
+    atomic<bool> _enable_switch{false};
+    mutable recursive_mutex _mtx_poller;
     Socket::onCreateSocket _on_create_socket;
 };
 
@@ -109,6 +109,15 @@ public:
         return _session;
     }
 
+    //会话所属的TcpServer，会话迁移到其他poller线程后随之改变
+    const std::weak_ptr<TcpServer> &server() const{
+        return _server;
+    }
+
+    void setServer(const std::weak_ptr<TcpServer> &server){
+        _server = server;
+    }
+
 private:
     string _identifier;
     TcpSession::Ptr _session;
@@ -129,6 +138,8 @@ public:
      * 这些子TcpServer对象通过Socket对象克隆的方式在多个poller线程中监听同一个listen fd
      * 这样这个TCP服务器将会通过抢占式accept的方式把客户端均匀的分布到不同的poller线程
      * 通过该方式能实现客户端负载均衡以及提高连接接收速度
+     * 开启enableReusePort后，子TcpServer对象不再克隆listen fd，而是各自创建SO_REUSEPORT监听socket，
+     * 每个poller线程拥有独立的accept列队，由内核按四元组hash分配新连接
      */
     TcpServer(const EventPoller::Ptr &poller = nullptr) {
         setOnCreateSocket(nullptr);
@@ -149,6 +160,33 @@ public:
         _cloned_server.clear();
     }
 
+    /**
+     * 设置是否每个poller线程创建一个SO_REUSEPORT监听socket，在start之前调用有效
+     * 如果EventPollerPool开启了cpu绑定，那么还会设置SO_INCOMING_CPU，使新连接优先在收包的cpu上accept
+     * @param enable 是否开启
+     */
+    void enableReusePort(bool enable = true) {
+        _reuse_port = enable;
+    }
+
+    /**
+     * 设置是否允许会话迁移到其他poller线程(TcpSession::moveToPoller)，在start之前调用有效
+     * 未开启时会话所属poller线程永不改变，投递任务、获取poller线程都无需加锁
+     * @param enable 是否开启
+     */
+    void enableSessionMove(bool enable = true) {
+        _enable_session_move = enable;
+    }
+
+    /**
+     * 设置客户端连接的TCP_NOTSENT_LOWAT，在start之前调用有效
+     * 设置后内核只缓存少量未发送数据，其余数据留在应用层(与其他播放器共享)，socket可写时再发送
+     * @param bytes 水位字节数，0为不设置
+     */
+    void setNotSentLowat(uint32_t bytes) {
+        _notsent_lowat = bytes;
+    }
+
     //开始监听服务器
     template <typename SessionType>
     void start(uint16_t port, const std::string &host = "0.0.0.0", uint32_t backlog = 1024) {
@@ -164,6 +202,7 @@ public:
             }
             if (serverRef) {
                 serverRef->cloneFrom(*this);
+                serverRef->_parent = shared_from_this();
             }
         });
     }
@@ -207,7 +246,15 @@ protected:
         }
         _on_create_socket = that._on_create_socket;
         _session_alloc = that._session_alloc;
-        _socket->cloneFromListenSocket(*(that._socket));
+        _reuse_port = that._reuse_port;
+        _notsent_lowat = that._notsent_lowat;
+        _enable_session_move = that._enable_session_move;
+        if (_reuse_port) {
+            //每个poller线程独立监听同一端口(端口可能是随机分配的，所以取实际监听端口)
+            listen_l(that._socket->get_local_port(), that._host, that._backlog);
+        } else {
+            _socket->cloneFromListenSocket(*(that._socket));
+        }
         weak_ptr<TcpServer> weak_self = shared_from_this();
         _timer = std::make_shared<Timer>(2.0f, [weak_self]() -> bool {
             auto strong_self = weak_self.lock();
@@ -224,7 +271,6 @@ protected:
     // 接收到客户端连接请求
     virtual void onAcceptConnection(const Socket::Ptr &sock) {
         assert(_poller->isCurrentThread());
-        weak_ptr<TcpServer> weak_self = shared_from_this();
         //创建一个TcpSession;这里实现创建不同的服务会话实例
         auto helper = _session_alloc(shared_from_this(), sock);
         auto &session = helper->session();
@@ -241,29 +287,49 @@ protected:
             //获取会话强应用
             auto strong_session = weak_session.lock();
             if (strong_session) {
-                strong_session->onRecv(buf);
+                strong_session->onRecv_l(buf);
             }
         });
 
-        TcpSessionHelper *ptr = helper.get();
+        //会话可能迁移到其他poller线程(由其他TcpServer管理)，所以通过helper获取其当前所属的TcpServer
+        weak_ptr<TcpSessionHelper> weak_helper = helper;
+        if (_enable_session_move) {
+            sock->enableMoveToPoller();
+            session->enableSwitchPoller();
+            session->_on_move = [weak_helper](const EventPoller::Ptr &poller, function<void()> cb) {
+                auto strong_helper = weak_helper.lock();
+                if (!strong_helper) {
+                    return false;
+                }
+                auto strong_server = strong_helper->server().lock();
+                return strong_server && strong_server->moveSession(strong_helper, poller, std::move(cb));
+            };
+        }
+
         //会话接收到错误事件
-        sock->setOnErr([weak_self, weak_session, ptr](const SockException &err) {
+        sock->setOnErr([weak_helper, weak_session](const SockException &err) {
             //在本函数作用域结束时移除会话对象
             //目的是确保移除会话前执行其onError函数
             //同时避免其onError函数抛异常时没有移除会话对象
             onceToken token(nullptr, [&]() {
                 //移除掉会话
-                auto strong_self = weak_self.lock();
+                auto strong_helper = weak_helper.lock();
+                if (!strong_helper) {
+                    return;
+                }
+                auto strong_self = strong_helper->server().lock();
                 if (!strong_self) {
                     return;
                 }
 
+                auto ptr = strong_helper.get();
                 assert(strong_self->_poller->isCurrentThread());
                 if (!strong_self->_is_on_manager) {
                     //该事件不是onManager时触发的，直接操作map
                     strong_self->_session_map.erase(ptr);
                 } else {
                     //遍历map时不能直接删除元素
+                    weak_ptr<TcpServer> weak_self = strong_self;
                     strong_self->_poller->async([weak_self, ptr]() {
                         auto strong_self = weak_self.lock();
                         if (strong_self) {
@@ -283,15 +349,91 @@ protected:
     }
 
 private:
+    //获取在指定poller线程中监听的TcpServer(主TcpServer或其克隆对象)
+    TcpServer::Ptr getServer(const EventPoller::Ptr &poller) {
+        auto root = _parent.lock();
+        if (!root) {
+            root = shared_from_this();
+        }
+        if (root->_poller == poller) {
+            return root;
+        }
+        auto it = root->_cloned_server.find(poller.get());
+        return it == root->_cloned_server.end() ? nullptr : it->second;
+    }
+
+    //把会话迁移到其他poller线程，由该线程的TcpServer接管
+    bool moveSession(const TcpSessionHelper::Ptr &helper, const EventPoller::Ptr &poller, function<void()> cb) {
+        assert(_poller->isCurrentThread());
+        if (_is_on_manager || poller == _poller) {
+            return false;
+        }
+        auto server = getServer(poller);
+        if (!server || !_session_map.count(helper.get())) {
+            return false;
+        }
+        weak_ptr<TcpServer> weak_server = server;
+        //迁移完成后socket事件在新poller线程触发，在此之前需要先切换会话所属的TcpServer
+        helper->setServer(server);
+        auto moved = helper->session()->getSock()->moveToPoller(poller, [weak_server, helper, cb]() {
+            auto strong_server = weak_server.lock();
+            if (!strong_server) {
+                return;
+            }
+            strong_server->_session_map.emplace(helper.get(), helper);
+            cb();
+        });
+        if (!moved) {
+            helper->setServer(shared_from_this());
+            return false;
+        }
+        _session_map.erase(helper.get());
+        return true;
+    }
+
     Socket::Ptr onBeforeAcceptConnection_l(const EventPoller::Ptr &poller) {
         return onBeforeAcceptConnection(poller);
     }
 
     // 接收到客户端连接请求
     void onAcceptConnection_l(const Socket::Ptr &sock) {
+        _poller->addAcceptCount();
+        if (_notsent_lowat) {
+            SockUtil::setNotSentLowat(sock->rawFD(), _notsent_lowat);
+        }
         onAcceptConnection(sock);
     }
 
+    //开启SO_REUSEPORT后其他进程也能监听同一端口并被内核分走部分连接，
+    //所以先用不带SO_REUSEPORT的socket探测，端口已被监听时报错
+    void checkPortInUse(uint16_t port, const std::string &host) {
+        int probe_fd = (int) socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (probe_fd == -1) {
+            return;
+        }
+        //允许绑定处于TIME_WAIT状态的端口
+        SockUtil::setReuseable(probe_fd, true, false);
+        bool in_use = SockUtil::bindSock(probe_fd, host.c_str(), port) == -1;
+        string err = in_use ? get_uv_errmsg(true) : "";
+        close(probe_fd);
+        if (in_use) {
+            throw std::runtime_error(StrPrinter << "listen on " << host << ":" << port << " failed:" << err);
+        }
+    }
+
+    void listen_l(uint16_t port, const std::string &host, uint32_t backlog) {
+        if (!_socket->listen(port, host.c_str(), backlog, _reuse_port)) {
+            //创建tcp监听失败，可能是由于端口占用或权限问题
+            string err = (StrPrinter << "listen on " << host << ":" << port << " failed:" << get_uv_errmsg(true));
+            throw std::runtime_error(err);
+        }
+        _host = host;
+        _backlog = backlog;
+        if (_reuse_port && _poller->getCpuIndex() >= 0) {
+            SockUtil::setIncomingCpu(_socket->rawFD(), _poller->getCpuIndex());
+        }
+    }
+
     template<typename SessionType>
     void start_l(uint16_t port, const std::string &host = "0.0.0.0", uint32_t backlog = 1024) {
         //TcpSession创建器，通过它创建不同类型的服务器
@@ -301,11 +443,10 @@ private:
             return std::make_shared<TcpSessionHelper>(server, session);
         };
 
-        if (!_socket->listen(port, host.c_str(), backlog)) {
-            //创建tcp监听失败，可能是由于端口占用或权限问题
-            string err = (StrPrinter << "listen on " << host << ":" << port << " failed:" << get_uv_errmsg(true));
-            throw std::runtime_error(err);
+        if (_reuse_port && port) {
+            checkPortInUse(port, host);
         }
+        listen_l(port, host, backlog);
 
         //新建一个定时器定时管理这些tcp会话
         weak_ptr<TcpServer> weak_self = shared_from_this();
@@ -317,7 +458,7 @@ private:
             strong_self->onManagerSession();
             return true;
         }, _poller);
-        InfoL << "TCP Server listening on " << host << ":" << port;
+        InfoL << "TCP Server listening on " << host << ":" << port << (_reuse_port ? " with SO_REUSEPORT" : "");
     }
 
     //定时管理Session
@@ -347,8 +488,15 @@ private:
 private:
     bool _cloned = false;
     bool _is_on_manager = false;
+    bool _reuse_port = false;
+    bool _enable_session_move = false;
+    uint32_t _notsent_lowat = 0;
+    uint32_t _backlog = 1024;
+    string _host;
     Socket::Ptr _socket;
     EventPoller::Ptr _poller;
+    //克隆对象所属的主TcpServer
+    std::weak_ptr<TcpServer> _parent;
     std::shared_ptr<Timer> _timer;
     Socket::onCreateSocket _on_create_socket;
     unordered_map<TcpSessionHelper *, TcpSessionHelper::Ptr> _session_map;
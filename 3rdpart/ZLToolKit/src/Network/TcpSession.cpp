@@ -10,6 +10,7 @@
 
 #include <string>
 #include "TcpSession.h"
+#include "Util/onceToken.h"
 
 namespace toolkit {
 
@@ -33,5 +34,68 @@ void TcpSession::safeShutdown(const SockException &ex){
     });
 }
 
+bool TcpSession::moveToPoller(const EventPoller::Ptr &poller, function<void()> cb) {
+    if (!_on_move || !poller || _move_cb) {
+        return false;
+    }
+    if (_in_recv) {
+        //onRecv中不能迁移，否则本线程后续还会继续处理该会话的数据
+        _move_poller = poller;
+        _move_cb = std::move(cb);
+        return true;
+    }
+    auto old_poller = getPoller();
+    auto moved = switchPoller(poller, [&]() {
+        return _on_move(poller, cb);
+    });
+    if (!moved) {
+        old_poller->async(std::move(cb), false);
+    }
+    return true;
+}
+
+TaskIn TcpSession::wrapTask(TaskIn task) {
+    if (!_on_move) {
+        //不支持迁移的会话，所属poller线程不会改变
+        return task;
+    }
+    weak_ptr<TcpSession> weak_self = shared_from_this();
+    return [weak_self, task]() {
+        auto strong_self = weak_self.lock();
+        if (strong_self && !strong_self->getPoller()->isCurrentThread()) {
+            //任务投递后会话被迁移到了其他poller线程
+            strong_self->async(task, false);
+            return;
+        }
+        task();
+    };
+}
+
+Task::Ptr TcpSession::async(TaskIn task, bool may_sync) {
+    return SocketHelper::async(wrapTask(std::move(task)), may_sync);
+}
+
+Task::Ptr TcpSession::async_first(TaskIn task, bool may_sync) {
+    return SocketHelper::async_first(wrapTask(std::move(task)), may_sync);
+}
+
+void TcpSession::onRecv_l(const Buffer::Ptr &buf) {
+    {
+        onceToken token([&]() {
+            _in_recv = true;
+        }, [&]() {
+            _in_recv = false;
+        });
+        onRecv(buf);
+    }
+    if (!_move_cb) {
+        return;
+    }
+    auto poller = std::move(_move_poller);
+    auto cb = std::move(_move_cb);
+    _move_cb = nullptr;
+    moveToPoller(poller, std::move(cb));
+}
+
 } /* namespace toolkit */
 
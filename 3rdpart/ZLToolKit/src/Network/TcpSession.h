@@ -67,6 +67,40 @@ public:
      * @param ex 触发onError事件的原因
      */
     void safeShutdown(const SockException &ex = SockException(Err_shutdown, "self shutdown"));
+
+    /**
+     * 把会话(包括socket)迁移到其他poller线程，必须在当前poller线程调用
+     * 在onRecv中调用时，迁移在onRecv返回后进行；迁移开始后本线程不能再访问该会话
+     * @param poller 目标poller线程
+     * @param cb 迁移完成后在新poller线程执行的回调，迁移失败时在原poller线程执行，会话对象被销毁前一定会被执行
+     * @return false代表该会话不支持迁移，此时cb不会被执行
+     */
+    bool moveToPoller(const EventPoller::Ptr &poller, function<void()> cb);
+
+    /**
+     * 任务切换到会话所属poller线程执行
+     * 任务执行前会话可能已经迁移到其他poller线程，此时任务转发到新线程执行
+     */
+    Task::Ptr async(TaskIn task, bool may_sync = true) override;
+    Task::Ptr async_first(TaskIn task, bool may_sync = true) override;
+
+private:
+    //包装任务，执行时如果会话已经迁移则转发到新poller线程
+    TaskIn wrapTask(TaskIn task);
+
+private:
+    friend class TcpServer;
+    //TcpServer通过该函数触发onRecv，并在onRecv返回后执行其中请求的迁移
+    void onRecv_l(const Buffer::Ptr &buf);
+
+private:
+    //TcpServer开启会话迁移(enableSessionMove)时设置的迁移函数，未设置时会话不支持迁移
+    function<bool(const EventPoller::Ptr &poller, function<void()> cb)> _on_move;
+    //是否正在执行onRecv
+    bool _in_recv = false;
+    //onRecv中请求的迁移，onRecv返回后执行
+    EventPoller::Ptr _move_poller;
+    function<void()> _move_cb;
 };
 
 //通过该模板可以让TCP服务器快速支持TLS
@@ -81,6 +115,12 @@ public:
         _ssl_box.setOnDecData([&](const Buffer::Ptr &buf) {
             public_onRecv(buf);
         });
+        _ssl_box.setOnKTLS([&]() {
+            return public_ktls_fd();
+        });
+        _ssl_box.setOnError([&](const string &err) {
+            public_shutdown(err);
+        });
     }
 
     ~TcpSessionWithSSL() override{
@@ -100,6 +140,16 @@ public:
         TcpSessionType::send(std::move(const_cast<Buffer::Ptr &>(buf)));
     }
 
+    inline void public_shutdown(const string &err) {
+        TcpSessionType::shutdown(SockException(Err_other, err));
+    }
+
+    inline int public_ktls_fd() {
+        auto &sock = TcpSessionType::getSock();
+        //发送缓存中还有未写入内核的密文时不能开启kTLS，否则这些密文会被内核再次加密
+        return sock && !sock->getSendBufferBytes() ? sock->rawFD() : -1;
+    }
+
 protected:
     ssize_t send(Buffer::Ptr buf) override {
         auto size = buf->size();
@@ -72,14 +72,48 @@ int SockUtil::setNoDelay(int sockFd, bool on) {
     return ret;
 }
 
-int SockUtil::setReuseable(int sockFd, bool on) {
+int SockUtil::setNotSentLowat(int sockFd, int bytes) {
+#if defined(TCP_NOTSENT_LOWAT)
+    int ret = setsockopt(sockFd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, (char *)&bytes, static_cast<socklen_t>(sizeof(bytes)));
+    if (ret == -1) {
+        TraceL << "设置 TCP_NOTSENT_LOWAT 失败!";
+    }
+    return ret;
+#else
+    return -1;
+#endif
+}
+
+int SockUtil::setReuseable(int sockFd, bool on, bool reusePort) {
     int opt = on ? 1 : 0;
     int ret = setsockopt(sockFd, SOL_SOCKET, SO_REUSEADDR, (char *)&opt, static_cast<socklen_t>(sizeof(opt)));
     if (ret == -1) {
         TraceL << "设置 SO_REUSEADDR 失败!";
+        return ret;
+    }
+#if defined(SO_REUSEPORT)
+    if (reusePort) {
+        ret = setsockopt(sockFd, SOL_SOCKET, SO_REUSEPORT, (char *)&opt, static_cast<socklen_t>(sizeof(opt)));
+        if (ret == -1) {
+            TraceL << "设置 SO_REUSEPORT 失败!";
+        }
+    }
+#endif
+    return ret;
+}
+
+int SockUtil::setIncomingCpu(int sockFd, int cpu) {
+#if defined(SO_INCOMING_CPU)
+    int ret = setsockopt(sockFd, SOL_SOCKET, SO_INCOMING_CPU, (char *)&cpu, static_cast<socklen_t>(sizeof(cpu)));
+    if (ret == -1) {
+        TraceL << "设置 SO_INCOMING_CPU 失败!";
     }
     return ret;
+#else
+    return -1;
+#endif
 }
+
 int SockUtil::setBroadcast(int sockFd, bool on) {
     int opt = on ? 1 : 0;
     int ret = setsockopt(sockFd, SOL_SOCKET, SO_BROADCAST, (char *)&opt,static_cast<socklen_t>(sizeof(opt)));
@@ -287,14 +321,14 @@ int SockUtil::connect(const char *host, uint16_t port,bool bAsync,const char *lo
     return -1;
 }
 
-int SockUtil::listen(const uint16_t port, const char* localIp, int backLog) {
+int SockUtil::listen(const uint16_t port, const char* localIp, int backLog, bool reusePort) {
     int sockfd = -1;
     if ((sockfd = (int)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) == -1) {
         WarnL << "创建套接字失败:" << get_uv_errmsg(true);
         return -1;
     }
 
-    setReuseable(sockfd);
+    setReuseable(sockfd, true, reusePort);
     setNoBlocked(sockfd);
     setCloExec(sockfd);
 
@@ -545,14 +579,14 @@ int SockUtil::bindSock(int sockFd,const char *ifr_ip,uint16_t port){
     return 0;
 }
 
-int SockUtil::bindUdpSock(const uint16_t port, const char* localIp) {
+int SockUtil::bindUdpSock(const uint16_t port, const char* localIp, bool reusePort) {
     int sockfd = -1;
     if ((sockfd = (int)socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
         WarnL << "创建套接字失败:" << get_uv_errmsg(true);
         return -1;
     }
 
-    setReuseable(sockfd);
+    setReuseable(sockfd, true, reusePort);
     setNoSigpipe(sockfd);
     setNoBlocked(sockfd);
     setSendBuf(sockfd);
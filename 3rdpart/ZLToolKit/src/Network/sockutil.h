@@ -68,17 +68,19 @@ public:
      * @param port 监听的本地端口
      * @param localIp 绑定的本地网卡ip
      * @param backLog accept列队长度
+     * @param reusePort 是否开启SO_REUSEPORT，开启后多个监听socket可以绑定同一端口，由内核分配新连接
      * @return -1代表失败，其他为socket fd号
      */
-    static int listen(const uint16_t port, const char *localIp = "0.0.0.0", int backLog = 1024);
+    static int listen(const uint16_t port, const char *localIp = "0.0.0.0", int backLog = 1024, bool reusePort = false);
 
     /**
      * 创建udp套接字
      * @param port 监听的本地端口
      * @param localIp 绑定的本地网卡ip
+     * @param reusePort 是否开启SO_REUSEPORT，开启后多个socket可以绑定同一端口，由内核分流
      * @return -1代表失败，其他为socket fd号
      */
-    static int bindUdpSock(const uint16_t port, const char *localIp = "0.0.0.0");
+    static int bindUdpSock(const uint16_t port, const char *localIp = "0.0.0.0", bool reusePort = false);
 
     /**
      * 绑定socket fd至某个网卡和端口
@@ -97,6 +99,15 @@ public:
      */
     static int setNoDelay(int sock, bool on = true);
 
+    /**
+     * 设置TCP_NOTSENT_LOWAT，内核中未发送数据超过该字节数时socket不可写，
+     * 这样待发送数据会积压在应用层，可以限制内核socket内存并在应用层丢弃过期数据
+     * @param sock socket fd号
+     * @param bytes 水位字节数
+     * @return 0代表成功，-1为失败
+     */
+    static int setNotSentLowat(int sock, int bytes);
+
     /**
      * 写socket不触发SIG_PIPE信号(貌似只有mac有效)
      * @param sock socket fd号
@@ -134,9 +145,19 @@ public:
      * 设置后续可绑定复用端口(处于TIME_WAITE状态)
      * @param sock socket fd号
      * @param on 是否开启该特性
+     * @param reusePort 是否同时设置SO_REUSEPORT
+     * @return 0代表成功，-1为失败
+     */
+    static int setReuseable(int sock, bool on = true, bool reusePort = false);
+
+    /**
+     * 设置SO_INCOMING_CPU，在SO_REUSEPORT监听组中，内核优先把在该cpu上处理的新连接分配给本socket
+     * 仅linux下有效
+     * @param sock socket fd号
+     * @param cpu cpu核心序号
      * @return 0代表成功，-1为失败
      */
-    static int setReuseable(int sock, bool on = true);
+    static int setIncomingCpu(int sock, int cpu);
 
     /**
      * 运行发送或接收udp广播信息
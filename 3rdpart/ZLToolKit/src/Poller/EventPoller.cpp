@@ -11,6 +11,7 @@
 #include <fcntl.h>
 #include <string.h>
 #include <list>
+#include <chrono>
 #include "SelectWrap.h"
 #include "EventPoller.h"
 #include "Util/util.h"
@@ -42,6 +43,11 @@
 
 namespace toolkit {
 
+//高精度的单调时间，用于统计事件循环耗时，单位微秒
+static inline uint64_t getSteadyMicrosecond() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 EventPoller &EventPoller::Instance() {
     return *(EventPollerPool::Instance().getFirstPoller());
 }
@@ -197,12 +203,13 @@ Task::Ptr EventPoller::async_l(TaskIn task,bool may_sync, bool first) {
     }
 
     auto ret = std::make_shared<Task>(std::move(task));
+    auto stamp = getSteadyMicrosecond();
     {
         lock_guard<mutex> lck(_mtx_task);
         if (first) {
-            _list_task.emplace_front(ret);
+            _list_task.emplace_front(stamp, ret);
         } else {
-            _list_task.emplace_back(ret);
+            _list_task.emplace_back(stamp, ret);
         }
     }
     //写数据到管道,唤醒主线程
@@ -231,9 +238,11 @@ inline void EventPoller::onPipeEvent() {
         _list_swap.swap(_list_task);
     }
 
-    _list_swap.for_each([&](const Task::Ptr &task) {
+    _list_swap.for_each([&](const std::pair<uint64_t, Task::Ptr> &pr) {
+        auto now = getSteadyMicrosecond();
+        _task_delay.input(now > pr.first ? now - pr.first : 0);
         try {
-            (*task)();
+            (*pr.second)();
         } catch (ExitException &) {
             _exit_flag = true;
         } catch (std::exception &ex) {
@@ -259,6 +268,34 @@ BufferRaw::Ptr EventPoller::getSharedBuffer() {
     return ret;
 }
 
+int EventPoller::getCpuIndex() const {
+    return _cpu_index;
+}
+
+void EventPoller::addAcceptCount() {
+    _accept_count.fetch_add(1, memory_order_relaxed);
+}
+
+uint64_t EventPoller::getAcceptCount() const {
+    return _accept_count.load(memory_order_relaxed);
+}
+
+const Histogram &EventPoller::getLoopTime() const {
+    return _loop_time;
+}
+
+const Histogram &EventPoller::getTaskDelay() const {
+    return _task_delay;
+}
+
+const Histogram &EventPoller::getTimerLate() const {
+    return _timer_late;
+}
+
+const Histogram &EventPoller::getWaitEvents() const {
+    return _wait_events;
+}
+
 //static
 EventPoller::Ptr EventPoller::getCurrentPoller(){
     lock_guard<mutex> lck(s_all_poller_mtx);
@@ -272,6 +309,11 @@ EventPoller::Ptr EventPoller::getCurrentPoller(){
 void EventPoller::runLoop(bool blocked,bool regist_self) {
     if (blocked) {
         ThreadPool::setPriority(_priority);
+        auto cpu_index = _cpu_index.load();
+        if (cpu_index >= 0 && !ThreadPool::setAffinity(cpu_index)) {
+            WarnL << "绑定cpu核心" << cpu_index << "失败";
+            _cpu_index = -1;
+        }
         lock_guard<mutex> lck(_mtx_runing);
         _loop_thread_id = this_thread::get_id();
         if (regist_self) {
@@ -281,13 +323,18 @@ void EventPoller::runLoop(bool blocked,bool regist_self) {
         _sem_run_started.post();
         _exit_flag = false;
         uint64_t minDelay;
+        //本次事件循环迭代开始执行的时间
+        uint64_t wake_time = getSteadyMicrosecond();
 #if defined(HAS_EPOLL)
         struct epoll_event events[EPOLL_SIZE];
         while (!_exit_flag) {
             minDelay = getMinDelay();
+            _loop_time.input(getSteadyMicrosecond() - wake_time);
             startSleep();//用于统计当前线程负载情况
             int ret = epoll_wait(_epoll_fd, events, EPOLL_SIZE, minDelay ? minDelay : -1);
             sleepWakeUp();//用于统计当前线程负载情况
+            wake_time = getSteadyMicrosecond();
+            _wait_events.input(ret > 0 ? ret : 0);
             if (ret <= 0) {
                 //超时或被打断
                 continue;
@@ -338,9 +385,12 @@ void EventPoller::runLoop(bool blocked,bool regist_self) {
                 }
             }
 
+            _loop_time.input(getSteadyMicrosecond() - wake_time);
             startSleep();//用于统计当前线程负载情况
             ret = zl_select(max_fd + 1, &set_read, &set_write, &set_err, minDelay ? &tv : NULL);
             sleepWakeUp();//用于统计当前线程负载情况
+            wake_time = getSteadyMicrosecond();
+            _wait_events.input(ret > 0 ? ret : 0);
 
             if (ret <= 0) {
                 //超时或被打断
@@ -386,6 +436,8 @@ uint64_t EventPoller::flushDelayTask(uint64_t now_time) {
 
     for (auto it = task_copy.begin(); it != task_copy.end() && it->first <= now_time; it = task_copy.erase(it)) {
         //已到期的任务
+        auto now_usec = getCurrentMicrosecond();
+        _timer_late.input(now_usec > it->first * 1000 ? now_usec - it->first * 1000 : 0);
         try {
             auto next_delay = (*(it->second))();
             if (next_delay) {
@@ -437,6 +489,7 @@ DelayTask::Ptr EventPoller::doDelayTask(uint64_t delayMS, function<uint64_t()> t
 ///////////////////////////////////////////////
 
 int s_pool_size = 0;
+bool s_enable_cpu_affinity = false;
 
 INSTANCE_IMP(EventPollerPool);
 
@@ -458,18 +511,27 @@ void EventPollerPool::preferCurrentThread(bool flag){
 
 EventPollerPool::EventPollerPool(){
     auto size = s_pool_size > 0 ? s_pool_size : thread::hardware_concurrency();
-    createThreads([]() {
+    auto cpus = thread::hardware_concurrency();
+    int index = 0;
+    createThreads([&]() {
         EventPoller::Ptr ret(new EventPoller);
+        if (s_enable_cpu_affinity && cpus) {
+            ret->_cpu_index = index++ % cpus;
+        }
         ret->runLoop(false, true);
         return ret;
     }, size);
-    InfoL << "创建EventPoller个数:" << size;
+    InfoL << "创建EventPoller个数:" << size << (s_enable_cpu_affinity ? ", 已绑定cpu核心" : "");
 }
 
 void EventPollerPool::setPoolSize(int size) {
     s_pool_size = size;
 }
 
+void EventPollerPool::enableCpuAffinity(bool enable) {
+    s_enable_cpu_affinity = enable;
+}
+
 
 }  // namespace toolkit
 
@@ -12,6 +12,7 @@
 #define EventPoller_h
 
 #include <mutex>
+#include <atomic>
 #include <thread>
 #include <string>
 #include <functional>
@@ -21,6 +22,7 @@
 #include "Util/logger.h"
 #include "Util/util.h"
 #include "Util/List.h"
+#include "Util/Histogram.h"
 #include "Thread/TaskExecutor.h"
 #include "Thread/ThreadPool.h"
 #include "Network/Buffer.h"
@@ -122,6 +124,41 @@ public:
      */
     BufferRaw::Ptr getSharedBuffer();
 
+    /**
+     * 获取轮询线程绑定的cpu核心序号，未绑定时返回-1
+     */
+    int getCpuIndex() const;
+
+    /**
+     * 累加本线程accept的tcp连接数
+     */
+    void addAcceptCount();
+
+    /**
+     * 获取本线程累计accept的tcp连接数，可用于观察新连接在各线程间的分布是否均衡
+     */
+    uint64_t getAcceptCount() const;
+
+    /**
+     * 事件循环每次迭代的执行耗时(不含休眠)，单位微秒
+     */
+    const Histogram &getLoopTime() const;
+
+    /**
+     * 跨线程切换过来的任务从入列到开始执行的延时，单位微秒
+     */
+    const Histogram &getTaskDelay() const;
+
+    /**
+     * 定时任务实际执行时间相对预定时间的滞后，单位微秒
+     */
+    const Histogram &getTimerLate() const;
+
+    /**
+     * 每次epoll_wait或select返回的事件个数
+     */
+    const Histogram &getWaitEvents() const;
+
 private:
     /**
      * 本对象只允许在EventPollerPool中构造
@@ -185,6 +222,10 @@ private:
     weak_ptr<BufferRaw> _shared_buffer;
     //线程优先级
     ThreadPool::Priority _priority;
+    //轮询线程绑定的cpu核心，-1为不绑定；绑定失败时在轮询线程中修改，其他线程可能同时读取
+    atomic<int> _cpu_index{-1};
+    //本线程累计accept的tcp连接数
+    atomic<uint64_t> _accept_count{0};
     //正在运行事件循环时该锁处于被锁定状态
     mutex _mtx_runing;
     //执行事件循环的线程
@@ -196,9 +237,15 @@ private:
 
     //内部事件管道
     PipeWrap _pipe;
-    //从其他线程切换过来的任务
+    //从其他线程切换过来的任务及其入列时间(微秒)
     mutex _mtx_task;
-    List<Task::Ptr> _list_task;
+    List<std::pair<uint64_t, Task::Ptr> > _list_task;
+
+    //事件循环耗时统计
+    Histogram _loop_time;
+    Histogram _task_delay;
+    Histogram _timer_late;
+    Histogram _wait_events;
 
     //保持日志可用
     Logger::Ptr _logger;
@@ -241,6 +288,13 @@ public:
      */
     static void setPoolSize(int size = 0);
 
+    /**
+     * 设置是否把EventPoller线程依次绑定到各个cpu核心，在EventPollerPool单例创建前有效
+     * 绑定后TcpServer在SO_REUSEPORT模式下会按cpu核心设置SO_INCOMING_CPU，使新连接在收包的cpu上accept
+     * @param enable 是否绑定
+     */
+    static void enableCpuAffinity(bool enable);
+
     /**
      * 获取第一个实例
      * @return
@@ -12,6 +12,8 @@
 #define ZLTOOLKIT_TASKEXECUTOR_H
 
 #include <memory>
+#include <atomic>
+#include <algorithm>
 #include <functional>
 #include "Util/List.h"
 #include "Util/util.h"
@@ -23,18 +25,19 @@ namespace toolkit {
 
 /**
  * cpu负载计算器
+ * 把时间划分为固定个数的桶，每个桶记录该时间段内的运行时长，按桶的新旧程度指数衰减后计算负载率；
+ * 统计与查询都是无锁的，也不会分配内存
  */
 class ThreadLoadCounter {
 public:
     /**
      * 构造函数
-     * @param max_size 统计样本数量
+     * @param max_size 统计样本数量，已不再使用，保留该参数是为了兼容老代码
      * @param max_usec 统计时间窗口,亦即最近{max_usec}的cpu负载率
      */
     ThreadLoadCounter(uint64_t max_size,uint64_t max_usec){
-        _last_sleep_time = _last_wake_time = getCurrentMicrosecond();
-        _max_size = max_size;
-        _max_usec = max_usec;
+        _bucket_usec = std::max<uint64_t>(max_usec / kBucketCount, 1);
+        _last_time = getCurrentMicrosecond();
     }
     ~ThreadLoadCounter(){}
 
@@ -42,38 +45,18 @@ public:
      * 线程进入休眠
      */
     void startSleep(){
-        lock_guard<mutex> lck(_mtx);
-
-        _sleeping = true;
-
         auto current_time = getCurrentMicrosecond();
-        auto run_time = current_time - _last_wake_time;
-        _last_sleep_time = current_time;
-
-        _time_list.emplace_back(run_time, false);
-
-        if(_time_list.size() > _max_size){
-            _time_list.pop_front();
-        }
+        addRunTime(_last_time.load(memory_order_relaxed), current_time);
+        _last_time.store(current_time, memory_order_relaxed);
+        _sleeping.store(true, memory_order_release);
     }
 
     /**
      * 休眠唤醒,结束休眠
      */
     void sleepWakeUp(){
-        lock_guard<mutex> lck(_mtx);
-
-        _sleeping = false;
-
-        auto current_time = getCurrentMicrosecond();
-        auto sleep_time = current_time - _last_sleep_time;
-        _last_wake_time = current_time;
-
-        _time_list.emplace_back(sleep_time, true);
-
-        if(_time_list.size() > _max_size){
-            _time_list.pop_front();
-        }
+        _last_time.store(getCurrentMicrosecond(), memory_order_relaxed);
+        _sleeping.store(false, memory_order_release);
     }
 
     /**
@@ -81,62 +64,77 @@ public:
      * @return 当前线程cpu使用率
      */
     int load(){
-        lock_guard<mutex> lck(_mtx);
-
-        uint64_t totalSleepTime = 0;
-        uint64_t totalRunTime = 0;
-
-        _time_list.for_each([&](const TimeRecord& rcd){
-            if(rcd._sleep){
-                totalSleepTime += rcd._time;
-            }else{
-                totalRunTime += rcd._time;
+        auto current_time = getCurrentMicrosecond();
+        auto sleeping = _sleeping.load(memory_order_acquire);
+        auto last_time = _last_time.load(memory_order_relaxed);
+        auto current_index = current_time / _bucket_usec;
+
+        double total_run = 0;
+        double total_time = 0;
+        double weight = 1;
+        for (uint64_t i = 0; i < kBucketCount && i <= current_index; ++i, weight *= kDecay) {
+            auto index = current_index - i;
+            auto begin = index * _bucket_usec;
+            auto end = std::min<uint64_t>(current_time, begin + _bucket_usec);
+            uint64_t run_time = 0;
+            auto &bucket = _buckets[index % kBucketCount];
+            if (bucket._index.load(memory_order_acquire) == index) {
+                run_time = bucket._run_time.load(memory_order_relaxed);
             }
-        });
-
-        if(_sleeping){
-            totalSleepTime += (getCurrentMicrosecond() - _last_sleep_time);
-        }else{
-            totalRunTime += (getCurrentMicrosecond() - _last_wake_time);
-        }
-
-        uint64_t totalTime = totalRunTime + totalSleepTime;
-
-        while((_time_list.size() != 0) && (totalTime > _max_usec || _time_list.size() > _max_size)){
-            TimeRecord &rcd = _time_list.front();
-            if(rcd._sleep){
-                totalSleepTime -= rcd._time;
-            }else{
-                totalRunTime -= rcd._time;
+            if (!sleeping && last_time < end) {
+                //正在运行中，尚未计入桶的运行时长
+                run_time += end - std::max<uint64_t>(last_time, begin);
             }
-            totalTime -= rcd._time;
-            _time_list.pop_front();
+            total_run += weight * std::min<uint64_t>(run_time, end - begin);
+            total_time += weight * (end - begin);
         }
-        if(totalTime == 0){
+        if (total_time <= 0) {
             return 0;
         }
-        return (int)(totalRunTime * 100 / totalTime);
+        return (int) (total_run * 100 / total_time);
     }
 
 private:
-    class TimeRecord {
-    public:
-        TimeRecord(uint64_t tm,bool slp){
-            _time = tm;
-            _sleep = slp;
+    //把[begin, end)时间段的运行时长累加到对应的桶
+    void addRunTime(uint64_t begin, uint64_t end) {
+        auto end_index = end / _bucket_usec;
+        if (end_index >= kBucketCount) {
+            //早于统计窗口的部分无需记录
+            begin = std::max<uint64_t>(begin, (end_index - kBucketCount + 1) * _bucket_usec);
         }
+        while (begin < end) {
+            auto index = begin / _bucket_usec;
+            auto bucket_end = std::min<uint64_t>(end, (index + 1) * _bucket_usec);
+            auto &bucket = _buckets[index % kBucketCount];
+            if (bucket._index.load(memory_order_relaxed) != index) {
+                //该桶记录的是上一轮的数据，重置之
+                bucket._run_time.store(0, memory_order_relaxed);
+                bucket._index.store(index, memory_order_release);
+            }
+            bucket._run_time.fetch_add(bucket_end - begin, memory_order_relaxed);
+            begin = bucket_end;
+        }
+    }
+
+private:
+    class Bucket {
     public:
-        uint64_t _time;
-        bool _sleep;
+        //桶对应的时间段序号，亦即起始时间除以桶时长
+        atomic<uint64_t> _index{(uint64_t) -1};
+        //该时间段内的运行时长
+        atomic<uint64_t> _run_time{0};
     };
+
+    //桶的个数
+    static constexpr uint64_t kBucketCount = 16;
+    //每早一个桶，权重衰减的比例
+    static constexpr double kDecay = 0.9;
+
 private:
-    uint64_t _last_sleep_time;
-    uint64_t _last_wake_time;
-    List<TimeRecord> _time_list;
-    bool _sleeping = true;
-    uint64_t _max_size;
-    uint64_t _max_usec;
-    mutex _mtx;
+    uint64_t _bucket_usec;
+    atomic<bool> _sleeping{true};
+    atomic<uint64_t> _last_time;
+    Bucket _buckets[kBucketCount];
 };
 
 class TaskCancelable : public noncopyable{
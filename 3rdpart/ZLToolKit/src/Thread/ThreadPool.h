@@ -100,6 +100,22 @@ public:
 #endif
     }
 
+    /**
+     * 绑定当前线程至指定cpu核心，仅linux下有效
+     * @param cpu cpu核心序号
+     * @return 是否成功
+     */
+    static bool setAffinity(int cpu) {
+#if defined(__linux__) && !defined(ANDROID)
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        CPU_SET(cpu, &mask);
+        return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+        return false;
+#endif
+    }
+
     void start() {
         if (_thread_num <= 0)
             return;
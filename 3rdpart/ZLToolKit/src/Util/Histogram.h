@@ -0,0 +1,168 @@
+﻿/*
+ * Copyright (c) 2016 The ZLToolKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLToolKit(https://github.com/xia-chu/ZLToolKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef UTIL_HISTOGRAM_H_
+#define UTIL_HISTOGRAM_H_
+
+#include <cmath>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+using namespace std;
+
+namespace toolkit {
+
+/**
+ * 对数分桶直方图(HDR风格)，用于统计耗时、个数等数值的分布
+ * 每个2的幂区间再均分为4个子桶，分位数的相对误差不超过25%
+ * 只允许单个线程写入(写入无锁且不使用原子读改写指令)，可在任意线程读取近似快照
+ */
+class Histogram {
+public:
+    //每个2的幂区间的子桶个数为1 << kSubBits
+    static constexpr size_t kSubBits = 2;
+    static constexpr size_t kSubCount = 1 << kSubBits;
+    //覆盖全部uint64_t取值所需的桶个数
+    static constexpr size_t kBucketCount = (64 - kSubBits + 1) * kSubCount;
+
+    Histogram() = default;
+    ~Histogram() = default;
+
+    /**
+     * 写入一个数值，只能在单个线程中调用
+     */
+    void input(uint64_t value) {
+        increase(_buckets[bucketIndex(value)], 1);
+        increase(_count, 1);
+        increase(_sum, value);
+        if (value > _max.load(memory_order_relaxed)) {
+            _max.store(value, memory_order_relaxed);
+        }
+    }
+
+    /**
+     * 写入的数值个数
+     */
+    uint64_t count() const {
+        return _count.load(memory_order_relaxed);
+    }
+
+    /**
+     * 写入的最大值
+     */
+    uint64_t maxValue() const {
+        return _max.load(memory_order_relaxed);
+    }
+
+    /**
+     * 写入数值的平均值
+     */
+    uint64_t meanValue() const {
+        auto count = this->count();
+        return count ? _sum.load(memory_order_relaxed) / count : 0;
+    }
+
+    /**
+     * 获取分位数，返回所在桶的上边界(不超过最大值)
+     * @param percent 百分比，范围为 0 ~ 100，例如99.9
+     */
+    uint64_t percentile(double percent) const {
+        uint64_t counts[kBucketCount];
+        uint64_t total = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            counts[i] = _buckets[i].load(memory_order_relaxed);
+            total += counts[i];
+        }
+        if (!total) {
+            return 0;
+        }
+        //第rank个数值(从1开始)所在的桶
+        auto rank = (uint64_t) ceil(total * percent / 100);
+        rank = rank < 1 ? 1 : (rank > total ? total : rank);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                auto high = bucketHigh(i);
+                auto max_value = maxValue();
+                return high < max_value ? high : max_value;
+            }
+        }
+        return maxValue();
+    }
+
+    /**
+     * 遍历所有非空的桶
+     * @param cb 参数依次为桶的下边界、上边界(包含)、数值个数
+     */
+    void for_each(const function<void(uint64_t low, uint64_t high, uint64_t count)> &cb) const {
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            auto count = _buckets[i].load(memory_order_relaxed);
+            if (count) {
+                cb(bucketLow(i), bucketHigh(i), count);
+            }
+        }
+    }
+
+private:
+    static void increase(atomic<uint64_t> &counter, uint64_t value) {
+        //单线程写入，无需fetch_add
+        counter.store(counter.load(memory_order_relaxed) + value, memory_order_relaxed);
+    }
+
+    //最高有效位的位置，value不能为0
+    static size_t highestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        size_t ret = 0;
+        while (value >>= 1) {
+            ++ret;
+        }
+        return ret;
+#endif
+    }
+
+    static size_t bucketIndex(uint64_t value) {
+        if (value < kSubCount) {
+            return (size_t) value;
+        }
+        auto bit = highestBit(value);
+        auto sub = (size_t) (value >> (bit - kSubBits)) & (kSubCount - 1);
+        return (bit - kSubBits + 1) * kSubCount + sub;
+    }
+
+    static uint64_t bucketLow(size_t index) {
+        if (index < kSubCount) {
+            return index;
+        }
+        auto bit = index / kSubCount + kSubBits - 1;
+        auto sub = (uint64_t) (index % kSubCount);
+        return (1ULL << bit) | (sub << (bit - kSubBits));
+    }
+
+    static uint64_t bucketHigh(size_t index) {
+        if (index < kSubCount) {
+            return index;
+        }
+        auto bit = index / kSubCount + kSubBits - 1;
+        return bucketLow(index) + (1ULL << (bit - kSubBits)) - 1;
+    }
+
+private:
+    atomic<uint64_t> _count{0};
+    atomic<uint64_t> _sum{0};
+    atomic<uint64_t> _max{0};
+    atomic<uint64_t> _buckets[kBucketCount] = {};
+};
+
+} /* namespace toolkit */
+#endif /* UTIL_HISTOGRAM_H_ */
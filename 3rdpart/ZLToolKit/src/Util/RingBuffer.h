@@ -71,6 +71,17 @@ public:
         }
     }
 
+    /**
+     * 设置读取回调，回调参数带有该数据是否为关键帧(gop起始)的标记
+     * 设置后setReadCB设置的回调将不再触发
+     */
+    void setReadCBWithKey(const function<void(const T &, bool)> &cb) {
+        _read_key_cb = cb;
+        if (cb) {
+            flushGop();
+        }
+    }
+
     void setDetachCB(const function<void()> &cb) {
         if (!cb) {
             _detach_cb = []() {};
@@ -81,6 +92,10 @@ public:
 
 private:
     void onRead(const T &data, bool is_key) {
+        if (_read_key_cb) {
+            _read_key_cb(data, is_key);
+            return;
+        }
         _read_cb(data);
     }
 
@@ -103,6 +118,7 @@ private:
     shared_ptr<_RingStorage<T> > _storage;
     function<void(void)> _detach_cb = []() {};
     function<void(const T &)> _read_cb = [](const T &) {};
+    function<void(const T &, bool)> _read_key_cb;
 };
 
 template<typename T>
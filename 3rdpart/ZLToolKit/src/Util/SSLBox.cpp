@@ -48,6 +48,22 @@
 #endif //defined(_WIN64)
 #endif // defined(_WIN32)
 
+#if defined(__linux__) && OPENSSL_VERSION_NUMBER >= 0x10101000L
+#include <netinet/tcp.h>
+#include <linux/tls.h>
+#include <openssl/kdf.h>
+#if defined(TLS_TX) && defined(TLS_1_3_VERSION) && defined(TLS_CIPHER_AES_GCM_256)
+//内核头文件以及openssl版本支持kTLS
+#define ENABLE_KTLS
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#endif //defined(TLS_TX)
+#endif //defined(__linux__)
+
 #endif //defined(ENABLE_OPENSSL)
 
 #ifdef SSL_CTRL_SET_TLSEXT_HOSTNAME
@@ -68,6 +84,10 @@ void SSL_Initor::ignoreInvalidCertificate(bool ignore) {
     s_ignore_invalid_cer = ignore;
 }
 
+void SSL_Initor::enableKTLS(bool enable) {
+    _enable_ktls = enable;
+}
+
 SSL_Initor::SSL_Initor() {
 #if defined(ENABLE_OPENSSL)
     SSL_library_init();
@@ -210,6 +230,10 @@ void SSL_Initor::setupCtx(SSL_CTX *ctx) {
     SSL_CTX_set_verify_depth(ctx, 9);
     SSL_CTX_set_mode(ctx, SSL_MODE_AUTO_RETRY);
     SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+#if defined(ENABLE_KTLS)
+    //用于获取tls1.3的traffic secret
+    SSL_CTX_set_keylog_callback(ctx, SSL_Box::onKeyLog);
+#endif //defined(ENABLE_KTLS)
     SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, [](int ok, X509_STORE_CTX *pStore) {
         if (!ok) {
             int depth = X509_STORE_CTX_get_error_depth(pStore);
@@ -288,6 +312,66 @@ string SSL_Initor::defaultVhost(bool server_mode) {
 
 ////////////////////////////////////////////////////SSL_Box////////////////////////////////////////////////////////////
 
+#if defined(ENABLE_KTLS)
+//SSL对象上保存SSL_Box指针的索引
+static int getSSLBoxIndex() {
+    static int s_index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return s_index;
+}
+
+//tls1.3 HKDF-Expand-Label(secret, label, "", size)
+static bool expandLabel(const EVP_MD *md, const string &secret, const string &label, uint8_t *out, size_t size) {
+    string info;
+    info.push_back((char) (size >> 8));
+    info.push_back((char) (size & 0xFF));
+    info.push_back((char) (label.size() + 6));
+    info.append("tls13 ").append(label);
+    info.push_back(0);
+    std::shared_ptr<EVP_PKEY_CTX> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr), EVP_PKEY_CTX_free);
+    return ctx && EVP_PKEY_derive_init(ctx.get()) > 0
+           && EVP_PKEY_CTX_hkdf_mode(ctx.get(), EVP_PKEY_HKDEF_MODE_EXPAND_ONLY) > 0
+           && EVP_PKEY_CTX_set_hkdf_md(ctx.get(), md) > 0
+           && EVP_PKEY_CTX_set1_hkdf_key(ctx.get(), (const uint8_t *) secret.data(), (int) secret.size()) > 0
+           && EVP_PKEY_CTX_add1_hkdf_info(ctx.get(), (const uint8_t *) info.data(), (int) info.size()) > 0
+           && EVP_PKEY_derive(ctx.get(), out, &size) > 0;
+}
+
+//tls1.2 key_block = PRF(master_secret, "key expansion", server_random + client_random)
+static bool makeKeyBlock(SSL *ssl, const EVP_MD *md, uint8_t *out, size_t size) {
+    uint8_t master[SSL_MAX_MASTER_KEY_LENGTH];
+    auto master_len = SSL_SESSION_get_master_key(SSL_get_session(ssl), master, sizeof(master));
+    string seed = "key expansion";
+    auto label_len = seed.size();
+    seed.resize(label_len + 2 * SSL3_RANDOM_SIZE);
+    SSL_get_server_random(ssl, (uint8_t *) &seed[label_len], SSL3_RANDOM_SIZE);
+    SSL_get_client_random(ssl, (uint8_t *) &seed[label_len + SSL3_RANDOM_SIZE], SSL3_RANDOM_SIZE);
+    std::shared_ptr<EVP_PKEY_CTX> ctx(EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr), EVP_PKEY_CTX_free);
+    bool ret = master_len && ctx && EVP_PKEY_derive_init(ctx.get()) > 0
+               && EVP_PKEY_CTX_set_tls1_prf_md(ctx.get(), md) > 0
+               && EVP_PKEY_CTX_set1_tls1_prf_secret(ctx.get(), master, (int) master_len) > 0
+               && EVP_PKEY_CTX_add1_tls1_prf_seed(ctx.get(), (const uint8_t *) seed.data(), (int) seed.size()) > 0
+               && EVP_PKEY_derive(ctx.get(), out, &size) > 0;
+    OPENSSL_cleanse(master, sizeof(master));
+    return ret;
+}
+
+//设置内核发送方向的密钥
+template<typename INFO>
+static bool setTxCryptoInfo(int fd, uint16_t version, uint16_t cipher_type, const uint8_t *key, const uint8_t *salt, const uint8_t *iv, const uint8_t *rec_seq) {
+    INFO info;
+    memset(&info, 0, sizeof(info));
+    info.info.version = version;
+    info.info.cipher_type = cipher_type;
+    memcpy(info.key, key, sizeof(info.key));
+    memcpy(info.salt, salt, sizeof(info.salt));
+    memcpy(info.iv, iv, sizeof(info.iv));
+    memcpy(info.rec_seq, rec_seq, sizeof(info.rec_seq));
+    bool ret = 0 == setsockopt(fd, SOL_TLS, TLS_TX, &info, sizeof(info));
+    OPENSSL_cleanse(&info, sizeof(info));
+    return ret;
+}
+#endif //defined(ENABLE_KTLS)
+
 SSL_Box::~SSL_Box() {}
 
 SSL_Box::SSL_Box(bool server_mode, bool enable, int buff_size) {
@@ -301,6 +385,16 @@ SSL_Box::SSL_Box(bool server_mode, bool enable, int buff_size) {
         _write_bio = BIO_new(BIO_s_mem());
         SSL_set_bio(_ssl.get(), _read_bio, _write_bio);
         _server_mode ? SSL_set_accept_state(_ssl.get()) : SSL_set_connect_state(_ssl.get());
+#if defined(ENABLE_KTLS)
+        if (SSL_Initor::Instance()._enable_ktls) {
+            SSL_set_ex_data(_ssl.get(), getSSLBoxIndex(), this);
+            //重协商以及tls1.3的session ticket会占用发送序列号，开启kTLS时禁用
+            SSL_set_options(_ssl.get(), SSL_OP_NO_RENEGOTIATION);
+            if (_server_mode) {
+                SSL_set_num_tickets(_ssl.get(), 0);
+            }
+        }
+#endif //defined(ENABLE_KTLS)
     } else {
         WarnL << "ssl disabled!";
     }
@@ -312,6 +406,10 @@ SSL_Box::SSL_Box(bool server_mode, bool enable, int buff_size) {
 void SSL_Box::shutdown() {
 #if defined(ENABLE_OPENSSL)
     _buffer_send.clear();
+    if (_ktls_tx) {
+        //发送序列号由内核维护，openssl无法再发送close_notify
+        return;
+    }
     int ret = SSL_shutdown(_ssl.get());
     if (ret != 1) {
         ErrorL << "SSL shutdown failed:" << SSLUtil::getLastError();
@@ -360,6 +458,13 @@ void SSL_Box::onSend(const Buffer::Ptr &buffer) {
         return;
     }
 #if defined(ENABLE_OPENSSL)
+    if (_ktls_tx && _buffer_send.empty()) {
+        //明文直接交给内核加密
+        if (_on_enc) {
+            _on_enc(buffer);
+        }
+        return;
+    }
     if (!_server_mode && !_send_handshake) {
         _send_handshake = true;
         SSL_do_handshake(_ssl.get());
@@ -379,6 +484,22 @@ void SSL_Box::setOnEncData(const function<void(const Buffer::Ptr &)> &cb){
 
 void SSL_Box::flushWriteBio() {
 #if defined(ENABLE_OPENSSL)
+    if (_ktls_tx) {
+        auto pending = BIO_ctrl_pending(_write_bio);
+        if (!pending) {
+            return;
+        }
+        //发送序列号由内核维护，openssl产生的tls记录(比如回复对端的KeyUpdate或者alert)无法再发送，
+        //丢弃后tls状态已经错乱，只能断开连接
+        (void) BIO_reset(_write_bio);
+        _buffer_send.clear();
+        string err = StrPrinter << "tls record of " << pending << " bytes generated by openssl after kTLS enabled";
+        ErrorL << err;
+        if (_on_err) {
+            _on_err(err);
+        }
+        return;
+    }
     int total = 0;
     int nread = 0;
     auto buffer_bio = _buffer_pool.obtain();
@@ -455,6 +576,21 @@ void SSL_Box::flush() {
     });
 
     flushReadBio();
+    if (SSL_is_init_finished(_ssl.get()) && !_ktls_checked) {
+        //握手完成，先把握手数据发送出去，再尝试开启kTLS
+        flushWriteBio();
+        tryEnableKTLS();
+    }
+    if (_ktls_tx) {
+        flushWriteBio();
+        while (!_buffer_send.empty()) {
+            if (_on_enc) {
+                _on_enc(_buffer_send.front());
+            }
+            _buffer_send.pop_front();
+        }
+        return;
+    }
     if (!SSL_is_init_finished(_ssl.get()) || _buffer_send.empty()) {
         //ssl未握手结束或没有需要发送的数据
         flushWriteBio();
@@ -490,6 +626,105 @@ void SSL_Box::flush() {
 #endif //defined(ENABLE_OPENSSL)
 }
 
+void SSL_Box::setOnKTLS(const function<int()> &cb) {
+    _on_ktls = cb;
+}
+
+void SSL_Box::setOnError(const function<void(const string &err)> &cb) {
+    _on_err = cb;
+}
+
+bool SSL_Box::isKTLS() const {
+    return _ktls_tx;
+}
+
+void SSL_Box::onKeyLog(const SSL *ssl, const char *line) {
+#if defined(ENABLE_KTLS)
+    auto box = (SSL_Box *) SSL_get_ex_data(ssl, getSSLBoxIndex());
+    if (!box) {
+        return;
+    }
+    //格式为: <label> <client_random> <secret>
+    const char *label = box->_server_mode ? "SERVER_TRAFFIC_SECRET_0 " : "CLIENT_TRAFFIC_SECRET_0 ";
+    auto secret = strrchr(line, ' ');
+    if (strncmp(line, label, strlen(label)) || !secret) {
+        return;
+    }
+    box->_tx_secret.clear();
+    for (++secret; secret[0] && secret[1]; secret += 2) {
+        char hex[3] = {secret[0], secret[1], '\0'};
+        box->_tx_secret.push_back((char) strtol(hex, nullptr, 16));
+    }
+#endif //defined(ENABLE_KTLS)
+}
+
+void SSL_Box::tryEnableKTLS() {
+    _ktls_checked = true;
+#if defined(ENABLE_KTLS)
+    if (!_on_ktls || !SSL_Initor::Instance()._enable_ktls) {
+        return;
+    }
+    auto ssl = _ssl.get();
+    auto version = SSL_version(ssl);
+    auto cipher = SSL_get_current_cipher(ssl);
+    auto nid = SSL_CIPHER_get_cipher_nid(cipher);
+    auto md = SSL_CIPHER_get_handshake_digest(cipher);
+    size_t key_len = nid == NID_aes_128_gcm ? 16 : (nid == NID_aes_256_gcm ? 32 : 0);
+    if (!key_len || !md || (version != TLS1_2_VERSION && version != TLS1_3_VERSION)) {
+        DebugL << "kTLS not supported for " << SSL_get_version(ssl) << " " << SSL_CIPHER_get_name(cipher);
+        return;
+    }
+
+    uint8_t key[32];
+    uint8_t iv[12];
+    uint8_t rec_seq[8] = {0};
+    if (version == TLS1_3_VERSION) {
+        //应用数据从序列号0开始(已禁用session ticket)
+        bool ok = !_tx_secret.empty() && expandLabel(md, _tx_secret, "key", key, key_len) && expandLabel(md, _tx_secret, "iv", iv, sizeof(iv));
+        OPENSSL_cleanse(&_tx_secret[0], _tx_secret.size());
+        _tx_secret.clear();
+        if (!ok) {
+            WarnL << "derive tls1.3 traffic key failed:" << SSLUtil::getLastError();
+            return;
+        }
+    } else {
+        //key_block: client_write_key | server_write_key | client_write_IV | server_write_IV
+        uint8_t key_block[2 * 32 + 2 * 4];
+        if (!makeKeyBlock(ssl, md, key_block, 2 * key_len + 8)) {
+            WarnL << "derive tls1.2 key block failed:" << SSLUtil::getLastError();
+            return;
+        }
+        memcpy(key, key_block + (_server_mode ? key_len : 0), key_len);
+        memcpy(iv, key_block + 2 * key_len + (_server_mode ? 4 : 0), 4);
+        OPENSSL_cleanse(key_block, sizeof(key_block));
+        //Finished消息占用了序列号0
+        rec_seq[7] = 1;
+    }
+
+    int fd = _on_ktls();
+    bool ok = false;
+    if (fd != -1 && 0 == setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls"))) {
+        //tls1.2的显式nonce使用序列号，tls1.3的iv前4字节为salt
+        uint16_t kversion = version == TLS1_3_VERSION ? TLS_1_3_VERSION : TLS_1_2_VERSION;
+        const uint8_t *nonce = version == TLS1_3_VERSION ? iv + 4 : rec_seq;
+        if (key_len == 16) {
+            ok = setTxCryptoInfo<tls12_crypto_info_aes_gcm_128>(fd, kversion, TLS_CIPHER_AES_GCM_128, key, iv, nonce, rec_seq);
+        } else {
+            ok = setTxCryptoInfo<tls12_crypto_info_aes_gcm_256>(fd, kversion, TLS_CIPHER_AES_GCM_256, key, iv, nonce, rec_seq);
+        }
+    }
+    OPENSSL_cleanse(key, sizeof(key));
+    OPENSSL_cleanse(iv, sizeof(iv));
+    if (!ok) {
+        //内核未加载tls模块或不支持该加密套件，未设置密钥的tls ulp会透传数据，继续在用户态加密即可
+        DebugL << "kTLS unavailable, fallback to openssl:" << (fd == -1 ? "socket busy" : strerror(errno));
+        return;
+    }
+    _ktls_tx = true;
+    DebugL << "kTLS enabled: " << SSL_get_version(ssl) << " " << SSL_CIPHER_get_name(cipher);
+#endif //defined(ENABLE_KTLS)
+}
+
 bool SSL_Box::setHost(const char *host) {
     if(!_ssl) {
         return false;
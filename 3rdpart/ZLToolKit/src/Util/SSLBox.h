@@ -72,6 +72,13 @@ public:
      */
     bool trustCertificate(X509 *cer,bool server_mode = false);
 
+    /**
+     * 是否开启kTLS(内核tls)发送加密卸载，仅linux下有效
+     * 开启后服务器不再下发tls1.3 session ticket并禁止重协商，以便握手完成后能确定发送序列号
+     * @param enable 是否开启
+     */
+    void enableKTLS(bool enable = true);
+
 private:
     SSL_Initor();
     ~SSL_Initor();
@@ -129,12 +136,14 @@ private:
     map<string, std::shared_ptr<SSL_CTX>, less_nocase> _ctxs[2];
     map<string, std::shared_ptr<SSL_CTX>, less_nocase > _ctxs_wildcards[2];
     string _default_vhost[2];
+    bool _enable_ktls = false;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////
 
 class SSL_Box {
 public:
+    friend class SSL_Initor;
     SSL_Box(bool server_mode = true, bool enable = true, int buff_size = 32 * 1024);
     ~SSL_Box();
 
@@ -179,9 +188,33 @@ public:
      */
     bool setHost(const char *host);
 
+    /**
+     * 设置获取socket fd的回调，握手完成后会尝试把发送方向的加密交给内核(kTLS)，
+     * 回调返回-1(比如socket发送缓存中还有未写入内核的密文)时放弃开启，继续在用户态加密
+     * 接收方向的解密仍然由openssl完成：内存bio模式下客户端Finished之后的应用数据往往已经一并读入openssl，
+     * 无法确定交给内核时的接收序列号，而且内核收到非应用数据记录(alert、KeyUpdate)时普通recv会出错
+     * @param cb 回调对象
+     */
+    void setOnKTLS(const function<int()> &cb);
+
+    /**
+     * 设置出现不可恢复的ssl错误时的回调，回调中应该断开连接
+     * 比如开启kTLS后openssl仍然产生了需要发送的tls记录(回复对端的KeyUpdate或者alert)，
+     * 这些记录已无法发送，tls状态已经错乱
+     * @param cb 回调对象，参数为错误描述
+     */
+    void setOnError(const function<void(const string &err)> &cb);
+
+    /**
+     * 发送方向是否已经由内核加密
+     */
+    bool isKTLS() const;
+
 private:
     void flushWriteBio();
     void flushReadBio();
+    void tryEnableKTLS();
+    static void onKeyLog(const SSL *ssl, const char *line);
 
 private:
     bool _server_mode;
@@ -195,6 +228,13 @@ private:
     ResourcePool<BufferRaw> _buffer_pool;
     int _buff_size;
     bool _is_flush = false;
+    //kTLS相关
+    bool _ktls_tx = false;
+    bool _ktls_checked = false;
+    function<int()> _on_ktls;
+    function<void(const string &err)> _on_err;
+    //tls1.3本端发送方向的traffic secret，由keylog回调获取
+    string _tx_secret;
 };
 
 } /* namespace toolkit */
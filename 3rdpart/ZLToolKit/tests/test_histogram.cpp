@@ -0,0 +1,135 @@
+﻿/*
+ * Copyright (c) 2016 The ZLToolKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLToolKit(https://github.com/xia-chu/ZLToolKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <vector>
+#include <atomic>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Util/Histogram.h"
+#include "Thread/TaskExecutor.h"
+
+using namespace std;
+using namespace toolkit;
+
+static atomic<int> s_failed{0};
+
+#define CHECK(exp) \
+    do { \
+        if (!(exp)) { \
+            ErrorL << "check failed: " << #exp; \
+            ++s_failed; \
+        } \
+    } while (0)
+
+//获取每个数值所在桶的上下边界
+static map<uint64_t, pair<uint64_t, uint64_t> > bucketOf(const vector<uint64_t> &values) {
+    map<uint64_t, pair<uint64_t, uint64_t> > ret;
+    for (auto value : values) {
+        Histogram histogram;
+        histogram.input(value);
+        histogram.for_each([&](uint64_t low, uint64_t high, uint64_t count) {
+            CHECK(count == 1);
+            ret[value] = make_pair(low, high);
+        });
+    }
+    return ret;
+}
+
+static void checkBucket(map<uint64_t, pair<uint64_t, uint64_t> > &buckets, uint64_t value, uint64_t low, uint64_t high) {
+    auto &bucket = buckets[value];
+    if (bucket.first != low || bucket.second != high) {
+        ErrorL << "bucket of " << value << " is [" << bucket.first << ", " << bucket.second << "], expected [" << low << ", " << high << "]";
+        ++s_failed;
+    }
+}
+
+static void testBucket() {
+    auto buckets = bucketOf({0, 3, 4, 7, 8, 9, 10, 15, 16, 1000, 1023, 1024, UINT64_MAX});
+    //小于4的数值各占一个桶
+    checkBucket(buckets, 0, 0, 0);
+    checkBucket(buckets, 3, 3, 3);
+    //[4, 8)每个子桶宽度为1
+    checkBucket(buckets, 4, 4, 4);
+    checkBucket(buckets, 7, 7, 7);
+    //[8, 16)每个子桶宽度为2
+    checkBucket(buckets, 8, 8, 9);
+    checkBucket(buckets, 9, 8, 9);
+    checkBucket(buckets, 10, 10, 11);
+    checkBucket(buckets, 15, 14, 15);
+    checkBucket(buckets, 16, 16, 19);
+    //[512, 1024)每个子桶宽度为128
+    checkBucket(buckets, 1000, 896, 1023);
+    checkBucket(buckets, 1023, 896, 1023);
+    checkBucket(buckets, 1024, 1024, 1279);
+    //最后一个桶
+    checkBucket(buckets, UINT64_MAX, 0xE000000000000000ULL, UINT64_MAX);
+}
+
+static void testPercentile() {
+    Histogram histogram;
+    CHECK(histogram.percentile(50) == 0);
+    CHECK(histogram.count() == 0 && histogram.meanValue() == 0);
+
+    for (uint64_t i = 1; i <= 100; ++i) {
+        histogram.input(i);
+    }
+    CHECK(histogram.count() == 100);
+    CHECK(histogram.maxValue() == 100);
+    CHECK(histogram.meanValue() == 50);
+    //分位数返回所在桶的上边界
+    CHECK(histogram.percentile(0) == 1);
+    CHECK(histogram.percentile(1) == 1);
+    CHECK(histogram.percentile(50) == 55);
+    CHECK(histogram.percentile(90) == 95);
+    //上边界不超过最大值
+    CHECK(histogram.percentile(99) == 100);
+    CHECK(histogram.percentile(100) == 100);
+
+    uint64_t total = 0;
+    histogram.for_each([&](uint64_t low, uint64_t high, uint64_t count) {
+        CHECK(low <= high && count == (high > 100 ? 100 : high) - low + 1);
+        total += count;
+    });
+    CHECK(total == 100);
+}
+
+//一半时间运行、一半时间休眠，负载应该在50%左右
+static void testThreadLoad() {
+    ThreadLoadCounter counter(0, 1000 * 1000);
+    Ticker ticker;
+    while (ticker.elapsedTime() < 1500) {
+        counter.sleepWakeUp();
+        auto start = getCurrentMicrosecond();
+        while (getCurrentMicrosecond() - start < 10 * 1000);
+        counter.startSleep();
+        start = getCurrentMicrosecond();
+        while (getCurrentMicrosecond() - start < 10 * 1000) {
+            usleep(1000);
+        }
+    }
+    auto load = counter.load();
+    InfoL << "thread load: " << load;
+    CHECK(load >= 40 && load <= 60);
+}
+
+int main() {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    testBucket();
+    testPercentile();
+    testThreadLoad();
+
+    InfoL << "failed checks: " << s_failed;
+    return s_failed ? -1 : 0;
+}
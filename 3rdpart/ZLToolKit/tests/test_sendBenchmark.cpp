@@ -0,0 +1,124 @@
+﻿/*
+ * Copyright (c) 2016 The ZLToolKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLToolKit(https://github.com/xia-chu/ZLToolKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <signal.h>
+#include <atomic>
+#include <thread>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Network/Socket.h"
+#include "Network/sockutil.h"
+#include "Thread/semaphore.h"
+
+using namespace std;
+using namespace toolkit;
+
+//在socket所属poller线程中循环调用Socket::send，统计单核每秒能完成的send次数
+static void benchmark(size_t pkt_size, bool enable_mutex, int seconds) {
+    int listen_fd = SockUtil::listen(0, "127.0.0.1");
+    if (listen_fd == -1) {
+        return;
+    }
+    uint16_t port = SockUtil::get_local_port(listen_fd);
+
+    //接收线程，阻塞读取并丢弃数据
+    atomic<bool> exit_flag{false};
+    atomic<uint64_t> recv_bytes{0};
+    thread reader([&]() {
+        SockUtil::setNoBlocked(listen_fd, false);
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd == -1) {
+            return;
+        }
+        SockUtil::setNoBlocked(fd, false);
+        SockUtil::setRecvBuf(fd, 4 * 1024 * 1024);
+        char buf[64 * 1024];
+        while (!exit_flag) {
+            auto n = ::recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                break;
+            }
+            recv_bytes += n;
+        }
+        close(fd);
+    });
+
+    auto poller = EventPollerPool::Instance().getPoller();
+    auto sock = Socket::createSocket(poller, enable_mutex);
+    semaphore sem;
+    sock->connect("127.0.0.1", port, [&](const SockException &ex) {
+        if (ex) {
+            ErrorL << ex.what();
+        }
+        sem.post();
+    });
+    sem.wait();
+
+    uint64_t send_count = 0;
+    auto buffer = std::make_shared<BufferString>(string(pkt_size, 'a'));
+    //每批次发送的包数
+    static constexpr int kBatch = 64;
+    Ticker ticker;
+    shared_ptr<function<void()> > send_batch = std::make_shared<function<void()> >();
+    *send_batch = [&]() {
+        while (ticker.elapsedTime() < seconds * 1000) {
+            if (sock->isSocketBusy()) {
+                //socket写缓存满了，等待onFlush后继续发送
+                return;
+            }
+            for (int i = 0; i < kBatch; ++i) {
+                //前面的包只入列，最后一个包触发flush，与FlushPolicy合并写的行为一致
+                sock->send(buffer, nullptr, 0, i == kBatch - 1);
+            }
+            send_count += kBatch;
+        }
+        sock->setOnFlush(nullptr);
+        sem.post();
+    };
+    sock->setOnFlush([send_batch]() {
+        (*send_batch)();
+        return true;
+    });
+    poller->async([send_batch]() {
+        (*send_batch)();
+    });
+    sem.wait();
+
+    auto elapsed = ticker.elapsedTime() + 1;
+    InfoL << "pkt_size:" << pkt_size
+          << ", mutex:" << enable_mutex
+          << ", sends/s:" << send_count * 1000 / elapsed
+          << ", MB/s:" << recv_bytes.load() / 1024 / 1024 * 1000 / elapsed
+          << ", poller load:" << poller->load() << "%";
+
+    exit_flag = true;
+    poller->sync([&]() {
+        sock = nullptr;
+    });
+    reader.join();
+    close(listen_fd);
+}
+
+int main(int argc, char *argv[]) {
+    signal(SIGINT, [](int) {
+        exit(0);
+    });
+    //初始化日志系统
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+    EventPollerPool::setPoolSize(1);
+
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+    for (auto size : {188, 1400, 16 * 1024}) {
+        benchmark(size, false, seconds);
+        benchmark(size, true, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+﻿/*
+ * Copyright (c) 2016 The ZLToolKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLToolKit(https://github.com/xia-chu/ZLToolKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <thread>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Network/TcpServer.h"
+#include "Network/TcpSession.h"
+#include "Network/sockutil.h"
+
+using namespace std;
+using namespace toolkit;
+
+//迁移前在onRecv中发送的数据量，客户端此时不读取，所以迁移时这些数据仍在发送缓存中
+static constexpr size_t kSendBeforeMove = 8 * 1024 * 1024;
+//迁移完成后在新poller线程发送的数据量
+static constexpr size_t kSendAfterMove = 1024 * 1024;
+static constexpr size_t kBlockSize = 64 * 1024;
+
+static atomic<int> s_failed{0};
+static atomic<bool> s_moved{false};
+static atomic<bool> s_error{false};
+static atomic<size_t> s_task_done{0};
+
+#define CHECK(exp) \
+    do { \
+        if (!(exp)) { \
+            ErrorL << "check failed: " << #exp; \
+            ++s_failed; \
+        } \
+    } while (0)
+
+class MoveSession;
+static mutex s_mtx;
+static weak_ptr<MoveSession> s_session;
+static EventPoller::Ptr s_src;
+static EventPoller::Ptr s_dst;
+
+class MoveSession : public TcpSession {
+public:
+    MoveSession(const Socket::Ptr &sock) : TcpSession(sock) {}
+
+    void onRecv(const Buffer::Ptr &buf) override {
+        CHECK(getPoller()->isCurrentThread());
+        if (_sent) {
+            return;
+        }
+        EventPoller::Ptr dst;
+        EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+            if (!dst && executor != getPoller()) {
+                dst = static_pointer_cast<EventPoller>(executor);
+            }
+        });
+        {
+            lock_guard<mutex> lck(s_mtx);
+            s_session = static_pointer_cast<MoveSession>(shared_from_this());
+            s_src = getPoller();
+            s_dst = dst;
+        }
+
+        sendData(kSendBeforeMove);
+        //在onRecv中请求迁移，迁移在onRecv返回后进行
+        weak_ptr<MoveSession> weak_self = static_pointer_cast<MoveSession>(shared_from_this());
+        auto started = moveToPoller(dst, [weak_self, dst]() {
+            auto strong_self = weak_self.lock();
+            CHECK(strong_self);
+            CHECK(dst->isCurrentThread());
+            if (strong_self) {
+                CHECK(strong_self->getPoller() == dst);
+                strong_self->sendData(kSendAfterMove);
+            }
+            s_moved = true;
+        });
+        CHECK(started);
+    }
+
+    void onError(const SockException &err) override {
+        CHECK(getPoller()->isCurrentThread());
+        CHECK(!s_moved || s_dst->isCurrentThread());
+        InfoL << err.what();
+        s_error = true;
+    }
+
+    void onManager() override {
+        CHECK(getPoller()->isCurrentThread());
+    }
+
+private:
+    void sendData(size_t bytes) {
+        while (bytes) {
+            auto size = std::min(bytes, kBlockSize);
+            auto buffer = std::make_shared<BufferRaw>(size);
+            auto data = buffer->data();
+            for (size_t i = 0; i < size; ++i) {
+                data[i] = (char) (_sent++ % 251);
+            }
+            buffer->setSize(size);
+            send(std::move(buffer));
+            bytes -= size;
+        }
+    }
+
+private:
+    size_t _sent = 0;
+};
+
+/**
+ * 会话在onRecv中迁移到其他poller线程，迁移时发送缓存中仍有数据，
+ * 同时其他线程不停向会话投递任务，检查数据完整有序、任务都在会话当前所属线程执行
+ */
+int main() {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+    EventPollerPool::setPoolSize(2);
+
+    TcpServer::Ptr server(new TcpServer());
+    server->enableSessionMove();
+    server->start<MoveSession>(0, "127.0.0.1");
+
+    auto fd = SockUtil::connect("127.0.0.1", server->getPort(), false);
+    if (fd < 0) {
+        ErrorL << "connect failed:" << get_uv_errmsg();
+        return -1;
+    }
+    if (::send(fd, "hello", 5, 0) != 5) {
+        ErrorL << "send failed:" << get_uv_errmsg();
+        return -1;
+    }
+
+    shared_ptr<MoveSession> session;
+    Ticker ticker;
+    while (!session && ticker.elapsedTime() < 3000) {
+        lock_guard<mutex> lck(s_mtx);
+        session = s_session.lock();
+    }
+    if (!session) {
+        ErrorL << "session not created";
+        return -1;
+    }
+
+    //迁移期间及迁移后从其他线程投递任务
+    size_t task_posted = 0;
+    thread poster([&]() {
+        Ticker ticker;
+        while (ticker.elapsedTime() < 500) {
+            weak_ptr<MoveSession> weak_session = session;
+            session->async([weak_session]() {
+                auto strong_session = weak_session.lock();
+                CHECK(!strong_session || strong_session->getPoller()->isCurrentThread());
+                ++s_task_done;
+            }, false);
+            ++task_posted;
+        }
+    });
+
+    //等待迁移开始后再读取数据
+    usleep(200 * 1000);
+    string buf(kBlockSize, '\0');
+    size_t received = 0;
+    while (received < kSendBeforeMove + kSendAfterMove) {
+        auto size = ::recv(fd, (char *) buf.data(), buf.size(), 0);
+        if (size <= 0) {
+            ErrorL << "recv failed:" << get_uv_errmsg();
+            ++s_failed;
+            break;
+        }
+        for (ssize_t i = 0; i < size; ++i) {
+            if (buf[i] != (char) (received % 251)) {
+                ErrorL << "data mismatch at " << received;
+                ++s_failed;
+                received = kSendBeforeMove + kSendAfterMove;
+                break;
+            }
+            ++received;
+        }
+    }
+    poster.join();
+    CHECK(s_moved);
+    CHECK(s_src != s_dst);
+
+    //跨线程断开会话，onError应该在新poller线程触发
+    session->safeShutdown();
+    session = nullptr;
+    ticker.resetTime();
+    while ((!s_error || s_task_done < task_posted) && ticker.elapsedTime() < 3000) {
+        usleep(10 * 1000);
+    }
+    CHECK(s_error);
+    CHECK(s_task_done == task_posted);
+    close(fd);
+
+    InfoL << "received " << received << " bytes, " << task_posted << " cross thread tasks, failed checks: " << s_failed;
+    return s_failed ? -1 : 0;
+}
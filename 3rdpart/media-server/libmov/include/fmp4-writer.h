@@ -49,6 +49,11 @@ int fmp4_writer_write_l(struct fmp4_writer_t* writer, int idx, const void* data,
 /// @return 0-ok, other-error
 int fmp4_writer_save_segment(fmp4_writer_t* fmp4);
 
+/// Flush pending samples as a new moof/mdat fragment without waiting for the next video keyframe,
+/// e.g. audio only stream (fragment is cut by video keyframe only)
+/// @return 0-ok, other-error
+int fmp4_writer_flush_fragment(fmp4_writer_t* fmp4);
+
 /// Get init segment data(write FTYP, MOOV only)
 /// WARNING: it caller duty to switch file/buffer context with fmp4_writer_write
 /// @return 0-ok, other-error
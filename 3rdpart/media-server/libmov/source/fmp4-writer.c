@@ -538,6 +538,12 @@ int fmp4_writer_save_segment(fmp4_writer_t* writer)
 	return mov_buffer_error(&mov->io);
 }
 
+int fmp4_writer_flush_fragment(fmp4_writer_t* writer)
+{
+	fmp4_write_fragment(writer);
+	return mov_buffer_error(&writer->mov.io);
+}
+
 int fmp4_writer_init_segment(fmp4_writer_t* writer)
 {
 	struct mov_t* mov;
@@ -22,8 +22,13 @@
 #endif //ENABLE_MYSQL
 #include "Common/config.h"
 #include "Common/MediaSource.h"
+#include "Common/SendQueuePolicy.h"
+#include "Common/StreamAffinity.h"
 #include "Http/HttpRequester.h"
 #include "Http/HttpSession.h"
+#include "Http/HttpFileCache.h"
+#include "Rtsp/RtpNack.h"
+#include "Record/MP4RecordIndex.h"
 #include "Network/TcpServer.h"
 #include "Player/PlayerProxy.h"
 #include "Util/MD5.h"
@@ -245,6 +250,39 @@ static inline string getProxyKey(const string &vhost,const string &app,const str
     return vhost + "/" + app + "/" + stream;
 }
 
+//直方图转换为json，包含常用分位数，with_buckets为true时附带所有非空的桶
+static Value makeHistogramValue(const Histogram &histogram, bool with_buckets) {
+    Value obj(objectValue);
+    obj["count"] = (Json::UInt64) histogram.count();
+    obj["mean"] = (Json::UInt64) histogram.meanValue();
+    obj["p50"] = (Json::UInt64) histogram.percentile(50);
+    obj["p90"] = (Json::UInt64) histogram.percentile(90);
+    obj["p99"] = (Json::UInt64) histogram.percentile(99);
+    obj["p999"] = (Json::UInt64) histogram.percentile(99.9);
+    obj["max"] = (Json::UInt64) histogram.maxValue();
+    if (with_buckets) {
+        obj["buckets"] = Value(arrayValue);
+        histogram.for_each([&](uint64_t low, uint64_t high, uint64_t count) {
+            Value bucket(objectValue);
+            bucket["low"] = (Json::UInt64) low;
+            bucket["high"] = (Json::UInt64) high;
+            bucket["count"] = (Json::UInt64) count;
+            obj["buckets"].append(bucket);
+        });
+    }
+    return obj;
+}
+
+//EventPoller事件循环各项耗时统计
+static Value makePollerMetrics(const EventPoller &poller, bool with_buckets) {
+    Value obj(objectValue);
+    obj["loop_usec"] = makeHistogramValue(poller.getLoopTime(), with_buckets);
+    obj["task_delay_usec"] = makeHistogramValue(poller.getTaskDelay(), with_buckets);
+    obj["timer_late_usec"] = makeHistogramValue(poller.getTimerLate(), with_buckets);
+    obj["events_per_wait"] = makeHistogramValue(poller.getWaitEvents(), with_buckets);
+    return obj;
+}
+
 /**
  * 安装api接口
  * 所有api都支持GET和POST两种方式
@@ -260,12 +298,22 @@ void installWebApi() {
         EventPollerPool::Instance().getExecutorDelay([invoker, headerOut](const vector<int> &vecDelay) {
             Value val;
             auto vec = EventPollerPool::Instance().getExecutorLoad();
+            vector<uint64_t> vecAccept;
+            vector<Value> vecMetrics;
+            EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+                auto poller = static_pointer_cast<EventPoller>(executor);
+                vecAccept.emplace_back(poller->getAcceptCount());
+                vecMetrics.emplace_back(makePollerMetrics(*poller, false));
+            });
             int i = API::Success;
             for (auto load : vec) {
                 Value obj(objectValue);
                 obj["load"] = load;
-                obj["delay"] = vecDelay[i++];
+                obj["delay"] = vecDelay[i];
+                obj["accept"] = (Json::UInt64) vecAccept[i];
+                obj["metrics"] = vecMetrics[i];
                 val["data"].append(obj);
+                ++i;
             }
             val["code"] = API::Success;
             invoker(200, headerOut, val.toStyledString());
@@ -290,6 +338,64 @@ void installWebApi() {
         });
     });
 
+    //获取网络线程与后台工作线程事件循环耗时分布，用于排查线程卡顿
+    //测试url http://127.0.0.1/index/api/getThreadsMetrics
+    api_regist("/index/api/getThreadsMetrics",[](API_ARGS_MAP){
+        CHECK_SECRET();
+        val["data"]["threads"] = Value(arrayValue);
+        val["data"]["work_threads"] = Value(arrayValue);
+        EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+            auto obj = makePollerMetrics(*static_pointer_cast<EventPoller>(executor), true);
+            obj["load"] = executor->load();
+            val["data"]["threads"].append(obj);
+        });
+        WorkThreadPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+            auto obj = makePollerMetrics(*static_pointer_cast<EventPoller>(executor), true);
+            obj["load"] = executor->load();
+            val["data"]["work_threads"].append(obj);
+        });
+    });
+
+    //获取服务器内部统计信息
+    //测试url http://127.0.0.1/index/api/getStatistic
+    api_regist("/index/api/getStatistic",[](API_ARGS_MAP){
+        CHECK_SECRET();
+        auto cookie = HttpCookieManager::Instance().getStatistic();
+        Value &obj = val["data"]["HttpCookie"];
+        obj["cookie_count"] = (Json::UInt64) cookie.cookie_count;
+        obj["lookup_count"] = (Json::UInt64) cookie.lookup_count;
+        obj["lookup_hit"] = (Json::UInt64) cookie.lookup_hit;
+        obj["lookup_avg_ns"] = (Json::UInt64) (cookie.lookup_count ? cookie.lookup_total_ns / cookie.lookup_count : 0);
+        obj["lookup_max_ns"] = (Json::UInt64) cookie.lookup_max_ns;
+        obj["expired_count"] = (Json::UInt64) cookie.expired_count;
+
+        auto file_cache = HttpFileCache::Instance().getStatistic();
+        Value &cache_obj = val["data"]["HttpFileCache"];
+        cache_obj["item_count"] = (Json::UInt64) file_cache.item_count;
+        cache_obj["cache_bytes"] = (Json::UInt64) file_cache.cache_bytes;
+        cache_obj["hit"] = (Json::UInt64) file_cache.hit;
+        cache_obj["miss"] = (Json::UInt64) file_cache.miss;
+        cache_obj["bypass"] = (Json::UInt64) file_cache.bypass;
+        cache_obj["eviction"] = (Json::UInt64) file_cache.eviction;
+
+        auto nack = RtpNackContext::getStatistic();
+        Value &nack_obj = val["data"]["RtpNack"];
+        nack_obj["missing"] = (Json::UInt64) nack.missing;
+        nack_obj["recovered"] = (Json::UInt64) nack.recovered;
+        nack_obj["lost"] = (Json::UInt64) nack.lost;
+        nack_obj["nack_packets"] = (Json::UInt64) nack.nack_packets;
+        nack_obj["nack_seqs"] = (Json::UInt64) nack.nack_seqs;
+
+        auto affinity = StreamAffinity::getStatistic();
+        Value &affinity_obj = val["data"]["StreamAffinity"];
+        affinity_obj["migrated"] = (Json::UInt64) affinity.migrated;
+        affinity_obj["kept"] = (Json::UInt64) affinity.kept;
+        affinity_obj["failed"] = (Json::UInt64) affinity.failed;
+        affinity_obj["pollers"] = (Json::UInt64) affinity.pollers;
+        affinity_obj["load_max"] = affinity.load_max;
+        affinity_obj["load_min"] = affinity.load_min;
+    });
+
     //获取服务器配置
     //测试url http://127.0.0.1/index/api/getServerConfig
     api_regist("/index/api/getServerConfig",[](API_ARGS_MAP){
@@ -531,11 +637,11 @@ void installWebApi() {
     //测试url(筛选某端口下的tcp会话) http://127.0.0.1/index/api/getAllSession?local_port=1935
     api_regist("/index/api/getAllSession",[](API_ARGS_MAP){
         CHECK_SECRET();
-        Value jsession;
         uint16_t local_port = allArgs["local_port"].as<uint16_t>();
         string &peer_ip = allArgs["peer_ip"];
 
         SessionMap::Instance().for_each_session([&](const string &id,const TcpSession::Ptr &session){
+            Value jsession;
             if(local_port != 0 && local_port != session->get_local_port()){
                 return;
             }
@@ -548,6 +654,14 @@ void installWebApi() {
             jsession["local_port"] = session->get_local_port();
             jsession["id"] = id;
             jsession["typeid"] = typeid(*session).name();
+            auto policy = dynamic_pointer_cast<SendQueuePolicy>(session);
+            if (policy) {
+                //播放器发送缓存积压情况以及拥塞控制丢帧统计
+                jsession["send_buffer_bytes"] = (Json::UInt64) policy->getQueueBytes();
+                jsession["send_buffer_delay"] = (Json::UInt64) policy->getQueueDelay();
+                jsession["drop_frames"] = (Json::UInt64) policy->getDropCount();
+                jsession["skip_gops"] = (Json::UInt64) policy->getSkipCount();
+            }
             val["data"].append(jsession);
         });
     });
@@ -747,6 +861,9 @@ void installWebApi() {
         val["peer_port"] = process->get_peer_port();
         val["local_port"] = process->get_local_port();
         val["local_ip"] = process->get_local_ip();
+        val["total_bytes"] = (Json::UInt64) process->getTotalBytes();
+        val["total_packets"] = (Json::UInt64) process->getTotalPackets();
+        val["bytes_speed"] = process->getBytesSpeed();
     });
 
     api_regist("/index/api/openRtpServer",[](API_ARGS_MAP){
@@ -775,6 +892,30 @@ void installWebApi() {
         val["port"] = server->getPort();
     });
 
+    api_regist("/index/api/connectRtpServer", [](API_ARGS_MAP_ASYNC) {
+        CHECK_SECRET();
+        CHECK_ARGS("stream_id", "dst_url", "dst_port");
+
+        RtpServer::Ptr server;
+        {
+            lock_guard<recursive_mutex> lck(s_rtpServerMapMtx);
+            auto it = s_rtpServerMap.find(allArgs["stream_id"]);
+            if (it == s_rtpServerMap.end()) {
+                throw ApiRetException("未找到rtp服务", API::NotFound);
+            }
+            server = it->second;
+        }
+
+        //tcp主动模式，由服务器连接设备
+        server->connectToServer(allArgs["dst_url"], allArgs["dst_port"], [val, headerOut, invoker](const SockException &ex) {
+            if (ex) {
+                const_cast<Value &>(val)["code"] = API::OtherFailed;
+                const_cast<Value &>(val)["msg"] = ex.what();
+            }
+            invoker(200, headerOut, val.toStyledString());
+        });
+    });
+
     api_regist("/index/api/closeRtpServer",[](API_ARGS_MAP){
         CHECK_SECRET();
         CHECK_ARGS("stream_id");
@@ -943,6 +1084,33 @@ void installWebApi() {
         val["data"]["paths"] = paths;
     });
 
+    //根据录像时间索引查询时间范围内的mp4切片，start、end为unix时间戳(单位毫秒)，end可省略
+    //返回的seek为切片内不晚于start的最近关键帧时间戳(单位毫秒)，可直接用于MP4Reader::seekTo
+    //http://127.0.0.1/index/api/getMp4RecordIndex?vhost=__defaultVhost__&app=live&stream=ss&start=1600000000000&end=1600003600000
+    api_regist("/index/api/getMp4RecordIndex", [](API_ARGS_MAP){
+        CHECK_SECRET();
+        CHECK_ARGS("vhost", "app", "stream", "start");
+        auto record_path = Recorder::getRecordPath(Recorder::type_mp4, allArgs["vhost"], allArgs["app"],allArgs["stream"]);
+        auto start_ms = allArgs["start"].as<uint64_t>();
+        auto end_ms = allArgs["end"].empty() ? start_ms : allArgs["end"].as<uint64_t>();
+
+        Json::Value segments(arrayValue);
+        for (auto &segment : MP4RecordIndex::Instance().find(record_path, start_ms, end_ms)) {
+            if (!File::is_file((record_path + segment.file).data())) {
+                //录像文件已经被删除
+                continue;
+            }
+            Json::Value obj;
+            obj["file"] = segment.file;
+            obj["start"] = (Json::UInt64) segment.start_ms;
+            obj["end"] = (Json::UInt64) segment.end_ms;
+            obj["seek"] = segment.seekKeyFrame(start_ms);
+            segments.append(obj);
+        }
+        val["data"]["rootPath"] = record_path;
+        val["data"]["segments"] = segments;
+    });
+
     static auto responseSnap = [](const string &snap_path,
                                   const HttpSession::KeyValue &headerIn,
                                   const HttpSession::HttpResponseInvoker &invoker) {
@@ -266,6 +266,9 @@ int start_main(int argc,char *argv[]) {
             });
         }
 
+        //https/rtsps/rtmps是否开启kTLS发送加密卸载
+        SSL_Initor::Instance().enableKTLS(mINI::Instance()[General::kEnableKTLS].as<bool>());
+
         uint16_t shellPort = mINI::Instance()[Shell::kPort];
         uint16_t rtspPort = mINI::Instance()[Rtsp::kPort];
         uint16_t rtspsPort = mINI::Instance()[Rtsp::kSSLPort];
@@ -277,6 +280,7 @@ int start_main(int argc,char *argv[]) {
 
         //设置poller线程数,该函数必须在使用ZLToolKit网络相关对象之前调用才能生效
         EventPollerPool::setPoolSize(threads);
+        EventPollerPool::enableCpuAffinity(mINI::Instance()[General::kPollerCpuAffinity].as<bool>());
 
         //简单的telnet服务器，可用于服务器调试，但是不能使用23端口，否则telnet上了莫名其妙的现象
         //测试方法:telnet 127.0.0.1 9000
@@ -299,6 +303,22 @@ int start_main(int argc,char *argv[]) {
         RtpServer::Ptr rtpServer = std::make_shared<RtpServer>();
 #endif//defined(ENABLE_RTPPROXY)
 
+        //是否每个poller线程独立监听
+        bool reuse_port = mINI::Instance()[General::kListenReusePort].as<bool>();
+        for (auto &server : {shellSrv, rtspSrv, rtspSSLSrv, rtmpSrv, rtmpsSrv, httpSrv, httpsSrv}) {
+            server->enableReusePort(reuse_port);
+        }
+        //开启播放器poller线程亲和性时，播放器会话才需要支持迁移
+        bool session_move = mINI::Instance()[General::kStreamAffinity].as<size_t>() > 0;
+        for (auto &server : {rtspSrv, rtspSSLSrv, rtmpSrv, rtmpsSrv, httpSrv, httpsSrv}) {
+            server->enableSessionMove(session_move);
+        }
+        //限制播放器连接的内核未发送数据
+        uint32_t notsent_lowat = mINI::Instance()[General::kTcpNotSentLowat];
+        for (auto &server : {rtspSrv, rtspSSLSrv, rtmpSrv, rtmpsSrv, httpSrv, httpsSrv}) {
+            server->setNotSentLowat(notsent_lowat);
+        }
+
         try {
             //rtsp服务器，端口默认554
             if(rtspPort) { rtspSrv->start<RtspSession>(rtspPort); }
@@ -339,12 +339,16 @@ void MultiMediaSourceMuxer::startSendRtp(MediaSource &sender, const string &dst_
         if (!strong_self || ex) {
             return;
         }
-        for (auto &track : strong_self->_muxer->getTracks(false)) {
-            rtp_sender->addTrack(track);
-        }
-        rtp_sender->addTrackCompleted();
         lock_guard<mutex> lck(strong_self->_rtp_sender_mtx);
-        strong_self->_rtp_sender[ssrc] = rtp_sender;
+        if (!strong_self->_rtp_sender) {
+            //所有发送目标共享一份ps/rtp编码
+            strong_self->_rtp_sender = std::make_shared<RtpSenderGroup>();
+            for (auto &track : strong_self->_muxer->getTracks(false)) {
+                strong_self->_rtp_sender->addTrack(track);
+            }
+            strong_self->_rtp_sender->addTrackCompleted();
+        }
+        strong_self->_rtp_sender->addSender(ssrc, rtp_sender);
     });
 #else
     cb(0, SockException(Err_other, "该功能未启用，编译时请打开ENABLE_RTPPROXY宏"));
@@ -353,16 +357,17 @@ void MultiMediaSourceMuxer::startSendRtp(MediaSource &sender, const string &dst_
 
 bool MultiMediaSourceMuxer::stopSendRtp(MediaSource &sender, const string& ssrc){
 #if defined(ENABLE_RTPPROXY)
-    if (ssrc.empty()) {
-        //关闭全部
-        lock_guard<mutex> lck(_rtp_sender_mtx);
-        auto size = _rtp_sender.size();
-        _rtp_sender.clear();
-        return size;
-    }
-    //关闭特定的
     lock_guard<mutex> lck(_rtp_sender_mtx);
-    return _rtp_sender.erase(ssrc);
+    if (!_rtp_sender) {
+        return false;
+    }
+    //ssrc为空时关闭全部，否则关闭特定的
+    auto removed = _rtp_sender->removeSender(ssrc);
+    if (_rtp_sender->empty()) {
+        //没有发送目标了，释放共享编码器
+        _rtp_sender = nullptr;
+    }
+    return removed;
 #else
     return false;
 #endif//ENABLE_RTPPROXY
@@ -455,8 +460,8 @@ void MultiMediaSourceMuxer::inputFrame(const Frame::Ptr &frame_in) {
 
 #if defined(ENABLE_RTPPROXY)
     lock_guard<mutex> lck(_rtp_sender_mtx);
-    for (auto &pr : _rtp_sender) {
-        pr.second->inputFrame(frame);
+    if (_rtp_sender) {
+        _rtp_sender->inputFrame(frame);
     }
 #endif //ENABLE_RTPPROXY
 
@@ -468,7 +473,7 @@ bool MultiMediaSourceMuxer::isEnabled(){
         //无人观看时，每次检查是否真的无人观看
         //有人观看时，则延迟一定时间检查一遍是否无人观看了(节省性能)
 #if defined(ENABLE_RTPPROXY)
-        _is_enable = (_muxer->isEnabled() || _rtp_sender.size());
+        _is_enable = (_muxer->isEnabled() || _rtp_sender);
 #else
         _is_enable = _muxer->isEnabled();
 #endif //ENABLE_RTPPROXY
@@ -190,7 +190,7 @@ private:
     std::weak_ptr<MultiMuxerPrivate::Listener> _track_listener;
 #if defined(ENABLE_RTPPROXY)
     mutex _rtp_sender_mtx;
-	unordered_map<string, RtpSender::Ptr> _rtp_sender;
+    RtpSenderGroup::Ptr _rtp_sender;
 #endif //ENABLE_RTPPROXY
 };
 
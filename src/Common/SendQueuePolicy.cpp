@@ -0,0 +1,71 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "SendQueuePolicy.h"
+#include "Common/config.h"
+
+namespace mediakit {
+
+bool SendQueuePolicy::inputGroup(const Socket::Ptr &sock, bool is_key) {
+    if (!sock) {
+        return true;
+    }
+    size_t bytes = sock->getSendBufferBytes();
+    //发送缓存为空时计时器不会重置，此时不能认为有积压
+    return inputGroup(bytes, bytes ? sock->elapsedTimeAfterFlushed() : 0, is_key);
+}
+
+bool SendQueuePolicy::inputGroup(size_t bytes, uint64_t delay, bool is_key) {
+    GET_CONFIG(uint32_t, max_ms, General::kSendQueueMaxMS);
+    GET_CONFIG(size_t, max_bytes, General::kSendQueueMaxBytes);
+    _queue_bytes = bytes;
+    _queue_delay = delay;
+    if (!max_ms && !max_bytes) {
+        //未开启拥塞控制
+        return true;
+    }
+    //超过水位
+    bool over_high = (max_ms && delay >= max_ms) || (max_bytes && bytes >= max_bytes);
+    //超过水位的一半
+    bool over_low = over_high || (max_ms && delay >= max_ms / 2) || (max_bytes && bytes >= max_bytes / 2);
+
+    if (_wait_key) {
+        if (!is_key || over_low) {
+            //积压未消除前持续丢弃，直到下一个关键帧
+            return false;
+        }
+        _wait_key = false;
+    } else if (over_high) {
+        //积压严重，丢弃后续数据直到下一个关键帧
+        _wait_key = true;
+        ++_skip_count;
+        return false;
+    }
+    _drop_non_ref = over_low;
+    return true;
+}
+
+uint64_t SendQueuePolicy::getDropCount() const {
+    return _drop_count;
+}
+
+uint64_t SendQueuePolicy::getSkipCount() const {
+    return _skip_count;
+}
+
+uint64_t SendQueuePolicy::getQueueBytes() const {
+    return _queue_bytes;
+}
+
+uint64_t SendQueuePolicy::getQueueDelay() const {
+    return _queue_delay;
+}
+
+}//namespace mediakit
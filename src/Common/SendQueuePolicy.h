@@ -0,0 +1,93 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_SENDQUEUEPOLICY_H
+#define ZLMEDIAKIT_SENDQUEUEPOLICY_H
+
+#include <atomic>
+#include "Network/Socket.h"
+using namespace toolkit;
+
+namespace mediakit {
+
+/**
+ * 播放器发送列队拥塞控制策略
+ * socket发送缓存积压超过水位的一半时丢弃非参考帧，超过水位时丢弃所有数据并等待直播流的下一个关键帧(不会回退到gop缓存)，
+ * 这样可以限制每个播放器占用的内存，并且网络恢复后延时不会持续累积
+ */
+class SendQueuePolicy {
+public:
+    SendQueuePolicy() = default;
+    virtual ~SendQueuePolicy() = default;
+
+    /**
+     * 收到环形缓存中的一组数据时调用，根据socket发送缓存积压情况更新拥塞状态
+     * @param sock 播放器socket
+     * @param is_key 该组数据是否从关键帧开始(纯音频时恒为true)
+     * @return false表示需要丢弃整组数据(正在等待下一个关键帧)
+     */
+    bool inputGroup(const Socket::Ptr &sock, bool is_key);
+
+    /**
+     * 同上，直接输入socket发送缓存积压情况
+     * @param bytes 积压字节数
+     * @param delay 积压时长，单位毫秒
+     * @param is_key 该组数据是否从关键帧开始
+     * @return false表示需要丢弃整组数据
+     */
+    bool inputGroup(size_t bytes, uint64_t delay, bool is_key);
+
+    /**
+     * 组内每帧调用，拥塞时丢弃非参考帧
+     * @param is_non_ref 判断该帧是否为非参考帧，仅在拥塞时才会调用
+     * @return true表示丢弃该帧
+     */
+    template<typename FUNC>
+    bool dropFrame(FUNC &&is_non_ref) {
+        if (!_drop_non_ref || !is_non_ref()) {
+            return false;
+        }
+        ++_drop_count;
+        return true;
+    }
+
+    /**
+     * 获取丢弃的非参考帧(或rtp包)个数
+     */
+    uint64_t getDropCount() const;
+
+    /**
+     * 获取跳至下一个关键帧的次数
+     */
+    uint64_t getSkipCount() const;
+
+    /**
+     * 获取最近一次采样的socket发送缓存积压字节数
+     */
+    uint64_t getQueueBytes() const;
+
+    /**
+     * 获取最近一次采样的socket发送缓存积压时长，单位毫秒
+     */
+    uint64_t getQueueDelay() const;
+
+private:
+    //是否正在丢弃非参考帧
+    bool _drop_non_ref = false;
+    //是否正在等待下一个关键帧
+    bool _wait_key = false;
+    std::atomic<uint64_t> _drop_count{0};
+    std::atomic<uint64_t> _skip_count{0};
+    std::atomic<uint64_t> _queue_bytes{0};
+    std::atomic<uint64_t> _queue_delay{0};
+};
+
+}//namespace mediakit
+#endif //ZLMEDIAKIT_SENDQUEUEPOLICY_H
@@ -0,0 +1,109 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include "StreamAffinity.h"
+#include "Common/config.h"
+
+namespace mediakit {
+
+static atomic<uint64_t> s_migrated{0};
+static atomic<uint64_t> s_kept{0};
+static atomic<uint64_t> s_failed{0};
+
+//poller线程池创建后不再改变
+static const vector<EventPoller::Ptr> &getPollers() {
+    static vector<EventPoller::Ptr> s_pollers = []() {
+        vector<EventPoller::Ptr> ret;
+        EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+            ret.emplace_back(static_pointer_cast<EventPoller>(executor));
+        });
+        return ret;
+    }();
+    return s_pollers;
+}
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+bool StreamAffinity::moveSession(TcpSession &session, const MediaInfo &info, function<void()> cb) {
+    GET_CONFIG(size_t, affinity, General::kStreamAffinity);
+    auto &pollers = getPollers();
+    if (!affinity || affinity >= pollers.size()) {
+        //未开启或者k不小于线程数
+        return false;
+    }
+
+    //最高随机权重(rendezvous)hash选出k个poller线程，线程数不变时同一路流总是对应同一组线程
+    auto hash = std::hash<string>()(info._vhost + "/" + info._app + "/" + info._streamid);
+    vector<pair<uint64_t, size_t> > scores;
+    scores.reserve(pollers.size());
+    for (size_t i = 0; i < pollers.size(); ++i) {
+        scores.emplace_back(mix64(hash + (i + 1) * 0x9e3779b97f4a7c15ULL), i);
+    }
+    std::partial_sort(scores.begin(), scores.begin() + affinity, scores.end(), std::greater<pair<uint64_t, size_t> >());
+
+    EventPoller::Ptr target;
+    int min_load = std::numeric_limits<int>::max();
+    for (size_t i = 0; i < affinity; ++i) {
+        auto &poller = pollers[scores[i].second];
+        if (poller == session.getPoller()) {
+            ++s_kept;
+            return false;
+        }
+        auto load = poller->load();
+        if (load < min_load) {
+            min_load = load;
+            target = poller;
+        }
+    }
+
+    weak_ptr<TcpSession> weak_session = session.shared_from_this();
+    auto started = session.moveToPoller(target, [weak_session, target, cb]() {
+        auto strong_session = weak_session.lock();
+        if (!strong_session) {
+            return;
+        }
+        if (strong_session->getPoller() == target) {
+            ++s_migrated;
+        } else {
+            ++s_failed;
+        }
+        cb();
+    });
+    if (!started) {
+        ++s_failed;
+    }
+    return started;
+}
+
+StreamAffinityStatistic StreamAffinity::getStatistic() {
+    StreamAffinityStatistic ret;
+    ret.migrated = s_migrated;
+    ret.kept = s_kept;
+    ret.failed = s_failed;
+    auto loads = EventPollerPool::Instance().getExecutorLoad();
+    ret.pollers = loads.size();
+    if (!loads.empty()) {
+        ret.load_max = *std::max_element(loads.begin(), loads.end());
+        ret.load_min = *std::min_element(loads.begin(), loads.end());
+    }
+    return ret;
+}
+
+}//namespace mediakit
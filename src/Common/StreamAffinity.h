@@ -0,0 +1,65 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_STREAMAFFINITY_H
+#define ZLMEDIAKIT_STREAMAFFINITY_H
+
+#include <functional>
+#include "Network/TcpSession.h"
+#include "Common/MediaSource.h"
+using namespace toolkit;
+
+namespace mediakit {
+
+/**
+ * 播放器poller线程亲和性统计信息
+ */
+class StreamAffinityStatistic {
+public:
+    //迁移到流所属poller线程的播放器个数
+    uint64_t migrated = 0;
+    //已经在流所属poller线程，无需迁移的播放器个数
+    uint64_t kept = 0;
+    //迁移失败的播放器个数
+    uint64_t failed = 0;
+    //poller线程个数
+    uint64_t pollers = 0;
+    //poller线程最高负载
+    int load_max = 0;
+    //poller线程最低负载
+    int load_min = 0;
+};
+
+/**
+ * 播放器poller线程亲和性策略
+ * 播放器连接默认分布在所有poller线程，流的RingBuffer每写一帧都要切换到所有有播放器的poller线程分发，
+ * 开启后播放器在解析出播放url后迁移到该流所属的k个poller线程之一(按流名hash选出k个线程，再选其中负载最低的)，
+ * 从而把每路流的分发线程数限制在k个以内
+ */
+class StreamAffinity {
+public:
+    /**
+     * 把播放器会话迁移到流所属的poller线程，必须在会话所在poller线程调用
+     * @param session 播放器会话
+     * @param info 播放的流
+     * @param cb 迁移完成后在新poller线程执行的回调，调用者应该在该回调中继续处理播放请求
+     * @return true代表开始迁移，调用者应该立即返回，只要会话对象未被销毁cb一定会被执行(迁移期间连接断开时也会执行，随后触发onError)；
+     *         false代表无需迁移(cb不会被执行)
+     */
+    static bool moveSession(TcpSession &session, const MediaInfo &info, function<void()> cb);
+
+    /**
+     * 获取统计信息
+     */
+    static StreamAffinityStatistic getStatistic();
+};
+
+}//namespace mediakit
+#endif //ZLMEDIAKIT_STREAMAFFINITY_H
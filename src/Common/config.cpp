@@ -68,7 +68,14 @@ const string kResetWhenRePlay = GENERAL_FIELD"resetWhenRePlay";
 const string kPublishToHls = GENERAL_FIELD"publishToHls";
 const string kPublishToMP4 = GENERAL_FIELD"publishToMP4";
 const string kMergeWriteMS = GENERAL_FIELD"mergeWriteMS";
+const string kSendQueueMaxMS = GENERAL_FIELD"sendQueueMaxMS";
+const string kSendQueueMaxBytes = GENERAL_FIELD"sendQueueMaxBytes";
 const string kModifyStamp = GENERAL_FIELD"modifyStamp";
+const string kEnableKTLS = GENERAL_FIELD"enableKTLS";
+const string kListenReusePort = GENERAL_FIELD"listenReusePort";
+const string kPollerCpuAffinity = GENERAL_FIELD"pollerCpuAffinity";
+const string kTcpNotSentLowat = GENERAL_FIELD"tcpNotSentLowat";
+const string kStreamAffinity = GENERAL_FIELD"streamAffinity";
 const string kHlsDemand = GENERAL_FIELD"hls_demand";
 const string kRtspDemand = GENERAL_FIELD"rtsp_demand";
 const string kRtmpDemand = GENERAL_FIELD"rtmp_demand";
@@ -85,7 +92,14 @@ onceToken token([](){
     mINI::Instance()[kPublishToHls] = 1;
     mINI::Instance()[kPublishToMP4] = 0;
     mINI::Instance()[kMergeWriteMS] = 0;
+    mINI::Instance()[kSendQueueMaxMS] = 0;
+    mINI::Instance()[kSendQueueMaxBytes] = 0;
     mINI::Instance()[kModifyStamp] = 0;
+    mINI::Instance()[kEnableKTLS] = 0;
+    mINI::Instance()[kListenReusePort] = 0;
+    mINI::Instance()[kPollerCpuAffinity] = 0;
+    mINI::Instance()[kTcpNotSentLowat] = 0;
+    mINI::Instance()[kStreamAffinity] = 0;
     mINI::Instance()[kMediaServerId] = makeRandStr(16);
     mINI::Instance()[kHlsDemand] = 0;
     mINI::Instance()[kRtspDemand] = 0;
@@ -114,12 +128,21 @@ const string kRootPath = HTTP_FIELD"rootPath";
 const string kNotFound = HTTP_FIELD"notFound";
 //是否显示文件夹菜单
 const string kDirMenu = HTTP_FIELD"dirMenu";
+//热点文件内存缓存总大小
+const string kFileCacheSize = HTTP_FIELD"fileCacheSize";
+//可以被内存缓存的单个文件最大字节数
+const string kFileCacheMaxObjSize = HTTP_FIELD"fileCacheMaxObjSize";
+//http-flv/ws-flv播放器是否共享媒体源预先生成的flv tag
+const string kFlvSharedTag = HTTP_FIELD"flvSharedTag";
 
 onceToken token([](){
     mINI::Instance()[kSendBufSize] = 64 * 1024;
     mINI::Instance()[kMaxReqSize] = 4*1024;
     mINI::Instance()[kKeepAliveSecond] = 15;
     mINI::Instance()[kDirMenu] = true;
+    mINI::Instance()[kFileCacheSize] = 64 * 1024 * 1024;
+    mINI::Instance()[kFileCacheMaxObjSize] = 4 * 1024 * 1024;
+    mINI::Instance()[kFlvSharedTag] = false;
 
 #if defined(_WIN32)
     mINI::Instance()[kCharSet] = "gb2312";
@@ -196,6 +219,10 @@ const string kMaxRtpCount = RTP_FIELD"maxRtpCount";
 const string kClearCount = RTP_FIELD"clearCount";
 //最大RTP时间为13个小时，每13小时回环一次
 const string kCycleMS = RTP_FIELD"cycleMS";
+//udp收流时丢包重传(rtcp nack)的最大等待时间
+const string kNackMaxMS = RTP_FIELD"nackMaxMS";
+//rtp/rtcp udp端口对分配范围
+const string kPortRange = RTP_FIELD"portRange";
 
 onceToken token([](){
     mINI::Instance()[kVideoMtuSize] = 1400;
@@ -203,6 +230,8 @@ onceToken token([](){
     mINI::Instance()[kMaxRtpCount] = 50;
     mINI::Instance()[kClearCount] = 10;
     mINI::Instance()[kCycleMS] = 13*60*60*1000;
+    mINI::Instance()[kNackMaxMS] = 0;
+    mINI::Instance()[kPortRange] = "";
 },nullptr);
 } //namespace Rtsp
 
@@ -238,8 +267,12 @@ const string kFilePath = RECORD_FIELD"filePath";
 const string kFileBufSize = RECORD_FIELD"fileBufSize";
 //mp4录制完成后是否进行二次关键帧索引写入头部
 const string kFastStart = RECORD_FIELD"fastStart";
+//mp4录制是否采用fmp4格式
+const string kEnableFmp4 = RECORD_FIELD"enableFmp4";
 //mp4文件是否重头循环读取
 const string kFileRepeat = RECORD_FIELD"fileRepeat";
+//mp4点播预读缓存大小
+const string kReadAheadSize = RECORD_FIELD"readAheadSize";
 
 onceToken token([](){
     mINI::Instance()[kAppName] = "record";
@@ -248,7 +281,9 @@ onceToken token([](){
     mINI::Instance()[kFilePath] = "./www";
     mINI::Instance()[kFileBufSize] = 64 * 1024;
     mINI::Instance()[kFastStart] = false;
+    mINI::Instance()[kEnableFmp4] = false;
     mINI::Instance()[kFileRepeat] = false;
+    mINI::Instance()[kReadAheadSize] = 1024 * 1024;
 },nullptr);
 } //namespace Record
 
@@ -288,11 +323,14 @@ const string kDumpDir = RTP_PROXY_FIELD"dumpDir";
 const string kCheckSource = RTP_PROXY_FIELD"checkSource";
 //rtp接收超时时间
 const string kTimeoutSec = RTP_PROXY_FIELD"timeoutSec";
+//单端口模式下udp socket分片个数
+const string kUdpShards = RTP_PROXY_FIELD"udpShards";
 
 onceToken token([](){
     mINI::Instance()[kDumpDir] = "";
     mINI::Instance()[kCheckSource] = 1;
     mINI::Instance()[kTimeoutSec] = 15;
+    mINI::Instance()[kUdpShards] = 1;
 },nullptr);
 } //namespace RtpProxy
 
@@ -179,8 +179,22 @@ extern const string kPublishToMP4 ;
 //合并写缓存大小(单位毫秒)，合并写指服务器缓存一定的数据后才会一次性写入socket，这样能提高性能，但是会提高延时
 //开启后会同时关闭TCP_NODELAY并开启MSG_MORE
 extern const string kMergeWriteMS ;
+//播放器发送缓存积压时长水位(单位毫秒)，超过一半时丢弃非参考帧，超过时跳至下一个关键帧，置0关闭
+extern const string kSendQueueMaxMS;
+//播放器发送缓存积压字节数水位，超过一半时丢弃非参考帧，超过时跳至下一个关键帧，置0关闭
+extern const string kSendQueueMaxBytes;
 //全局的时间戳覆盖开关，在转协议时，对frame进行时间戳覆盖
 extern const string kModifyStamp;
+//https/rtsps/rtmps是否开启kTLS(内核tls)发送加密卸载
+extern const string kEnableKTLS;
+//tcp服务器是否每个poller线程独立创建SO_REUSEPORT监听socket
+extern const string kListenReusePort;
+//是否把poller线程依次绑定到各个cpu核心
+extern const string kPollerCpuAffinity;
+//播放器tcp连接的TCP_NOTSENT_LOWAT字节数，0为不设置
+extern const string kTcpNotSentLowat;
+//每路流的播放器最多分布的poller线程数，0为关闭播放器poller线程亲和性
+extern const string kStreamAffinity;
 //按需转协议的开关
 extern const string kHlsDemand;
 extern const string kRtspDemand;
@@ -206,6 +220,12 @@ extern const string kRootPath;
 extern const string kNotFound;
 //是否显示文件夹菜单
 extern const string kDirMenu;
+//热点文件内存缓存总大小，单位字节，置0关闭
+extern const string kFileCacheSize;
+//可以被内存缓存的单个文件最大字节数
+extern const string kFileCacheMaxObjSize;
+//http-flv/ws-flv播放器是否共享媒体源预先生成的flv tag
+extern const string kFlvSharedTag;
 }//namespace Http
 
 ////////////SHELL配置///////////
@@ -253,6 +273,10 @@ extern const string kMaxRtpCount;
 extern const string kClearCount;
 //最大RTP时间为13个小时，每13小时回环一次
 extern const string kCycleMS;
+//udp收流时丢包重传(rtcp nack)的最大等待时间，单位毫秒，置0关闭
+extern const string kNackMaxMS;
+//rtp/rtcp udp端口对分配范围，格式为"最小端口-最大端口"，置空则由系统随机分配
+extern const string kPortRange;
 } //namespace Rtsp
 
 ////////////组播配置///////////
@@ -279,8 +303,12 @@ extern const string kFilePath;
 extern const string kFileBufSize;
 //mp4录制完成后是否进行二次关键帧索引写入头部
 extern const string kFastStart;
+//mp4录制是否采用fmp4格式，按关键帧写入moof/mdat分片，关闭文件时只需写入mfra
+extern const string kEnableFmp4;
 //mp4文件是否重头循环读取
 extern const string kFileRepeat;
+//mp4点播预读缓存大小，相邻sample的小io合并成一次大io
+extern const string kReadAheadSize;
 } //namespace Record
 
 ////////////HLS相关配置///////////
@@ -307,6 +335,8 @@ extern const string kDumpDir;
 extern const string kCheckSource;
 //rtp接收超时时间
 extern const string kTimeoutSec;
+//单端口模式下udp socket分片个数，0为每个poller线程一个，1为关闭分片(默认)
+extern const string kUdpShards;
 } //namespace RtpProxy
 
 /**
@@ -96,7 +96,7 @@ void AACRtmpEncoder::inputFrame(const Frame::Ptr &frame) {
 
     if(!_aac_cfg.empty()){
         RtmpPacket::Ptr rtmpPkt = ResourcePoolHelper<RtmpPacket>::obtainObj();
-        rtmpPkt->buffer.clear();
+        rtmpPkt->clear();
 
         //header
         uint8_t is_config = false;
@@ -104,9 +104,9 @@ void AACRtmpEncoder::inputFrame(const Frame::Ptr &frame) {
         rtmpPkt->buffer.push_back(!is_config);
 
         //aac data
-        rtmpPkt->buffer.append(frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize());
+        rtmpPkt->appendFrame(frame);
 
-        rtmpPkt->body_size = rtmpPkt->buffer.size();
+        rtmpPkt->body_size = rtmpPkt->totalSize();
         rtmpPkt->chunk_id = CHUNK_AUDIO;
         rtmpPkt->stream_index = STREAM_MEDIA;
         rtmpPkt->time_stamp = frame->dts();
@@ -118,7 +118,7 @@ void AACRtmpEncoder::inputFrame(const Frame::Ptr &frame) {
 void AACRtmpEncoder::makeAudioConfigPkt() {
     _audio_flv_flags = getAudioRtmpFlags(std::make_shared<AACTrack>(_aac_cfg));
     RtmpPacket::Ptr rtmpPkt = ResourcePoolHelper<RtmpPacket>::obtainObj();
-    rtmpPkt->buffer.clear();
+    rtmpPkt->clear();
 
     //header
     uint8_t is_config = true;
@@ -50,7 +50,7 @@ void CommonRtmpEncoder::inputFrame(const Frame::Ptr &frame) {
         return;
     }
     RtmpPacket::Ptr rtmp = ResourcePoolHelper<RtmpPacket>::obtainObj();
-    rtmp->buffer.clear();
+    rtmp->clear();
     //header
     rtmp->buffer.push_back(_audio_flv_flags);
     //data
@@ -183,7 +183,7 @@ void H265RtmpEncoder::inputFrame(const Frame::Ptr &frame) {
         flags |= (((frame->configFrame() || frame->keyFrame()) ? FLV_KEY_FRAME : FLV_INTER_FRAME) << 4);
 
         _lastPacket = ResourcePoolHelper<RtmpPacket>::obtainObj();
-        _lastPacket->buffer.clear();
+        _lastPacket->clear();
         _lastPacket->buffer.push_back(flags);
         _lastPacket->buffer.push_back(!is_config);
         auto cts = frame->pts() - frame->dts();
@@ -197,9 +197,9 @@ void H265RtmpEncoder::inputFrame(const Frame::Ptr &frame) {
 
     }
     uint32_t size = htonl((uint32_t)iLen);
-    _lastPacket->buffer.append((char *) &size, 4);
-    _lastPacket->buffer.append(pcData, iLen);
-    _lastPacket->body_size = _lastPacket->buffer.size();
+    //帧数据不拷贝，rtmp包直接引用之
+    _lastPacket->appendFrame(frame, (char *) &size, 4);
+    _lastPacket->body_size = _lastPacket->totalSize();
 }
 
 void H265RtmpEncoder::makeVideoConfigPkt() {
@@ -209,7 +209,7 @@ void H265RtmpEncoder::makeVideoConfigPkt() {
     bool is_config = true;
 
     RtmpPacket::Ptr rtmpPkt = ResourcePoolHelper<RtmpPacket>::obtainObj();
-    rtmpPkt->buffer.clear();
+    rtmpPkt->clear();
 
     //header
     rtmpPkt->buffer.push_back(flags);
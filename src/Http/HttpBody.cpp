@@ -60,6 +60,12 @@ HttpFileBody::HttpFileBody(const std::shared_ptr<FILE> &fp, size_t offset, size_
     init(fp,offset,max_size);
 }
 
+HttpFileBody::HttpFileBody(const std::shared_ptr<char> &data, size_t offset, size_t max_size) {
+    _max_size = max_size;
+    //与mmap模式一样，直接引用文件内容，不拷贝
+    _map_addr = std::shared_ptr<char>(data, data.get() + offset);
+}
+
 #if defined(_WIN32) || defined(_WIN64)
     #define fseek64 _fseeki64
     #define ftell64 _ftelli64
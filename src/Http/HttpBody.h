@@ -93,6 +93,14 @@ public:
      */
     HttpFileBody(const std::shared_ptr<FILE> &fp,size_t offset,size_t max_size);
     HttpFileBody(const string &file_path);
+
+    /**
+     * 从内存缓存的文件内容构造
+     * @param data 文件内容
+     * @param offset 相对文件头的偏移量
+     * @param max_size 最大读取字节数，offset + max_size不得大于文件大小
+     */
+    HttpFileBody(const std::shared_ptr<char> &data, size_t offset, size_t max_size);
     ~HttpFileBody(){};
 
     ssize_t remainSize() override ;
@@ -8,6 +8,7 @@
  * may be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <chrono>
 #include "Util/util.h"
 #include "Util/MD5.h"
 #include "Common/config.h"
@@ -26,6 +27,7 @@ HttpServerCookie::HttpServerCookie(const std::shared_ptr<HttpCookieManager> &man
     _cookie_uuid = cookie;
     _cookie_name = cookie_name;
     _manager = manager;
+    _update_stamp = getCurrentMillisecond();
     manager->onAddCookie(_cookie_name,_uid,_cookie_uuid);
 }
 
@@ -53,11 +55,15 @@ const string& HttpServerCookie::getCookieName() const{
 }
 
 void HttpServerCookie::updateTime() {
-    _ticker.resetTime();
+    _update_stamp.store(getCurrentMillisecond(), memory_order_relaxed);
 }
 
 bool HttpServerCookie::isExpired() {
-    return _ticker.elapsedTime() > _max_elapsed * 1000;
+    return getCurrentMillisecond() > expireStamp();
+}
+
+uint64_t HttpServerCookie::expireStamp() const {
+    return _update_stamp.load(memory_order_relaxed) + _max_elapsed * 1000;
 }
 
 std::shared_ptr<lock_guard<recursive_mutex> > HttpServerCookie::getLock(){
@@ -85,34 +91,70 @@ HttpCookieManager::~HttpCookieManager() {
     _timer.reset();
 }
 
+static inline uint64_t getSteadyNanosecond() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+HttpCookieManager::CookieShard &HttpCookieManager::getCookieShard(const string &cookie) {
+    return _cookie_shards[std::hash<string>()(cookie) & (kShardCount - 1)];
+}
+
+HttpCookieManager::UidShard &HttpCookieManager::getUidShard(const string &uid) {
+    return _uid_shards[std::hash<string>()(uid) & (kShardCount - 1)];
+}
+
+void HttpCookieManager::onLookup(uint64_t start_ns, bool hit) {
+    auto cost = getSteadyNanosecond() - start_ns;
+    _lookup_count.fetch_add(1, memory_order_relaxed);
+    _lookup_total_ns.fetch_add(cost, memory_order_relaxed);
+    if (hit) {
+        _lookup_hit.fetch_add(1, memory_order_relaxed);
+    }
+    auto max_ns = _lookup_max_ns.load(memory_order_relaxed);
+    while (cost > max_ns && !_lookup_max_ns.compare_exchange_weak(max_ns, cost, memory_order_relaxed));
+}
+
 void HttpCookieManager::onManager() {
-    lock_guard<recursive_mutex> lck(_mtx_cookie);
-    //先遍历所有类型
-    for(auto it_name = _map_cookie.begin() ; it_name != _map_cookie.end() ;){
-        //再遍历该类型下的所有cookie
-        for (auto it_cookie = it_name->second.begin() ; it_cookie != it_name->second.end() ; ){
-            if(it_cookie->second->isExpired()){
+    auto now = getCurrentMillisecond();
+    for (auto &shard : _cookie_shards) {
+        //cookie对象在锁外析构，析构时会回调onDelCookie
+        vector<HttpServerCookie::Ptr> expired;
+        {
+            lock_guard<mutex> lck(shard._mtx);
+            //只处理到期的cookie，未到期的cookie不用遍历
+            while (!shard._expire_queue.empty() && shard._expire_queue.begin()->first <= now) {
+                auto cookie = shard._expire_queue.begin()->second.lock();
+                shard._expire_queue.erase(shard._expire_queue.begin());
+                if (!cookie) {
+                    //cookie已经被删除
+                    continue;
+                }
+                auto it = shard._map_cookie.find(cookie->getCookie());
+                if (it == shard._map_cookie.end() || it->second != cookie) {
+                    //cookie已经被删除或替换
+                    continue;
+                }
+                if (!cookie->isExpired()) {
+                    //期间刷新过cookie，根据最新的过期时间重新排队
+                    shard._expire_queue.emplace(cookie->expireStamp(), cookie);
+                    continue;
+                }
                 //cookie过期,移除记录
-                DebugL << it_cookie->second->getUid() << " cookie过期:" << it_cookie->second->getCookie();
-                it_cookie = it_name->second.erase(it_cookie);
-                continue;
+                DebugL << cookie->getUid() << " cookie过期:" << cookie->getCookie();
+                shard._map_cookie.erase(it);
+                expired.emplace_back(std::move(cookie));
             }
-            ++it_cookie;
         }
-
-        if(it_name->second.empty()){
-            //该类型下没有任何cooki记录,移除之
-            DebugL << "该path下没有任何cooki记录:" << it_name->first;
-            it_name = _map_cookie.erase(it_name);
-            continue;
-        }
-        ++it_name;
+        _expired_count.fetch_add(expired.size(), memory_order_relaxed);
     }
 }
 
 HttpServerCookie::Ptr HttpCookieManager::addCookie(const string &cookie_name,const string &uidIn,uint64_t max_elapsed,int max_client) {
-    lock_guard<recursive_mutex> lck(_mtx_cookie);
-    auto cookie = _geneator.obtain();
+    string cookie;
+    {
+        lock_guard<mutex> lck(_mtx_geneator);
+        cookie = _geneator.obtain();
+    }
     auto uid = uidIn.empty() ? cookie : uidIn;
     auto oldCookie = getOldestCookie(cookie_name , uid, max_client);
     if(!oldCookie.empty()){
@@ -122,29 +164,34 @@ HttpServerCookie::Ptr HttpCookieManager::addCookie(const string &cookie_name,con
     }
     HttpServerCookie::Ptr data(new HttpServerCookie(shared_from_this(),cookie_name,uid,cookie,max_elapsed));
     //保存该账号下的新cookie
-    _map_cookie[cookie_name][cookie] = data;
+    auto &shard = getCookieShard(cookie);
+    lock_guard<mutex> lck(shard._mtx);
+    shard._map_cookie[cookie] = data;
+    shard._expire_queue.emplace(data->expireStamp(), data);
     return data;
 }
 
 HttpServerCookie::Ptr HttpCookieManager::getCookie(const string &cookie_name,const string &cookie) {
-    lock_guard<recursive_mutex> lck(_mtx_cookie);
-    auto it_name = _map_cookie.find(cookie_name);
-    if(it_name == _map_cookie.end()){
-        //不存在该类型的cookie
-        return nullptr;
-    }
-    auto it_cookie = it_name->second.find(cookie);
-    if(it_cookie == it_name->second.end()){
-        //该类型下没有对应的cookie
-        return nullptr;
-    }
-    if(it_cookie->second->isExpired()){
-        //cookie过期
-        DebugL << "cookie过期:" << it_cookie->second->getCookie();
-        it_name->second.erase(it_cookie);
-        return nullptr;
+    auto start_ns = getSteadyNanosecond();
+    HttpServerCookie::Ptr ret;
+    HttpServerCookie::Ptr expired;
+    {
+        auto &shard = getCookieShard(cookie);
+        lock_guard<mutex> lck(shard._mtx);
+        auto it_cookie = shard._map_cookie.find(cookie);
+        if (it_cookie != shard._map_cookie.end() && it_cookie->second->getCookieName() == cookie_name) {
+            if (it_cookie->second->isExpired()) {
+                //cookie过期, 在锁外析构
+                DebugL << "cookie过期:" << it_cookie->second->getCookie();
+                expired = std::move(it_cookie->second);
+                shard._map_cookie.erase(it_cookie);
+            } else {
+                ret = it_cookie->second;
+            }
+        }
     }
-    return it_cookie->second;
+    onLookup(start_ns, ret.operator bool());
+    return ret;
 }
 
 HttpServerCookie::Ptr HttpCookieManager::getCookie(const string &cookie_name,const StrCaseMap &http_header) {
@@ -181,27 +228,54 @@ bool HttpCookieManager::delCookie(const HttpServerCookie::Ptr &cookie) {
 }
 
 bool HttpCookieManager::delCookie(const string &cookie_name,const string &cookie) {
-    lock_guard<recursive_mutex> lck(_mtx_cookie);
-    auto it_name = _map_cookie.find(cookie_name);
-    if(it_name == _map_cookie.end()){
-        return false;
+    HttpServerCookie::Ptr removed;
+    {
+        auto &shard = getCookieShard(cookie);
+        lock_guard<mutex> lck(shard._mtx);
+        auto it = shard._map_cookie.find(cookie);
+        if (it == shard._map_cookie.end() || it->second->getCookieName() != cookie_name) {
+            return false;
+        }
+        //在锁外析构，过期队列中的记录由定时器清理
+        removed = std::move(it->second);
+        shard._map_cookie.erase(it);
     }
-    return it_name->second.erase(cookie);
+    return true;
+}
+
+HttpCookieStatistic HttpCookieManager::getStatistic() {
+    HttpCookieStatistic ret;
+    for (auto &shard : _cookie_shards) {
+        lock_guard<mutex> lck(shard._mtx);
+        ret.cookie_count += shard._map_cookie.size();
+    }
+    ret.lookup_count = _lookup_count.load(memory_order_relaxed);
+    ret.lookup_hit = _lookup_hit.load(memory_order_relaxed);
+    ret.lookup_total_ns = _lookup_total_ns.load(memory_order_relaxed);
+    ret.lookup_max_ns = _lookup_max_ns.load(memory_order_relaxed);
+    ret.expired_count = _expired_count.load(memory_order_relaxed);
+    return ret;
 }
 
 void HttpCookieManager::onAddCookie(const string &cookie_name,const string &uid,const string &cookie){
     //添加新的cookie，我们记录下这个uid下有哪些cookie，目的是实现单账号多地登录时挤占登录
-    lock_guard<recursive_mutex> lck(_mtx_cookie);
+    auto &shard = getUidShard(uid);
+    lock_guard<mutex> lck(shard._mtx);
     //相同用户下可以存在多个cookie(意味多地登录)，这些cookie根据登录时间的早晚依次排序
-    _map_uid_to_cookie[cookie_name][uid][getCurrentMillisecond()] = cookie;
+    shard._map_uid_to_cookie[cookie_name][uid][getCurrentMillisecond()] = cookie;
 }
+
 void HttpCookieManager::onDelCookie(const string &cookie_name,const string &uid,const string &cookie){
-    lock_guard<recursive_mutex> lck(_mtx_cookie);
-    //回收随机字符串
-    _geneator.release(cookie);
+    {
+        //回收随机字符串
+        lock_guard<mutex> lck(_mtx_geneator);
+        _geneator.release(cookie);
+    }
 
-    auto it_name = _map_uid_to_cookie.find(cookie_name);
-    if(it_name == _map_uid_to_cookie.end()){
+    auto &shard = getUidShard(uid);
+    lock_guard<mutex> lck(shard._mtx);
+    auto it_name = shard._map_uid_to_cookie.find(cookie_name);
+    if(it_name == shard._map_uid_to_cookie.end()){
         //该类型下未有任意用户登录
         return;
     }
@@ -231,16 +305,17 @@ void HttpCookieManager::onDelCookie(const string &cookie_name,const string &uid,
             break;
         }
         //该类型下未有任何用户在线，移除之
-        _map_uid_to_cookie.erase(it_name);
+        shard._map_uid_to_cookie.erase(it_name);
         break;
     }
 
 }
 
 string HttpCookieManager::getOldestCookie(const string &cookie_name,const string &uid, int max_client){
-    lock_guard<recursive_mutex> lck(_mtx_cookie);
-    auto it_name = _map_uid_to_cookie.find(cookie_name);
-    if(it_name == _map_uid_to_cookie.end()){
+    auto &shard = getUidShard(uid);
+    lock_guard<mutex> lck(shard._mtx);
+    auto it_name = shard._map_uid_to_cookie.find(cookie_name);
+    if(it_name == shard._map_uid_to_cookie.end()){
         //不存在该类型的cookie
         return "";
     }
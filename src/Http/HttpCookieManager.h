@@ -12,6 +12,7 @@
 #define SRC_HTTP_COOKIEMANAGER_H
 
 #include <memory>
+#include <atomic>
 #include <unordered_map>
 #include "Util/mini.h"
 #include "Util/util.h"
@@ -88,6 +89,11 @@ public:
      */
     bool isExpired();
 
+    /**
+     * 获取该cookie的过期时间戳(根据最近一次updateTime计算)，单位毫秒
+     */
+    uint64_t expireStamp() const;
+
     /**
      * 获取区域锁
      * @return
@@ -100,7 +106,8 @@ private:
     string _cookie_name;
     string _cookie_uuid;
     uint64_t _max_elapsed;
-    Ticker _ticker;
+    //最近一次刷新时间，原子变量，hls播放刷新cookie时无需加锁
+    atomic<uint64_t> _update_stamp;
     recursive_mutex _mtx;
     std::weak_ptr<HttpCookieManager> _manager;
 };
@@ -133,6 +140,25 @@ private:
     int _index = 0;
 };
 
+/**
+ * cookie管理器统计信息
+ */
+class HttpCookieStatistic {
+public:
+    //cookie个数
+    uint64_t cookie_count = 0;
+    //查找cookie次数
+    uint64_t lookup_count = 0;
+    //查找命中次数
+    uint64_t lookup_hit = 0;
+    //查找总耗时，单位纳秒
+    uint64_t lookup_total_ns = 0;
+    //单次查找最大耗时，单位纳秒
+    uint64_t lookup_max_ns = 0;
+    //定时器清理过期cookie个数
+    uint64_t expired_count = 0;
+};
+
 /**
  * cookie管理器，用于管理cookie的生成以及过期管理，同时实现了同账号异地挤占登录功能
  * 该对象实现了同账号最多登录若干个设备
@@ -188,6 +214,37 @@ public:
      * @return
      */
     bool delCookie(const HttpServerCookie::Ptr &cookie);
+
+    /**
+     * 获取统计信息，包括cookie个数以及查找耗时
+     */
+    HttpCookieStatistic getStatistic();
+
+private:
+    /**
+     * cookie分片，根据cookie随机字符串的hash分散到各个分片，
+     * 每个分片独立加锁，避免大并发hls播放时所有请求争抢同一把锁
+     */
+    class CookieShard {
+    public:
+        mutex _mtx;
+        unordered_map<string/*cookie*/, HttpServerCookie::Ptr/*cookie_data*/> _map_cookie;
+        //过期队列，按加入队列时计算的过期时间排序，定时器只检查到期的cookie，无需全量遍历
+        multimap<uint64_t/*expire stamp*/, std::weak_ptr<HttpServerCookie> > _expire_queue;
+    };
+
+    /**
+     * uid分片，记录某账号下多个cookie
+     */
+    class UidShard {
+    public:
+        mutex _mtx;
+        unordered_map<string/*cookie_name*/,unordered_map<string/*uid*/,map<uint64_t/*cookie time stamp*/,string/*cookie*/> > > _map_uid_to_cookie;
+    };
+
+    //分片个数，必须为2的幂
+    static constexpr size_t kShardCount = 64;
+
 private:
     HttpCookieManager();
     void onManager();
@@ -223,12 +280,24 @@ private:
      * @return 成功true
      */
     bool delCookie(const string &cookie_name,const string &cookie);
+
+    CookieShard &getCookieShard(const string &cookie);
+    UidShard &getUidShard(const string &uid);
+    void onLookup(uint64_t start_ns, bool hit);
+
 private:
-    unordered_map<string/*cookie_name*/,unordered_map<string/*cookie*/,HttpServerCookie::Ptr/*cookie_data*/> >_map_cookie;
-    unordered_map<string/*cookie_name*/,unordered_map<string/*uid*/,map<uint64_t/*cookie time stamp*/,string/*cookie*/> > >_map_uid_to_cookie;
-    recursive_mutex _mtx_cookie;
-    Timer::Ptr _timer;
+    CookieShard _cookie_shards[kShardCount];
+    UidShard _uid_shards[kShardCount];
+    mutex _mtx_geneator;
     RandStrGeneator _geneator;
+    Timer::Ptr _timer;
+
+    //统计信息
+    atomic<uint64_t> _lookup_count{0};
+    atomic<uint64_t> _lookup_hit{0};
+    atomic<uint64_t> _lookup_total_ns{0};
+    atomic<uint64_t> _lookup_max_ns{0};
+    atomic<uint64_t> _expired_count{0};
 };
 
 }//namespace mediakit
@@ -0,0 +1,110 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <sys/stat.h>
+#include "HttpFileCache.h"
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Common/config.h"
+
+using namespace toolkit;
+
+namespace mediakit {
+
+INSTANCE_IMP(HttpFileCache);
+
+std::shared_ptr<char> HttpFileCache::get(const string &path, size_t &size) {
+    GET_CONFIG(size_t, max_cache_size, Http::kFileCacheSize);
+    GET_CONFIG(size_t, max_obj_size, Http::kFileCacheMaxObjSize);
+    if (!max_cache_size || !max_obj_size) {
+        //未开启缓存
+        return nullptr;
+    }
+
+    struct stat file_stat;
+    if (0 != stat(path.data(), &file_stat)) {
+        return nullptr;
+    }
+
+    if ((size_t) file_stat.st_size > max_obj_size || (size_t) file_stat.st_size > max_cache_size || ::time(NULL) - file_stat.st_mtime < 2) {
+        //文件太大或者最近被修改过(可能正在被写入，比如m3u8文件)，不缓存
+        lock_guard<mutex> lck(_mtx);
+        ++_statistic.bypass;
+        return nullptr;
+    }
+
+    {
+        lock_guard<mutex> lck(_mtx);
+        auto it = _map.find(path);
+        if (it != _map.end()) {
+            auto &item = *(it->second);
+            if (item.mtime == file_stat.st_mtime && item.size == (size_t) file_stat.st_size) {
+                //命中缓存，移至LRU头部
+                _lru.splice(_lru.begin(), _lru, it->second);
+                ++_statistic.hit;
+                size = item.size;
+                return item.data;
+            }
+            //文件已经被修改，移除旧缓存
+            _cache_bytes -= item.size;
+            _lru.erase(it->second);
+            _map.erase(it);
+        }
+    }
+
+    //在锁外读取文件
+    size_t file_size = (size_t) file_stat.st_size;
+    std::shared_ptr<FILE> fp(fopen(path.data(), "rb"), [](FILE *fp) {
+        if (fp) {
+            fclose(fp);
+        }
+    });
+    if (!fp) {
+        return nullptr;
+    }
+    std::shared_ptr<char> data(new char[file_size + 1], [](char *ptr) {
+        delete[] ptr;
+    });
+    if (file_size && file_size != fread(data.get(), 1, file_size, fp.get())) {
+        WarnL << "read file failed:" << path;
+        return nullptr;
+    }
+
+    lock_guard<mutex> lck(_mtx);
+    ++_statistic.miss;
+    if (_map.find(path) == _map.end()) {
+        _lru.emplace_front(Item{path, data, file_size, file_stat.st_mtime});
+        _map.emplace(path, _lru.begin());
+        _cache_bytes += file_size;
+        evict_l(max_cache_size);
+    }
+    size = file_size;
+    return data;
+}
+
+void HttpFileCache::evict_l(size_t max_bytes) {
+    while (_cache_bytes > max_bytes && !_lru.empty()) {
+        auto &item = _lru.back();
+        _cache_bytes -= item.size;
+        _map.erase(item.path);
+        _lru.pop_back();
+        ++_statistic.eviction;
+    }
+}
+
+HttpFileCacheStatistic HttpFileCache::getStatistic() {
+    lock_guard<mutex> lck(_mtx);
+    HttpFileCacheStatistic ret = _statistic;
+    ret.item_count = _lru.size();
+    ret.cache_bytes = _cache_bytes;
+    return ret;
+}
+
+}//namespace mediakit
@@ -0,0 +1,87 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_HTTPFILECACHE_H
+#define ZLMEDIAKIT_HTTPFILECACHE_H
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+namespace mediakit {
+
+/**
+ * 文件缓存统计信息
+ */
+class HttpFileCacheStatistic {
+public:
+    //缓存文件个数
+    uint64_t item_count = 0;
+    //缓存占用字节数
+    uint64_t cache_bytes = 0;
+    //命中次数
+    uint64_t hit = 0;
+    //未命中次数(已加载进缓存)
+    uint64_t miss = 0;
+    //文件不符合缓存条件而直接读盘的次数
+    uint64_t bypass = 0;
+    //淘汰次数
+    uint64_t eviction = 0;
+};
+
+/**
+ * http热点文件内存缓存，以文件路径为key，文件修改时间和大小校验是否过期，
+ * 采用LRU淘汰，缓存数据为引用计数对象，被淘汰后正在发送的http body不受影响
+ */
+class HttpFileCache {
+public:
+    ~HttpFileCache() = default;
+
+    static HttpFileCache &Instance();
+
+    /**
+     * 获取文件内容
+     * @param path 文件绝对路径
+     * @param size 文件大小
+     * @return 文件内容，为空则表示未开启缓存或该文件不适合缓存
+     */
+    std::shared_ptr<char> get(const string &path, size_t &size);
+
+    /**
+     * 获取统计信息
+     */
+    HttpFileCacheStatistic getStatistic();
+
+private:
+    HttpFileCache() = default;
+    void evict_l(size_t max_bytes);
+
+private:
+    class Item {
+    public:
+        string path;
+        std::shared_ptr<char> data;
+        size_t size;
+        time_t mtime;
+    };
+
+    mutex _mtx;
+    size_t _cache_bytes = 0;
+    //头部为最近访问
+    list<Item> _lru;
+    unordered_map<string, list<Item>::iterator> _map;
+    HttpFileCacheStatistic _statistic;
+};
+
+}//namespace mediakit
+#endif //ZLMEDIAKIT_HTTPFILECACHE_H
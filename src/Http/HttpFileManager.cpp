@@ -17,6 +17,7 @@
 #include "Util/File.h"
 #include "HttpConst.h"
 #include "HttpSession.h"
+#include "HttpFileCache.h"
 #include "Record/HlsMediaSource.h"
 
 namespace mediakit {
@@ -546,6 +547,34 @@ void HttpResponseInvokerImp::responseFile(const StrCaseMap &requestHeader,
                                           const StrCaseMap &responseHeader,
                                           const string &filePath) const {
     StrCaseMap &httpHeader = const_cast<StrCaseMap &>(responseHeader);
+    auto &strRange = const_cast<StrCaseMap &>(requestHeader)["Range"];
+
+    size_t cacheSize = 0;
+    auto cacheData = HttpFileCache::Instance().get(filePath, cacheSize);
+    if (cacheData) {
+        //命中内存缓存，不需要打开文件
+        int code = 200;
+        size_t iRangeStart = 0;
+        size_t iRangeEnd = cacheSize - 1;
+        if (strRange.size() != 0) {
+            //分节下载
+            code = 206;
+            iRangeStart = atoll(FindField(strRange.data(), "bytes=", "-").data());
+            iRangeEnd = atoll(FindField(strRange.data(), "-", "\r\n").data());
+            if (iRangeEnd == 0 || iRangeEnd >= cacheSize) {
+                iRangeEnd = cacheSize - 1;
+            }
+            if (iRangeStart > iRangeEnd) {
+                iRangeStart = iRangeEnd + 1;
+            }
+            //分节下载返回Content-Range头
+            httpHeader.emplace("Content-Range", StrPrinter << "bytes " << iRangeStart << "-" << iRangeEnd << "/" << cacheSize << endl);
+        }
+        HttpBody::Ptr fileBody = std::make_shared<HttpFileBody>(cacheData, iRangeStart, iRangeEnd - iRangeStart + 1);
+        (*this)(code, httpHeader, fileBody);
+        return;
+    }
+
     std::shared_ptr<FILE> fp(fopen(filePath.data(), "rb"), [](FILE *fp) {
         if (fp) {
             fclose(fp);
@@ -563,7 +592,6 @@ void HttpResponseInvokerImp::responseFile(const StrCaseMap &requestHeader,
         return;
     }
 
-    auto &strRange = const_cast<StrCaseMap &>(requestHeader)["Range"];
     size_t iRangeStart = 0;
     size_t iRangeEnd = 0;
     size_t fileSize = HttpMultiFormBody::fileSize(fp.get());
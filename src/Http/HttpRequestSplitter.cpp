@@ -16,6 +16,9 @@ using namespace toolkit;
 namespace mediakit {
 
 void HttpRequestSplitter::input(const char *data,size_t len) {
+    if (!len && _remain_data.empty()) {
+        return;
+    }
     const char *ptr = data;
     if(!_remain_data.empty()){
         _remain_data.append(data,len);
@@ -26,7 +26,7 @@ public:
     /**
      * 添加数据
      * @param data 需要添加的数据
-     * @param len 数据长度
+     * @param len 数据长度，为0时重新处理缓存中尚未处理的数据
      */
     virtual void input(const char *data,size_t len);
 
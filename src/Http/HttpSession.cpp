@@ -12,6 +12,7 @@
 #include <sys/stat.h>
 #include <algorithm>
 #include "Common/config.h"
+#include "Common/StreamAffinity.h"
 #include "strCoding.h"
 #include "HttpSession.h"
 #include "HttpConst.h"
@@ -47,6 +48,8 @@ ssize_t HttpSession::onRecvHeader(const char *header,size_t len) {
         s_func_map.emplace("HEAD",&HttpSession::Handle_Req_HEAD);
     }, nullptr);
 
+    //在回复完毕前，后续流水线请求暂缓解析，保证按序回复
+    _response_pending = true;
     _parser.Parse(header);
     urlDecode(_parser);
     string cmd = _parser.Method();
@@ -85,7 +88,36 @@ void HttpSession::onRecvContent(const char *data,size_t len) {
 
 void HttpSession::onRecv(const Buffer::Ptr &pBuf) {
     _ticker.resetTime();
-    input(pBuf->data(),pBuf->size());
+    inputRequest(pBuf->data(), pBuf->size());
+}
+
+void HttpSession::inputRequest(const char *data, size_t len) {
+    //同一批数据中的多个(流水线)请求，其回复先缓存，处理完毕后合并为一次writev发送
+    setSendFlushFlag(false);
+    _parsing = true;
+    input(data, len);
+    _parsing = false;
+    if (!_is_live_stream) {
+        //直播时由FlvMuxer等自行控制flush标记
+        setSendFlushFlag(true);
+    }
+    getSock()->flushAll();
+}
+
+const char *HttpSession::onSearchPacketTail(const char *data, size_t len) {
+    if (_response_pending) {
+        //上个请求尚未回复完毕，后续请求先缓存，等回复完毕后再处理
+        return nullptr;
+    }
+    return HttpRequestSplitter::onSearchPacketTail(data, len);
+}
+
+void HttpSession::onResponseCompleted() {
+    _response_pending = false;
+    if (!_parsing) {
+        //处理缓存的流水线请求
+        inputRequest("", 0);
+    }
 }
 
 void HttpSession::onError(const SockException& err) {
@@ -231,10 +263,22 @@ bool HttpSession::checkLiveStream(const string &schema, const string  &url_suffi
         });
     };
 
-    auto flag = NoticeCenter::Instance().emitEvent(Broadcast::kBroadcastMediaPlayed, _mediaInfo, invoker, static_cast<SockInfo &>(*this));
-    if (!flag) {
-        //该事件无人监听,默认不鉴权
-        onRes("");
+    auto play = [weak_self, invoker, onRes]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            //本对象已经销毁
+            return;
+        }
+        auto flag = NoticeCenter::Instance().emitEvent(Broadcast::kBroadcastMediaPlayed, strong_self->_mediaInfo, invoker, static_cast<SockInfo &>(*strong_self));
+        if (!flag) {
+            //该事件无人监听,默认不鉴权
+            onRes("");
+        }
+    };
+
+    //迁移到该流所属的poller线程后再继续处理播放请求
+    if (!StreamAffinity::moveSession(*this, _mediaInfo, play)) {
+        play();
     }
     return true;
 }
@@ -265,12 +309,16 @@ bool HttpSession::checkLiveStreamFMP4(const function<void()> &cb){
             }
             strong_self->shutdown(SockException(Err_shutdown, "fmp4 ring buffer detached"));
         });
-        _fmp4_reader->setReadCB([weak_self](const FMP4MediaSource::RingDataType &fmp4_list) {
+        _fmp4_reader->setReadCBWithKey([weak_self](const FMP4MediaSource::RingDataType &fmp4_list, bool is_key) {
             auto strong_self = weak_self.lock();
             if (!strong_self) {
                 //本对象已经销毁
                 return;
             }
+            if (!strong_self->inputGroup(strong_self->getSock(), is_key)) {
+                //发送缓存积压严重，等待下一个关键帧(fmp4/ts无法单独丢弃非参考帧)
+                return;
+            }
             size_t i = 0;
             auto size = fmp4_list->size();
             fmp4_list->for_each([&](const FMP4Packet::Ptr &ts) {
@@ -305,12 +353,16 @@ bool HttpSession::checkLiveStreamTS(const function<void()> &cb){
             }
             strong_self->shutdown(SockException(Err_shutdown,"ts ring buffer detached"));
         });
-        _ts_reader->setReadCB([weak_self](const TSMediaSource::RingDataType &ts_list) {
+        _ts_reader->setReadCBWithKey([weak_self](const TSMediaSource::RingDataType &ts_list, bool is_key) {
             auto strong_self = weak_self.lock();
             if (!strong_self) {
                 //本对象已经销毁
                 return;
             }
+            if (!strong_self->inputGroup(strong_self->getSock(), is_key)) {
+                //发送缓存积压严重，等待下一个关键帧
+                return;
+            }
             size_t i = 0;
             auto size = ts_list->size();
             ts_list->for_each([&](const TSPacket::Ptr &ts) {
@@ -349,7 +401,8 @@ bool HttpSession::checkLiveStreamFlv(const function<void()> &cb){
             }
         }
 
-        start(getPoller(), rtmp_src);
+        GET_CONFIG(bool, flv_shared_tag, Http::kFlvSharedTag);
+        start(getPoller(), rtmp_src, flv_shared_tag);
     });
 }
 
@@ -407,11 +460,18 @@ void HttpSession::Handle_Req_GET_l(ssize_t &content_len, bool sendBody) {
     });
 }
 
-static string dateStr() {
-    char buf[64];
+static const string &dateStr() {
+    //每秒最多格式化一次
+    static thread_local time_t s_time = 0;
+    static thread_local string s_date;
     time_t tt = time(NULL);
-    strftime(buf, sizeof buf, "%a, %b %d %Y %H:%M:%S GMT", gmtime(&tt));
-    return buf;
+    if (tt != s_time) {
+        char buf[64];
+        strftime(buf, sizeof buf, "%a, %b %d %Y %H:%M:%S GMT", gmtime(&tt));
+        s_time = tt;
+        s_date = buf;
+    }
+    return s_date;
 }
 
 class AsyncSenderData {
@@ -475,7 +535,10 @@ private:
         }
         //文件写完了
         data->_read_complete = true;
-        if (!session->isSocketBusy() && data->_close_when_complete) {
+        if (!data->_close_when_complete) {
+            //可以处理下个流水线请求了
+            session->onResponseCompleted();
+        } else if (!session->isSocketBusy()) {
             shutdown(session);
         }
     }
@@ -525,10 +588,13 @@ void HttpSession::sendResponse(int code,
     headerOut.emplace(kServer, SERVER_NAME);
     headerOut.emplace(kConnection, bClose ? "close" : "keep-alive");
     if(!bClose){
-        string keepAliveString = "timeout=";
-        keepAliveString += to_string(keepAliveSec);
-        keepAliveString += ", max=100";
-        headerOut.emplace(kKeepAlive,std::move(keepAliveString));
+        static thread_local uint32_t s_keep_alive_sec = 0;
+        static thread_local string s_keep_alive;
+        if (s_keep_alive_sec != keepAliveSec || s_keep_alive.empty()) {
+            s_keep_alive_sec = keepAliveSec;
+            s_keep_alive = "timeout=" + to_string(keepAliveSec) + ", max=100";
+        }
+        headerOut.emplace(kKeepAlive, s_keep_alive);
     }
 
     if(!_origin.empty()){
@@ -555,33 +621,68 @@ void HttpSession::sendResponse(int code,
         headerOut.emplace(kContentType,std::move(strContentType));
     }
 
-    //发送http头
-    string str;
-    str.reserve(256);
-    str += "HTTP/1.1 " ;
-    str += to_string(code);
-    str += ' ';
-    str += getHttpStatusMessage(code) ;
-    str += "\r\n";
-    for (auto &pr : header) {
-        str += pr.first ;
-        str += ": ";
-        str += pr.second;
-        str += "\r\n";
+    if (bClose) {
+        //回复后就关闭连接，无需与后续回复合并发送
+        setSendFlushFlag(true);
     }
-    str += "\r\n";
-    SockSender::send(std::move(str));
+
+    //发送http头，直接渲染至socket缓存池中可复用的buffer
+    auto status = getHttpStatusMessage(code);
+    char code_str[16];
+    auto code_len = snprintf(code_str, sizeof(code_str), "%d ", code);
+    size_t header_size = 9 + code_len + strlen(status) + 4;
+    for (auto &pr : header) {
+        header_size += pr.first.size() + pr.second.size() + 4;
+    }
+    auto header_buf = obtainBuffer();
+    header_buf->setCapacity(header_size + 1);
+    auto ptr = header_buf->data();
+    auto append = [&ptr](const char *data, size_t len) {
+        memcpy(ptr, data, len);
+        ptr += len;
+    };
+    append("HTTP/1.1 ", 9);
+    append(code_str, code_len);
+    append(status, strlen(status));
+    append("\r\n", 2);
+    for (auto &pr : header) {
+        append(pr.first.data(), pr.first.size());
+        append(": ", 2);
+        append(pr.second.data(), pr.second.size());
+        append("\r\n", 2);
+    }
+    append("\r\n", 2);
+    header_buf->setSize(header_size);
+    send(std::move(header_buf));
     _ticker.resetTime();
 
     if(!size){
         //没有body
         if(bClose){
             shutdown(SockException(Err_shutdown,StrPrinter << "close connection after send http header completed with status code:" << code));
+        } else if (!no_content_length) {
+            onResponseCompleted();
         }
         return;
     }
 
     GET_CONFIG(uint32_t, sendBufSize, Http::kSendBufSize);
+    if ((size_t) size <= sendBufSize) {
+        //body较小，直接读取并与http头合并发送，无需等待socket flush事件
+        auto buf = body->readData(size);
+        if (buf) {
+            send(std::move(buf));
+        }
+        if (!body->remainSize()) {
+            if (bClose) {
+                shutdown(SockException(Err_shutdown, StrPrinter << "close connection after send http body completed."));
+            } else {
+                onResponseCompleted();
+            }
+            return;
+        }
+        //body不支持同步读取或未读完，剩余部分异步发送
+    }
     if(body->remainSize() > sendBufSize){
         //文件下载提升发送性能
         setSocketFlags();
@@ -780,4 +881,12 @@ std::shared_ptr<FlvMuxer> HttpSession::getSharedPtr(){
     return dynamic_pointer_cast<FlvMuxer>(shared_from_this());
 }
 
+bool HttpSession::onRtmpGroup(bool is_key) {
+    return inputGroup(getSock(), is_key);
+}
+
+bool HttpSession::onDropRtmp(const RtmpPacket::Ptr &pkt) {
+    return dropFrame([&]() { return pkt->isNonReferenceFrame(); });
+}
+
 } /* namespace mediakit */
@@ -21,6 +21,7 @@
 #include "HttpFileManager.h"
 #include "TS/TSMediaSource.h"
 #include "FMP4/FMP4MediaSource.h"
+#include "Common/SendQueuePolicy.h"
 
 using namespace std;
 using namespace toolkit;
@@ -30,7 +31,8 @@ namespace mediakit {
 class HttpSession: public TcpSession,
                    public FlvMuxer,
                    public HttpRequestSplitter,
-                   public WebSocketSplitter {
+                   public WebSocketSplitter,
+                   public SendQueuePolicy {
 public:
     typedef StrCaseMap KeyValue;
     typedef HttpResponseInvokerImp HttpResponseInvoker;
@@ -55,10 +57,13 @@ protected:
     void onWrite(const Buffer::Ptr &data, bool flush) override ;
     void onDetach() override;
     std::shared_ptr<FlvMuxer> getSharedPtr() override;
+    bool onRtmpGroup(bool is_key) override;
+    bool onDropRtmp(const RtmpPacket::Ptr &pkt) override;
 
     //HttpRequestSplitter override
     ssize_t onRecvHeader(const char *data,size_t len) override;
     void onRecvContent(const char *data,size_t len) override;
+    const char *onSearchPacketTail(const char *data, size_t len) override;
 
     /**
      * 重载之用于处理不定长度的content
@@ -123,9 +128,25 @@ private:
     //设置socket标志
     void setSocketFlags();
 
+    /**
+     * 输入请求数据，流水线请求的回复会合并发送
+     * @param data 请求数据
+     * @param len 数据长度，为0时处理缓存的流水线请求
+     */
+    void inputRequest(const char *data, size_t len);
+
+    /**
+     * 当前请求回复完毕(http头与body都已写入socket)，开始处理下个流水线请求
+     */
+    void onResponseCompleted();
+
 private:
     bool _is_live_stream = false;
     bool _live_over_websocket = false;
+    //当前请求是否还未回复完毕
+    bool _response_pending = false;
+    //是否正在解析请求
+    bool _parsing = false;
     //消耗的总流量
     uint64_t _total_bytes_usage = 0;
     string _origin;
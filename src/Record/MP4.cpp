@@ -104,6 +104,14 @@ int mp4_writer_init_segment(mp4_writer_t* mp4){
     }
 }
 
+int mp4_writer_flush_fragment(mp4_writer_t* mp4){
+    if (mp4->is_fmp4) {
+        return fmp4_writer_flush_fragment(mp4->u.fmp4);
+    } else {
+        return -1;
+    }
+}
+
 /////////////////////////////////////////////////MP4FileIO/////////////////////////////////////////////////
 
 static struct mov_buffer_t s_io = {
@@ -197,6 +205,12 @@ void MP4FileDisk::closeFile() {
     _file = nullptr;
 }
 
+void MP4FileDisk::flush() {
+    if (_file) {
+        fflush(_file.get());
+    }
+}
+
 int MP4FileDisk::onRead(void *data, size_t bytes) {
     if (bytes == fread(data, 1, bytes, _file.get())){
         return 0;
@@ -204,6 +218,10 @@ int MP4FileDisk::onRead(void *data, size_t bytes) {
     return 0 != ferror(_file.get()) ? ferror(_file.get()) : -1 /*EOF*/;
 }
 
+size_t MP4FileDisk::readSome(void *data, size_t bytes) {
+    return fread(data, 1, bytes, _file.get());
+}
+
 int MP4FileDisk::onWrite(const void *data, size_t bytes) {
     return bytes == fwrite(data, 1, bytes, _file.get()) ? 0 : ferror(_file.get());
 }
@@ -34,6 +34,7 @@ int mp4_writer_write(mp4_writer_t* mp4, int track, const void* data, size_t byte
 int mp4_writer_write_l(mp4_writer_t* mp4, int track, const void* data, size_t bytes, int64_t pts, int64_t dts, int flags, int add_nalu_size);
 int mp4_writer_save_segment(mp4_writer_t* mp4);
 int mp4_writer_init_segment(mp4_writer_t* mp4);
+int mp4_writer_flush_fragment(mp4_writer_t* mp4);
 
 //mp4文件IO的抽象接口类
 class MP4FileIO : public std::enable_shared_from_this<MP4FileIO> {
@@ -107,7 +108,18 @@ public:
      */
     void closeFile();
 
+    /**
+     * 把文件io缓存写入系统(内核页缓存)，进程崩溃时不会丢失，但不保证断电时已落盘
+     */
+    void flush();
+
 protected:
+    /**
+     * 尽量读取一定数据，文件末尾处可能读不满
+     * @return 实际读取字节数
+     */
+    size_t readSome(void *data, size_t bytes);
+
     size_t onTell() override;
     int onSeek(size_t offset) override;
     int onRead(void *data, size_t bytes) override;
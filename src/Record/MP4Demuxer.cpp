@@ -11,6 +11,7 @@
 #ifdef ENABLE_MP4
 #include "MP4Demuxer.h"
 #include "Util/logger.h"
+#include "Common/config.h"
 #include "Extension/H265.h"
 #include "Extension/H264.h"
 #include "Extension/AAC.h"
@@ -144,6 +145,59 @@ void MP4Demuxer::onAudioTrack(uint32_t track_id, uint8_t object, int channel_cou
     }
 }
 
+size_t MP4Demuxer::onTell() {
+    return _offset;
+}
+
+int MP4Demuxer::onSeek(size_t offset) {
+    //只记录位置，预读缓存在读取时判断是否命中
+    _offset = offset;
+    return 0;
+}
+
+int MP4Demuxer::onRead(void *data, size_t bytes) {
+    if (_read_ahead && _offset >= _read_ahead_offset && _offset + bytes <= _read_ahead_offset + _read_ahead->size()) {
+        //命中预读缓存
+        memcpy(data, _read_ahead->data() + (_offset - _read_ahead_offset), bytes);
+        _offset += bytes;
+        return 0;
+    }
+
+    GET_CONFIG(size_t, read_ahead_size, Record::kReadAheadSize);
+    if (bytes * 2 > read_ahead_size) {
+        //未开启预读或者读取的数据太大(比如moov、大的关键帧)，直接读文件
+        auto ret = MP4FileDisk::onSeek(_offset);
+        if (ret == 0) {
+            ret = MP4FileDisk::onRead(data, bytes);
+        }
+        if (ret == 0) {
+            _offset += bytes;
+        }
+        return ret;
+    }
+
+    //从当前位置开始重新预读
+    if (!_read_ahead) {
+        _read_ahead = std::make_shared<BufferRaw>();
+    }
+    _read_ahead->setCapacity(read_ahead_size);
+    _read_ahead->setSize(0);
+    _read_ahead_offset = _offset;
+    auto ret = MP4FileDisk::onSeek(_offset);
+    if (ret != 0) {
+        return ret;
+    }
+    auto size = readSome(_read_ahead->data(), read_ahead_size);
+    _read_ahead->setSize(size);
+    if (size < bytes) {
+        //文件长度不够
+        return -1;
+    }
+    memcpy(data, _read_ahead->data(), bytes);
+    _offset += bytes;
+    return 0;
+}
+
 int64_t MP4Demuxer::seekTo(int64_t stamp_ms) {
     if(0 != mov_reader_seek(_mov_reader.get(),&stamp_ms)){
         return -1;
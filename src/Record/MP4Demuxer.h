@@ -60,6 +60,12 @@ public:
      */
     uint64_t getDurationMS() const;
 
+protected:
+    /// MP4FileIO override，通过预读缓存读文件
+    size_t onTell() override;
+    int onSeek(size_t offset) override;
+    int onRead(void *data, size_t bytes) override;
+
 private:
     int getAllTracks();
     void onVideoTrack(uint32_t track_id, uint8_t object, int width, int height, const void *extra, size_t bytes);
@@ -71,6 +77,12 @@ private:
     uint64_t _duration_ms = 0;
     map<int, Track::Ptr> _track_to_codec;
     ResourcePool<BufferRaw> _buffer_pool;
+    //逻辑读写位置
+    size_t _offset = 0;
+    //预读缓存在文件中的起始位置
+    size_t _read_ahead_offset = 0;
+    //预读缓存
+    BufferRaw::Ptr _read_ahead;
 };
 
 
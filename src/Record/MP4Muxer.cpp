@@ -29,12 +29,41 @@ void MP4Muxer::openMP4(const string &file){
 
 MP4FileIO::Writer MP4Muxer::createWriter(){
     GET_CONFIG(bool, mp4FastStart, Record::kFastStart);
+    GET_CONFIG(bool, enableFmp4, Record::kEnableFmp4);
+    _fmp4 = enableFmp4;
+    if (_fmp4) {
+        //fmp4模式下每个视频关键帧生成一个moof/mdat分片，关闭文件时只写入mfra，无需写moov
+        return _mp4_file->createWriter(0, true);
+    }
     return _mp4_file->createWriter(mp4FastStart ? MOV_FLAG_FASTSTART : 0, false);
 }
 
+void MP4Muxer::inputFrame(const Frame::Ptr &frame) {
+    if (!_fmp4 || !_mp4_file) {
+        MP4MuxerInterface::inputFrame(frame);
+        return;
+    }
+    if (!haveVideo() && frame->getTrackType() == TrackAudio) {
+        //libmov只在视频关键帧处切分片，纯音频时按时长切分片，否则所有数据都缓存在内存中直到关闭文件
+        if (_fragment_dts == -1) {
+            _fragment_dts = frame->dts();
+        } else if (frame->dts() >= _fragment_dts + kAudioFragmentMS || frame->dts() < _fragment_dts) {
+            _fragment_dts = frame->dts();
+            flushFragment();
+            _mp4_file->flush();
+        }
+    }
+    MP4MuxerInterface::inputFrame(frame);
+    if (frame->getTrackType() == TrackVideo && frame->keyFrame()) {
+        //遇到关键帧时，之前的分片已经写入文件io缓存，写入系统后进程崩溃也不会丢失(不调用fsync，断电时仍可能丢失)
+        _mp4_file->flush();
+    }
+}
+
 void MP4Muxer::closeMP4(){
     MP4MuxerInterface::resetTracks();
     _mp4_file = nullptr;
+    _fragment_dts = -1;
 }
 
 void MP4Muxer::resetTracks() {
@@ -52,6 +81,12 @@ void MP4MuxerInterface::initSegment(){
     mp4_writer_init_segment(_mov_writter.get());
 }
 
+void MP4MuxerInterface::flushFragment(){
+    if (_mov_writter) {
+        mp4_writer_flush_fragment(_mov_writter.get());
+    }
+}
+
 bool MP4MuxerInterface::haveVideo() const{
     return _have_video;
 }
@@ -58,6 +58,11 @@ public:
      */
     void initSegment();
 
+    /**
+     * 立即把已缓存的帧写成一个fmp4分片(moof/mdat)，不等待下一个视频关键帧
+     */
+    void flushFragment();
+
 protected:
     virtual MP4FileIO::Writer createWriter() = 0;
 
@@ -99,10 +104,22 @@ public:
      */
     void closeMP4();
 
+    /**
+     * 输入帧
+     */
+    void inputFrame(const Frame::Ptr &frame) override;
+
 protected:
     MP4FileIO::Writer createWriter() override;
 
 private:
+    //纯音频fmp4录制时每个分片的时长，单位毫秒
+    static constexpr int64_t kAudioFragmentMS = 2000;
+
+private:
+    bool _fmp4 = false;
+    //纯音频时当前分片第一帧的时间戳
+    int64_t _fragment_dts = -1;
     string _file_name;
     MP4FileDisk::Ptr _mp4_file;
 };
@@ -0,0 +1,174 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <sys/stat.h>
+#include "MP4RecordIndex.h"
+#include "Util/File.h"
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Util/uv_errno.h"
+
+using namespace toolkit;
+
+namespace mediakit {
+
+//索引文件每行一个切片，格式为:
+//开始时间(毫秒) 结束时间(毫秒) 相对文件路径 关键帧时间戳列表(逗号分隔，没有关键帧时为-)
+#define INDEX_FILE_NAME "mp4_record.idx"
+
+uint32_t MP4SegmentIndex::seekKeyFrame(uint64_t stamp_ms) const {
+    if (key_frames.empty() || stamp_ms <= start_ms) {
+        return 0;
+    }
+    auto offset = stamp_ms - start_ms;
+    //第一个大于offset的关键帧
+    auto it = upper_bound(key_frames.begin(), key_frames.end(), offset);
+    if (it == key_frames.begin()) {
+        return 0;
+    }
+    return *(--it);
+}
+
+INSTANCE_IMP(MP4RecordIndex);
+
+string MP4RecordIndex::getIndexPath(const string &record_path) {
+    return record_path + INDEX_FILE_NAME;
+}
+
+void MP4RecordIndex::append(const string &record_path, const MP4SegmentIndex &segment) {
+    _StrPrinter printer;
+    printer << segment.start_ms << " " << segment.end_ms << " " << segment.file << " ";
+    if (segment.key_frames.empty()) {
+        printer << "-";
+    }
+    for (size_t i = 0; i < segment.key_frames.size(); ++i) {
+        if (i) {
+            printer << ",";
+        }
+        printer << segment.key_frames[i];
+    }
+    printer << "\n";
+    string line = printer;
+
+    auto index_path = getIndexPath(record_path);
+    //stdio缓冲可能把一行拆成多次write，多个线程同时追加会交错，所以按流加锁
+    auto index = getStreamIndex(record_path);
+    lock_guard<mutex> lck(index->mtx);
+    auto fp = File::create_file(index_path.data(), "ab");
+    if (!fp) {
+        WarnL << "打开mp4录像索引文件失败:" << index_path << " " << get_uv_errmsg();
+        return;
+    }
+    fwrite(line.data(), 1, line.size(), fp);
+    fclose(fp);
+}
+
+std::shared_ptr<MP4RecordIndex::StreamIndex> MP4RecordIndex::getStreamIndex(const string &record_path) {
+    lock_guard<mutex> lck(_mtx);
+    auto &ret = _streams[record_path];
+    if (!ret) {
+        ret = std::make_shared<StreamIndex>();
+    }
+    return ret;
+}
+
+void MP4RecordIndex::loadIndex_l(const string &record_path, StreamIndex &index) {
+    auto index_path = getIndexPath(record_path);
+    struct stat file_stat;
+    if (0 != stat(index_path.data(), &file_stat)) {
+        //索引文件不存在或已被删除
+        index.loaded_bytes = 0;
+        index.segments.clear();
+        index.max_duration = 0;
+        return;
+    }
+    if ((size_t) file_stat.st_size < index.loaded_bytes) {
+        //索引文件被截断或重建，重新加载
+        index.loaded_bytes = 0;
+        index.segments.clear();
+        index.max_duration = 0;
+    }
+    if ((size_t) file_stat.st_size == index.loaded_bytes) {
+        //没有新增切片
+        return;
+    }
+
+    auto fp = fopen(index_path.data(), "rb");
+    if (!fp) {
+        return;
+    }
+    fseek(fp, index.loaded_bytes, SEEK_SET);
+    string content;
+    content.resize(file_stat.st_size - index.loaded_bytes);
+    content.resize(fread((char *) content.data(), 1, content.size(), fp));
+    fclose(fp);
+
+    //只处理完整的行，最后一行可能正在被写入
+    auto end = content.rfind('\n');
+    if (end == string::npos) {
+        return;
+    }
+    index.loaded_bytes += end + 1;
+    content.resize(end);
+
+    bool sorted = true;
+    for (auto &line : split(content, "\n")) {
+        auto fields = split(line, " ");
+        if (fields.size() != 4) {
+            WarnL << "mp4录像索引格式错误:" << line;
+            continue;
+        }
+        MP4SegmentIndex segment;
+        segment.start_ms = strtoull(fields[0].data(), nullptr, 10);
+        segment.end_ms = strtoull(fields[1].data(), nullptr, 10);
+        segment.file = fields[2];
+        if (fields[3] != "-") {
+            for (auto &key : split(fields[3], ",")) {
+                segment.key_frames.emplace_back((uint32_t) strtoul(key.data(), nullptr, 10));
+            }
+        }
+        if (!index.segments.empty() && index.segments.back().start_ms > segment.start_ms) {
+            //切片在后台线程关闭，追加顺序可能与录制顺序不一致
+            sorted = false;
+        }
+        index.max_duration = max(index.max_duration, segment.end_ms - segment.start_ms);
+        index.segments.emplace_back(std::move(segment));
+    }
+
+    if (!sorted) {
+        stable_sort(index.segments.begin(), index.segments.end(), [](const MP4SegmentIndex &a, const MP4SegmentIndex &b) {
+            return a.start_ms < b.start_ms;
+        });
+    }
+}
+
+vector<MP4SegmentIndex> MP4RecordIndex::find(const string &record_path, uint64_t start_ms, uint64_t end_ms) {
+    vector<MP4SegmentIndex> ret;
+    auto index = getStreamIndex(record_path);
+    lock_guard<mutex> lck(index->mtx);
+    loadIndex_l(record_path, *index);
+
+    auto &segments = index->segments;
+    //开始时间早于start_ms - max_duration的切片不可能覆盖start_ms
+    auto min_start = start_ms > index->max_duration ? start_ms - index->max_duration : 0;
+    auto it = lower_bound(segments.begin(), segments.end(), min_start, [](const MP4SegmentIndex &segment, uint64_t stamp) {
+        return segment.start_ms < stamp;
+    });
+    for (; it != segments.end() && it->start_ms <= end_ms; ++it) {
+        if (it->end_ms < start_ms) {
+            continue;
+        }
+        ret.emplace_back(*it);
+    }
+    return ret;
+}
+
+}//namespace mediakit
@@ -0,0 +1,101 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_MP4RECORDINDEX_H
+#define ZLMEDIAKIT_MP4RECORDINDEX_H
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+using namespace std;
+
+namespace mediakit {
+
+/**
+ * 一个mp4录像切片的索引信息
+ */
+class MP4SegmentIndex {
+public:
+    //相对于录像根目录的文件路径，例如 2020-01-01/12-00-00.mp4
+    string file;
+    //切片第一帧对应的系统时间(unix时间戳，单位毫秒)
+    uint64_t start_ms = 0;
+    //切片最后一帧对应的系统时间(unix时间戳，单位毫秒)
+    uint64_t end_ms = 0;
+    //所有视频关键帧相对于切片开始的时间戳(单位毫秒)，递增
+    vector<uint32_t> key_frames;
+
+    /**
+     * 查找不晚于指定时间的最近关键帧
+     * @param stamp_ms unix时间戳，单位毫秒
+     * @return 关键帧相对于切片开始的时间戳，没有关键帧时返回0
+     */
+    uint32_t seekKeyFrame(uint64_t stamp_ms) const;
+};
+
+/**
+ * mp4录像时间索引，每个流的录像根目录下有一个只追加的索引文件，
+ * MP4Recorder每生成一个切片追加一行，查询时二分查找定位切片及关键帧，
+ * 无需扫描目录或解析mp4文件的moov
+ */
+class MP4RecordIndex {
+public:
+    ~MP4RecordIndex() = default;
+
+    static MP4RecordIndex &Instance();
+
+    /**
+     * 获取索引文件路径
+     * @param record_path 流的录像根目录，以/结尾
+     */
+    static string getIndexPath(const string &record_path);
+
+    /**
+     * 追加切片索引
+     * @param record_path 流的录像根目录，以/结尾
+     * @param segment 切片索引
+     */
+    void append(const string &record_path, const MP4SegmentIndex &segment);
+
+    /**
+     * 查找与时间范围有交集的所有切片，按开始时间排序
+     * @param record_path 流的录像根目录，以/结尾
+     * @param start_ms 开始时间(unix时间戳，单位毫秒)
+     * @param end_ms 结束时间(unix时间戳，单位毫秒)
+     */
+    vector<MP4SegmentIndex> find(const string &record_path, uint64_t start_ms, uint64_t end_ms);
+
+private:
+    MP4RecordIndex() = default;
+
+    class StreamIndex {
+    public:
+        //保护索引加载以及索引文件追加
+        mutex mtx;
+        //已经加载的索引文件长度，索引文件只追加，所以只需增量加载
+        size_t loaded_bytes = 0;
+        //按start_ms排序
+        vector<MP4SegmentIndex> segments;
+        //切片最大时长，用于二分查找时向前扩展
+        uint64_t max_duration = 0;
+    };
+
+    std::shared_ptr<StreamIndex> getStreamIndex(const string &record_path);
+    static void loadIndex_l(const string &record_path, StreamIndex &index);
+
+private:
+    mutex _mtx;
+    unordered_map<string, std::shared_ptr<StreamIndex> > _streams;
+};
+
+}//namespace mediakit
+#endif //ZLMEDIAKIT_MP4RECORDINDEX_H
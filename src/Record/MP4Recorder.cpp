@@ -53,6 +53,10 @@ void MP4Recorder::createFile() {
                 + strDate + "/"
                 + strTime + ".mp4";
 
+    _segment = MP4SegmentIndex();
+    _segment.file = strDate + "/" + strTime + ".mp4";
+    _have_frame = false;
+
     try {
         _muxer = std::make_shared<MP4Muxer>();
         _muxer->openMP4(strFileTmp);
@@ -73,7 +77,10 @@ void MP4Recorder::asyncClose() {
     auto strFileTmp = _strFileTmp;
     auto strFile = _strFile;
     auto info = _info;
-    WorkThreadPool::Instance().getExecutor()->async([muxer,strFileTmp,strFile,info]() {
+    auto segment = _segment;
+    auto have_frame = _have_frame;
+    auto strPath = _strPath;
+    WorkThreadPool::Instance().getExecutor()->async([muxer,strFileTmp,strFile,info,segment,have_frame,strPath]() {
         //获取文件录制时间，放在关闭mp4之前是为了忽略关闭mp4执行时间
         const_cast<RecordInfo&>(info).time_len = (float)(::time(NULL) - info.start_time);
         //关闭mp4非常耗时，所以要放在后台线程执行
@@ -91,6 +98,11 @@ void MP4Recorder::asyncClose() {
         //临时文件名改成正式文件名，防止mp4未完成时被访问
         rename(strFileTmp.data(),strFile.data());
 
+        if (have_frame) {
+            //追加时间索引，用于按时间快速定位切片和关键帧
+            MP4RecordIndex::Instance().append(strPath, segment);
+        }
+
         /////record 业务逻辑//////
         NoticeCenter::Instance().emitEvent(Broadcast::kBroadcastRecordMP4,info);
     });
@@ -117,6 +129,22 @@ void MP4Recorder::inputFrame(const Frame::Ptr &frame) {
     if(_muxer){
         //生成mp4文件
         _muxer->inputFrame(frame);
+        updateIndex(frame);
+    }
+}
+
+void MP4Recorder::updateIndex(const Frame::Ptr &frame) {
+    if (!_have_frame) {
+        _have_frame = true;
+        _first_dts = frame->dts();
+        _segment.start_ms = getCurrentMillisecond(true);
+    }
+    auto offset = frame->dts() > _first_dts ? frame->dts() - _first_dts : 0;
+    _segment.end_ms = MAX(_segment.end_ms, _segment.start_ms + offset);
+    if (frame->getTrackType() == TrackVideo && frame->keyFrame()) {
+        if (_segment.key_frames.empty() || _segment.key_frames.back() != offset) {
+            _segment.key_frames.emplace_back(offset);
+        }
     }
 }
 
@@ -132,6 +160,7 @@ void MP4Recorder::resetTracks() {
     closeFile();
     _tracks.clear();
     _haveVideo = false;
+    _have_frame = false;
     _createFileTicker.resetTime();
 }
 
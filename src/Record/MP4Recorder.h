@@ -20,6 +20,7 @@
 #include "Util/TimeTicker.h"
 #include "Common/MediaSink.h"
 #include "MP4Muxer.h"
+#include "MP4RecordIndex.h"
 
 using namespace toolkit;
 
@@ -54,6 +55,7 @@ private:
     void createFile();
     void closeFile();
     void asyncClose();
+    void updateIndex(const Frame::Ptr &frame);
 private:
     string _strPath;
     string _strFile;
@@ -63,6 +65,10 @@ private:
     bool _haveVideo = false;
     MP4Muxer::Ptr _muxer;
     list<Track::Ptr> _tracks;
+    //当前切片的时间索引
+    MP4SegmentIndex _segment;
+    uint32_t _first_dts = 0;
+    bool _have_frame = false;
 };
 
 #endif ///ENABLE_MP4
@@ -22,23 +22,29 @@ FlvMuxer::FlvMuxer() {
 FlvMuxer::~FlvMuxer() {
 }
 
-void FlvMuxer::start(const EventPoller::Ptr &poller,const RtmpMediaSource::Ptr &media) {
+void FlvMuxer::start(const EventPoller::Ptr &poller,const RtmpMediaSource::Ptr &media, bool shared_tag) {
     if(!media){
         throw std::runtime_error("RtmpMediaSource 无效");
     }
     if(!poller->isCurrentThread()){
         weak_ptr<FlvMuxer> weakSelf = getSharedPtr();
         //延时两秒启动录制，目的是为了等待config帧收集完毕
-        poller->doDelayTask(2000,[weakSelf,poller,media](){
+        poller->doDelayTask(2000,[weakSelf,poller,media,shared_tag](){
             auto strongSelf = weakSelf.lock();
             if(strongSelf){
-                strongSelf->start(poller,media);
+                strongSelf->start(poller,media,shared_tag);
             }
             return 0;
         });
         return;
     }
 
+    _shared_tag = shared_tag;
+    if (_shared_tag) {
+        //通知媒体源开始预先生成flv tag
+        _flv_tag_token = media->enableFlvTag();
+    }
+
     onWriteFlvHeader(media);
 
     std::weak_ptr<FlvMuxer> weakSelf = getSharedPtr();
@@ -53,16 +59,23 @@ void FlvMuxer::start(const EventPoller::Ptr &poller,const RtmpMediaSource::Ptr &
 
     //音频同步于视频
     _stamp[0].syncTo(_stamp[1]);
-    _ring_reader->setReadCB([weakSelf](const RtmpMediaSource::RingDataType &pkt){
+    _ring_reader->setReadCBWithKey([weakSelf](const RtmpMediaSource::RingDataType &pkt, bool is_key){
         auto strongSelf = weakSelf.lock();
         if(!strongSelf){
             return;
         }
+        if (!strongSelf->onRtmpGroup(is_key)) {
+            return;
+        }
 
         size_t i = 0;
         auto size = pkt->size();
         pkt->for_each([&](const RtmpPacket::Ptr &rtmp){
-            strongSelf->onWriteRtmp(rtmp, ++i == size);
+            bool flush = ++i == size;
+            if (strongSelf->onDropRtmp(rtmp)) {
+                return;
+            }
+            strongSelf->onWriteRtmp(rtmp, flush);
         });
     });
 }
@@ -116,38 +129,48 @@ void FlvMuxer::onWriteFlvHeader(const RtmpMediaSource::Ptr &mediaSrc) {
 
 
 
-#if defined(_WIN32)
-#pragma pack(push, 1)
-#endif // defined(_WIN32)
-
-class RtmpTagHeader {
-public:
-    uint8_t type = 0;
-    uint8_t data_size[3] = {0};
-    uint8_t timestamp[3] = {0};
-    uint8_t timestamp_ex = 0;
-    uint8_t streamid[3] = {0}; /* Always 0. */
-}PACKED;
-
-#if defined(_WIN32)
-#pragma pack(pop)
-#endif // defined(_WIN32)
-
 void FlvMuxer::onWriteFlvTag(const RtmpPacket::Ptr &pkt, uint32_t time_stamp , bool flush) {
-    onWriteFlvTag(pkt->type_id, pkt, time_stamp, flush);
+    auto body_size = pkt->totalSize();
+    onWriteFlvTagHeader(pkt->type_id, body_size, time_stamp);
+    //tag data，引用帧数据的分片直接写出，不拷贝
+    onWrite(pkt, false);
+    for (auto &slice : pkt->slices) {
+        onWrite(slice, false);
+    }
+    onWriteFlvTagSize(body_size, flush);
 }
 
 void FlvMuxer::onWriteFlvTag(uint8_t type, const Buffer::Ptr &buffer, uint32_t time_stamp, bool flush) {
+    onWriteFlvTagHeader(type, buffer->size(), time_stamp);
+    //tag data
+    onWrite(buffer, false);
+    onWriteFlvTagSize(buffer->size(), flush);
+}
+
+void FlvMuxer::onWriteSharedFlvTag(const Buffer::Ptr &flv_tag, uint32_t time_stamp, bool flush) {
+    //flv tag在所有播放器间共享，不能修改；只拷贝tag头并修改时间戳
+    auto header = std::make_shared<BufferRaw>(sizeof(RtmpTagHeader));
+    header->assign(flv_tag->data(), sizeof(RtmpTagHeader));
+    auto tag_header = (RtmpTagHeader *) header->data();
+    tag_header->timestamp_ex = (uint8_t) ((time_stamp >> 24) & 0xff);
+    set_be24(tag_header->timestamp, time_stamp & 0xFFFFFF);
+    onWrite(header, false);
+    //tag data与PreviousTagSize直接引用共享的flv tag
+    onWrite(std::make_shared<BufferPartial>(flv_tag, sizeof(RtmpTagHeader), flv_tag->size() - sizeof(RtmpTagHeader)), flush);
+}
+
+void FlvMuxer::onWriteFlvTagHeader(uint8_t type, size_t body_size, uint32_t time_stamp) {
     RtmpTagHeader header;
     header.type = type;
-    set_be24(header.data_size, (uint32_t)buffer->size());
+    set_be24(header.data_size, (uint32_t)body_size);
     header.timestamp_ex = (uint8_t) ((time_stamp >> 24) & 0xff);
     set_be24(header.timestamp, time_stamp & 0xFFFFFF);
     //tag header
     onWrite(std::make_shared<BufferRaw>((char *)&header, sizeof(header)), false);
-    //tag data
-    onWrite(buffer, false);
-    uint32_t size = htonl((uint32_t)(buffer->size() + sizeof(header)));
+}
+
+void FlvMuxer::onWriteFlvTagSize(size_t body_size, bool flush) {
+    uint32_t size = htonl((uint32_t)(body_size + sizeof(RtmpTagHeader)));
     //PreviousTagSize
     onWrite(std::make_shared<BufferRaw>((char *)&size,4), flush);
 }
@@ -155,10 +178,16 @@ void FlvMuxer::onWriteFlvTag(uint8_t type, const Buffer::Ptr &buffer, uint32_t t
 void FlvMuxer::onWriteRtmp(const RtmpPacket::Ptr &pkt,bool flush) {
     int64_t dts_out;
     _stamp[pkt->type_id % 2].revise(pkt->time_stamp, 0, dts_out, dts_out);
+    if (_shared_tag && pkt->flv_tag) {
+        onWriteSharedFlvTag(pkt->flv_tag, (uint32_t)dts_out, flush);
+        return;
+    }
+    //未开启共享，或者开启共享前已经在gop缓存中的包、config帧，直接引用rtmp包生成tag
     onWriteFlvTag(pkt, (uint32_t)dts_out,flush);
 }
 
 void FlvMuxer::stop() {
+    _flv_tag_token = nullptr;
     if(_ring_reader){
         _ring_reader.reset();
         onDetach();
@@ -27,18 +27,40 @@ public:
     void stop();
 
 protected:
-    void start(const EventPoller::Ptr &poller, const RtmpMediaSource::Ptr &media);
+    /**
+     * 开始输出flv
+     * @param shared_tag 是否引用媒体源预先生成的flv tag，只重新生成tag头以修整时间戳
+     */
+    void start(const EventPoller::Ptr &poller, const RtmpMediaSource::Ptr &media, bool shared_tag = false);
     virtual void onWrite(const Buffer::Ptr &data, bool flush) = 0;
     virtual void onDetach() = 0;
     virtual std::shared_ptr<FlvMuxer> getSharedPtr() = 0;
 
+    /**
+     * 收到环形缓存中的一组rtmp包
+     * @param is_key 该组是否从关键帧开始
+     * @return false则丢弃整组
+     */
+    virtual bool onRtmpGroup(bool is_key) { return true; }
+
+    /**
+     * 是否丢弃该rtmp包
+     */
+    virtual bool onDropRtmp(const RtmpPacket::Ptr &pkt) { return false; }
+
 private:
     void onWriteFlvHeader(const RtmpMediaSource::Ptr &media);
     void onWriteRtmp(const RtmpPacket::Ptr &pkt, bool flush);
     void onWriteFlvTag(const RtmpPacket::Ptr &pkt, uint32_t time_stamp, bool flush);
     void onWriteFlvTag(uint8_t type, const Buffer::Ptr &buffer, uint32_t time_stamp, bool flush);
+    void onWriteSharedFlvTag(const Buffer::Ptr &flv_tag, uint32_t time_stamp, bool flush);
+    void onWriteFlvTagHeader(uint8_t type, size_t body_size, uint32_t time_stamp);
+    void onWriteFlvTagSize(size_t body_size, bool flush);
 
 private:
+    bool _shared_tag = false;
+    //持有期间媒体源为共享播放器预先生成flv tag
+    std::shared_ptr<onceToken> _flv_tag_token;
     //时间戳修整器
     Stamp _stamp[2];
     RtmpMediaSource::RingType::RingReader::Ptr _ring_reader;
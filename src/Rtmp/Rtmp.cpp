@@ -9,7 +9,10 @@
  */
 
 #include "Rtmp.h"
+#include "utils.h"
 #include "Extension/Factory.h"
+#include "Extension/H264.h"
+#include "Extension/H265.h"
 namespace mediakit{
 
 VideoMeta::VideoMeta(const VideoTrack::Ptr &video){
@@ -131,4 +134,115 @@ void Metadata::addTrack(AMFValue &metadata, const Track::Ptr &track) {
         metadata.set(key, value);
     });
 }
+
+size_t RtmpPacket::copyTo(size_t offset, char *dst, size_t len) const {
+    size_t ret = 0;
+    auto copy = [&](const char *data, size_t size) {
+        if (offset >= size) {
+            offset -= size;
+            return;
+        }
+        auto n = MIN(len - ret, size - offset);
+        memcpy(dst + ret, data + offset, n);
+        ret += n;
+        offset = 0;
+    };
+    copy(buffer.data(), buffer.size());
+    for (auto it = slices.begin(); it != slices.end() && ret < len; ++it) {
+        copy((*it)->data(), (*it)->size());
+    }
+    return ret;
+}
+
+//小于该长度的帧负载直接拷贝，比起多一个分片(每个播放器发送时多一个iovec)开销更小
+static constexpr size_t kMinSliceSize = 1024;
+
+void RtmpPacket::appendFrame(const Frame::Ptr &frame, const char *prefix, size_t prefix_size) {
+    auto data = frame->data() + frame->prefixSize();
+    auto size = frame->size() - frame->prefixSize();
+    if (slices.empty() && (size < kMinSliceSize || !frame->cacheAble())) {
+        //还没有分片，拷贝至buffer尾部
+        buffer.append(prefix, prefix_size);
+        buffer.append(data, size);
+        return;
+    }
+    if (prefix_size) {
+        if (slices.empty()) {
+            buffer.append(prefix, prefix_size);
+        } else {
+            slices.emplace_back(std::make_shared<BufferRaw>(prefix, prefix_size));
+        }
+    }
+    //帧数据不归该帧所有时(例如引用外部内存)，需要先拷贝一份
+    auto cacheable = frame->cacheAble() ? frame : Frame::getCacheAbleFrame(frame);
+    slices.emplace_back(std::make_shared<BufferPartial>(cacheable, cacheable->prefixSize(), size));
+}
+
+bool RtmpPacket::isNonReferenceFrame() const {
+    uint8_t header[5];
+    if (type_id != MSG_VIDEO || copyTo(0, (char *) header, 5) < 5) {
+        return false;
+    }
+    if (header[0] >> 4 == FLV_DISPOSABLE_INTER_FRAME) {
+        return true;
+    }
+    if (header[1] != 1) {
+        //不是nalu
+        return false;
+    }
+    auto codec = header[0] & 0x0F;
+    auto end = totalSize();
+    size_t offset = 5;
+    //遍历avcc格式的nalu，以第一个slice为准(跳过sei等)
+    while (offset + 4 < end) {
+        //4字节nalu长度加1字节nalu头
+        uint8_t nalu[5];
+        copyTo(offset, (char *) nalu, 5);
+        auto len = load_be32(nalu);
+        offset += 4;
+        if (!len || len > end - offset) {
+            break;
+        }
+        switch (codec) {
+            case FLV_CODEC_H264: {
+                auto type = H264_TYPE(nalu[4]);
+                if (type >= H264Frame::NAL_B_P && type <= H264Frame::NAL_IDR) {
+                    //nal_ref_idc为0
+                    return (nalu[4] & 0x60) == 0;
+                }
+                break;
+            }
+            case FLV_CODEC_H265: {
+                auto type = H265_TYPE(nalu[4]);
+                if (type < H265Frame::NAL_VPS) {
+                    //TRAIL_N、TSA_N、STSA_N、RADL_N、RASL_N等子层非参考帧
+                    return type <= 14 && type % 2 == 0;
+                }
+                break;
+            }
+            default: return false;
+        }
+        offset += len;
+    }
+    return false;
+}
+
+Buffer::Ptr makeFlvTag(const RtmpPacket &pkt, uint32_t time_stamp) {
+    auto size = pkt.totalSize();
+    RtmpTagHeader header;
+    header.type = pkt.type_id;
+    set_be24(header.data_size, (uint32_t) size);
+    header.timestamp_ex = (uint8_t) ((time_stamp >> 24) & 0xff);
+    set_be24(header.timestamp, time_stamp & 0xFFFFFF);
+    uint32_t tag_size = htonl((uint32_t) (size + sizeof(header)));
+
+    auto ret = std::make_shared<BufferRaw>(sizeof(header) + size + 4);
+    auto ptr = ret->data();
+    memcpy(ptr, &header, sizeof(header));
+    pkt.copyTo(0, ptr + sizeof(header), size);
+    memcpy(ptr + sizeof(header) + size, &tag_size, 4);
+    ret->setSize(sizeof(header) + size + 4);
+    return ret;
+}
+
 }//namespace mediakit
\ No newline at end of file
@@ -13,6 +13,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 #include <cstdlib>
 #include "Util/util.h"
 #include "Util/logger.h"
@@ -69,6 +70,7 @@ using namespace toolkit;
 
 #define FLV_KEY_FRAME				1
 #define FLV_INTER_FRAME				2
+#define FLV_DISPOSABLE_INTER_FRAME	3
 
 #define FLV_CODEC_AAC 10
 #define FLV_CODEC_H264 7
@@ -122,6 +124,15 @@ public:
     uint8_t stream_index[4]; /* Note, this is little-endian while others are BE */
 }PACKED;
 
+class RtmpTagHeader {
+public:
+    uint8_t type = 0;
+    uint8_t data_size[3] = {0};
+    uint8_t timestamp[3] = {0};
+    uint8_t timestamp_ex = 0;
+    uint8_t streamid[3] = {0}; /* Always 0. */
+}PACKED;
+
 #if defined(_WIN32)
 #pragma pack(pop)
 #endif // defined(_WIN32)
@@ -137,6 +148,11 @@ public:
     uint32_t chunk_id;
     size_t body_size = 0;
     BufferLikeString buffer;
+    //紧跟在buffer之后的rtmp body分片，直接引用帧数据以免拷贝，完整的rtmp body为buffer加上所有分片
+    //data()/size()只代表buffer部分，发送或生成flv tag时需要一并处理分片
+    std::vector<Buffer::Ptr> slices;
+    //预先生成的完整flv tag，时间戳为源时间戳，由RtmpMediaSource按需生成，供所有http-flv播放器共享
+    Buffer::Ptr flv_tag;
 
 public:
     char *data() const override{
@@ -161,8 +177,46 @@ public:
         stream_index = that.stream_index;
         chunk_id = that.chunk_id;
         buffer = std::move(that.buffer);
+        slices = std::move(that.slices);
     }
 
+    /**
+     * 清空rtmp body，复用对象前调用
+     */
+    void clear() {
+        buffer.clear();
+        slices.clear();
+        body_size = 0;
+    }
+
+    /**
+     * 完整rtmp body长度，包括所有分片
+     */
+    size_t totalSize() const {
+        auto ret = buffer.size();
+        for (auto &slice : slices) {
+            ret += slice->size();
+        }
+        return ret;
+    }
+
+    /**
+     * 从rtmp body指定位置拷贝数据，rtmp body可能由buffer与多个分片组成
+     * @param offset rtmp body内偏移量
+     * @param dst 目标内存
+     * @param len 拷贝长度
+     * @return 实际拷贝的长度
+     */
+    size_t copyTo(size_t offset, char *dst, size_t len) const;
+
+    /**
+     * 追加帧负载(不含prefix)至rtmp body，较大的可缓存帧直接引用，不拷贝
+     * @param frame 帧
+     * @param prefix 负载前插入的数据，例如avcc格式的nalu长度，可以为空
+     * @param prefix_size prefix长度
+     */
+    void appendFrame(const Frame::Ptr &frame, const char *prefix = nullptr, size_t prefix_size = 0);
+
     bool isVideoKeyFrame() const {
         return type_id == MSG_VIDEO && (uint8_t) buffer[0] >> 4 == FLV_KEY_FRAME && (uint8_t) buffer[1] == 1;
     }
@@ -180,6 +234,11 @@ public:
         }
     }
 
+    /**
+     * 是否为非参考帧(丢弃后不影响其他帧解码)
+     */
+    bool isNonReferenceFrame() const;
+
     int getMediaType() const {
         switch (type_id) {
             case MSG_VIDEO : return (uint8_t) buffer[0] & 0x0F;
@@ -289,5 +348,12 @@ private:
 //根据音频track获取flags
 uint8_t getAudioRtmpFlags(const Track::Ptr &track);
 
+/**
+ * 生成完整的flv tag(tag头+负载+PreviousTagSize)，三者放在同一块连续内存中
+ * @param pkt rtmp包，负载为其完整rtmp body(包括分片)
+ * @param time_stamp 时间戳
+ */
+Buffer::Ptr makeFlvTag(const RtmpPacket &pkt, uint32_t time_stamp);
+
 }//namespace mediakit
 #endif//__rtmp_h
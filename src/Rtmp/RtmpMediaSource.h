@@ -114,13 +114,30 @@ public:
         _metadata = metadata;
     }
 
+    /**
+     * 开始为后续rtmp包预先生成flv tag，供http-flv/ws-flv播放器共享
+     * @return 播放器持有该对象期间持续生成flv tag，所有共享播放器都释放后停止生成
+     */
+    std::shared_ptr<onceToken> enableFlvTag() {
+        ++_flv_tag_readers;
+        weak_ptr<RtmpMediaSource> weak_self = dynamic_pointer_cast<RtmpMediaSource>(shared_from_this());
+        return std::make_shared<onceToken>(nullptr, [weak_self]() {
+            auto strong_self = weak_self.lock();
+            if (strong_self) {
+                --strong_self->_flv_tag_readers;
+            }
+        });
+    }
+
     /**
      * 输入rtmp包
      * @param pkt rtmp包
      */
     void onWrite(RtmpPacket::Ptr pkt, bool = true) override {
         bool is_video = pkt->type_id == MSG_VIDEO;
-        _speed[is_video ? TrackVideo : TrackAudio] += pkt->size();
+        //rtmp包可能来自对象池，先清除上次生成的flv tag
+        pkt->flv_tag = nullptr;
+        _speed[is_video ? TrackVideo : TrackAudio] += pkt->totalSize();
         //保存当前时间戳
         switch (pkt->type_id) {
             case MSG_VIDEO : _track_stamps[TrackVideo] = pkt->time_stamp, _have_video = true; break;
@@ -153,6 +170,10 @@ public:
                 regist();
             }
         }
+        if (_flv_tag_readers > 0) {
+            //所有flv播放器共享同一份tag，只拷贝一次
+            pkt->flv_tag = makeFlvTag(*pkt, pkt->time_stamp);
+        }
         bool key = pkt->isVideoKeyFrame();
         auto stamp  = pkt->time_stamp;
         PacketCache<RtmpPacket>::inputPacket(stamp, is_video, std::move(pkt), key);
@@ -196,6 +217,8 @@ private:
 
 private:
     bool _have_video = false;
+    //共享flv tag的播放器个数
+    atomic<int> _flv_tag_readers{0};
     int _ring_size;
     uint32_t _track_stamps[TrackMax] = {0};
     AMFValue _metadata;
@@ -170,35 +170,20 @@ void RtmpProtocol::sendRequest(int cmd, const string& str) {
     sendRtmp(cmd, _stream_index, str, 0, CHUNK_SERVER_REQUEST);
 }
 
-class BufferPartial : public Buffer {
-public:
-    BufferPartial(const Buffer::Ptr &buffer, size_t offset, size_t size){
-        _buffer = buffer;
-        _data = buffer->data() + offset;
-        _size = size;
-    }
-
-    ~BufferPartial() override{}
-
-    char *data() const override {
-        return _data;
-    }
-
-    size_t size() const override{
-        return _size;
-    }
-
-private:
-    char *_data;
-    size_t _size;
-    Buffer::Ptr _buffer;
-};
-
 void RtmpProtocol::sendRtmp(uint8_t type, uint32_t stream_index, const std::string &buffer, uint32_t stamp, int chunk_id) {
     sendRtmp(type, stream_index, std::make_shared<BufferString>(buffer), stamp, chunk_id);
 }
 
 void RtmpProtocol::sendRtmp(uint8_t type, uint32_t stream_index, const Buffer::Ptr &buf, uint32_t stamp, int chunk_id){
+    sendRtmp_l(type, stream_index, buf, nullptr, buf->size(), stamp, chunk_id);
+}
+
+void RtmpProtocol::sendRtmp(uint8_t type, uint32_t stream_index, const RtmpPacket::Ptr &pkt, uint32_t stamp, int chunk_id){
+    sendRtmp_l(type, stream_index, pkt, &pkt->slices, pkt->totalSize(), stamp, chunk_id);
+}
+
+void RtmpProtocol::sendRtmp_l(uint8_t type, uint32_t stream_index, const Buffer::Ptr &buf, const std::vector<Buffer::Ptr> *slices,
+                              size_t body_size, uint32_t stamp, int chunk_id){
     if (chunk_id < 2 || chunk_id > 63) {
         auto strErr = StrPrinter << "不支持发送该类型的块流 ID:" << chunk_id << endl;
         throw std::runtime_error(strErr);
@@ -215,7 +200,7 @@ void RtmpProtocol::sendRtmp(uint8_t type, uint32_t stream_index, const Buffer::P
     header->flags = (chunk_id & 0x3f) | (0 << 6);
     header->type_id = type;
     set_be24(header->time_stamp, ext_stamp ? 0xFFFFFF : stamp);
-    set_be24(header->body_size, (uint32_t)buf->size());
+    set_be24(header->body_size, (uint32_t)body_size);
     set_le32(header->stream_index, stream_index);
     //发送rtmp头
     onSendRawData(std::move(buffer_header));
@@ -238,20 +223,39 @@ void RtmpProtocol::sendRtmp(uint8_t type, uint32_t stream_index, const Buffer::P
 
     size_t offset = 0;
     size_t totalSize = sizeof(RtmpHeader);
-    while (offset < buf->size()) {
-        if (offset) {
-            onSendRawData(buffer_flags);
-            totalSize += 1;
+    //rtmp body可能由多个分片组成，chunk可以跨越分片，每个分片按chunk边界切分后直接发送，不拷贝
+    auto send_slice = [&](const Buffer::Ptr &slice) {
+        size_t slice_offset = 0;
+        auto slice_size = slice->size();
+        while (slice_offset < slice_size) {
+            auto chunk_offset = offset % _chunk_size_out;
+            if (chunk_offset == 0) {
+                if (offset) {
+                    onSendRawData(buffer_flags);
+                    totalSize += 1;
+                }
+                if (ext_stamp) {
+                    //扩展时间戳
+                    onSendRawData(buffer_ext_stamp);
+                    totalSize += 4;
+                }
+            }
+            size_t chunk = min(_chunk_size_out - chunk_offset, slice_size - slice_offset);
+            if (chunk == slice_size) {
+                onSendRawData(slice);
+            } else {
+                onSendRawData(std::make_shared<BufferPartial>(slice, slice_offset, chunk));
+            }
+            totalSize += chunk;
+            offset += chunk;
+            slice_offset += chunk;
         }
-        if (ext_stamp) {
-            //扩展时间戳
-            onSendRawData(buffer_ext_stamp);
-            totalSize += 4;
+    };
+    send_slice(buf);
+    if (slices) {
+        for (auto &slice : *slices) {
+            send_slice(slice);
         }
-        size_t chunk = min(_chunk_size_out, buf->size() - offset);
-        onSendRawData(std::make_shared<BufferPartial>(buf, offset, chunk));
-        totalSize += chunk;
-        offset += chunk;
     }
     _bytes_sent += (uint32_t)totalSize;
     if (_windows_size > 0 && _bytes_sent - _bytes_sent_last >= _windows_size) {
@@ -70,8 +70,11 @@ protected:
     void sendResponse(int type, const string &str);
     void sendRtmp(uint8_t type, uint32_t stream_index, const std::string &buffer, uint32_t stamp, int chunk_id);
     void sendRtmp(uint8_t type, uint32_t stream_index, const Buffer::Ptr &buffer, uint32_t stamp, int chunk_id);
+    void sendRtmp(uint8_t type, uint32_t stream_index, const RtmpPacket::Ptr &pkt, uint32_t stamp, int chunk_id);
 
 private:
+    void sendRtmp_l(uint8_t type, uint32_t stream_index, const Buffer::Ptr &buffer, const std::vector<Buffer::Ptr> *slices,
+                    size_t body_size, uint32_t stamp, int chunk_id);
     void handle_C1_simple(const char *data);
 #ifdef ENABLE_OPENSSL
     void handle_C1_complex(const char *data);
@@ -90,9 +93,10 @@ private:
 protected:
     int _send_req_id = 0;
     uint32_t _stream_index = STREAM_CONTROL;
+    //当前处理的消息的stream id，sendInvoke回复时使用
+    int _now_stream_index = 0;
 
 private:
-    int _now_stream_index = 0;
     int _now_chunk_id = 0;
     bool _data_started = false;
     ////////////ChunkSize////////////
@@ -11,6 +11,7 @@
 #include "RtmpSession.h"
 #include "Common/config.h"
 #include "Util/onceToken.h"
+#include "Common/StreamAffinity.h"
 namespace mediakit {
 
 RtmpSession::RtmpSession(const Socket::Ptr &sock) : TcpSession(sock) {
@@ -89,20 +90,20 @@ void RtmpSession::onCmd_connect(AMFDecoder &dec) {
         _tc_url = string(RTMP_SCHEMA) + "://" + DEFAULT_VHOST + "/" + _media_info._app;
     }
     bool ok = true; //(app == APP_NAME);
-    AMFValue version(AMF_OBJECT);
-    version.set("fmsVer", "FMS/3,0,1,123");
-    version.set("capabilities", 31.0);
-    AMFValue status(AMF_OBJECT);
-    status.set("level", ok ? "status" : "error");
-    status.set("code", ok ? "NetConnection.Connect.Success" : "NetConnection.Connect.InvalidApp");
-    status.set("description", ok ? "Connection succeeded." : "InvalidApp.");
-    status.set("objectEncoding", amf_ver);
-    sendReply(ok ? "_result" : "_error", version, status);
+    AMFEncoder invoke;
+    invoke << (ok ? "_result" : "_error") << _recv_req_id;
+    invoke.object("fmsVer", "FMS/3,0,1,123",
+                  "capabilities", 31.0);
+    invoke.object("level", ok ? "status" : "error",
+                  "code", ok ? "NetConnection.Connect.Success" : "NetConnection.Connect.InvalidApp",
+                  "description", ok ? "Connection succeeded." : "InvalidApp.",
+                  "objectEncoding", amf_ver);
+    sendResponse(MSG_CMD, invoke.data());
     if (!ok) {
         throw std::runtime_error("Unsupported application: " + _media_info._app);
     }
 
-    AMFEncoder invoke;
+    invoke.clear();
     invoke << "onBWDone" << 0.0 << nullptr;
     sendResponse(MSG_CMD, invoke.data());
 }
@@ -131,12 +132,10 @@ void RtmpSession::onCmd_publish(AMFDecoder &dec) {
                                                                            _media_info._streamid));
         bool auth_success = err.empty();
         bool ok = (!src && !_publisher_src && auth_success);
-        AMFValue status(AMF_OBJECT);
-        status.set("level", ok ? "status" : "error");
-        status.set("code", ok ? "NetStream.Publish.Start" : (auth_success ? "NetStream.Publish.BadName" : "NetStream.Publish.BadAuth"));
-        status.set("description", ok ? "Started publishing stream." : (auth_success ? "Already publishing." : err.data()));
-        status.set("clientid", "0");
-        sendReply("onStatus", nullptr, status);
+        sendStatus("level", ok ? "status" : "error",
+                   "code", ok ? "NetStream.Publish.Start" : (auth_success ? "NetStream.Publish.BadName" : "NetStream.Publish.BadAuth"),
+                   "description", ok ? "Started publishing stream." : (auth_success ? "Already publishing." : err.data()),
+                   "clientid", "0");
         if (!ok) {
             string errMsg = StrPrinter << (auth_success ? "already publishing:" : err.data()) << " "
                                        << _media_info._vhost << " "
@@ -181,11 +180,9 @@ void RtmpSession::onCmd_publish(AMFDecoder &dec) {
 }
 
 void RtmpSession::onCmd_deleteStream(AMFDecoder &dec) {
-    AMFValue status(AMF_OBJECT);
-    status.set("level", "status");
-    status.set("code", "NetStream.Unpublish.Success");
-    status.set("description", "Stop publishing.");
-    sendReply("onStatus", nullptr, status);
+    sendStatus("level", "status",
+               "code", "NetStream.Unpublish.Success",
+               "description", "Stop publishing.");
     throw std::runtime_error(StrPrinter << "Stop publishing" << endl);
 }
 
@@ -197,13 +194,11 @@ void RtmpSession::sendPlayResponse(const string &err,const RtmpMediaSource::Ptr
         sendUserControl(CONTROL_STREAM_BEGIN, STREAM_MEDIA);
     }
     // onStatus(NetStream.Play.Reset)
-    AMFValue status(AMF_OBJECT);
-    status.set("level", ok ? "status" : "error");
-    status.set("code", ok ? "NetStream.Play.Reset" : (auth_success ? "NetStream.Play.StreamNotFound" : "NetStream.Play.BadAuth"));
-    status.set("description", ok ? "Resetting and playing." : (auth_success ? "No such stream." : err.data()));
-    status.set("details", _media_info._streamid);
-    status.set("clientid", "0");
-    sendReply("onStatus", nullptr, status);
+    sendStatus("level", ok ? "status" : "error",
+               "code", ok ? "NetStream.Play.Reset" : (auth_success ? "NetStream.Play.StreamNotFound" : "NetStream.Play.BadAuth"),
+               "description", ok ? "Resetting and playing." : (auth_success ? "No such stream." : err.data()),
+               "details", _media_info._streamid,
+               "clientid", "0");
     if (!ok) {
         string err_msg = StrPrinter << (auth_success ? "no such stream:" : err.data()) << " "
                                     << _media_info._vhost << " "
@@ -214,13 +209,11 @@ void RtmpSession::sendPlayResponse(const string &err,const RtmpMediaSource::Ptr
     }
 
     // onStatus(NetStream.Play.Start)
-    status.clear();
-    status.set("level", "status");
-    status.set("code", "NetStream.Play.Start");
-    status.set("description", "Started playing.");
-    status.set("details", _media_info._streamid);
-    status.set("clientid", "0");
-    sendReply("onStatus", nullptr, status);
+    sendStatus("level", "status",
+               "code", "NetStream.Play.Start",
+               "description", "Started playing.",
+               "details", _media_info._streamid,
+               "clientid", "0");
 
     // |RtmpSampleAccess(true, true)
     AMFEncoder invoke;
@@ -229,19 +222,16 @@ void RtmpSession::sendPlayResponse(const string &err,const RtmpMediaSource::Ptr
 
     //onStatus(NetStream.Data.Start)
     invoke.clear();
-    AMFValue obj(AMF_OBJECT);
-    obj.set("code", "NetStream.Data.Start");
-    invoke << "onStatus" << obj;
+    invoke << "onStatus";
+    invoke.object("code", "NetStream.Data.Start");
     sendResponse(MSG_DATA, invoke.data());
 
     //onStatus(NetStream.Play.PublishNotify)
-    status.clear();
-    status.set("level", "status");
-    status.set("code", "NetStream.Play.PublishNotify");
-    status.set("description", "Now published.");
-    status.set("details", _media_info._streamid);
-    status.set("clientid", "0");
-    sendReply("onStatus", nullptr, status);
+    sendStatus("level", "status",
+               "code", "NetStream.Play.PublishNotify",
+               "description", "Now published.",
+               "details", _media_info._streamid,
+               "clientid", "0");
 
     auto &metadata = src->getMetaData();
     if(metadata){
@@ -269,7 +259,7 @@ void RtmpSession::sendPlayResponse(const string &err,const RtmpMediaSource::Ptr
     _stamp[0].syncTo(_stamp[1]);
     _ring_reader = src->getRing()->attach(getPoller());
     weak_ptr<RtmpSession> weakSelf = dynamic_pointer_cast<RtmpSession>(shared_from_this());
-    _ring_reader->setReadCB([weakSelf](const RtmpMediaSource::RingDataType &pkt) {
+    _ring_reader->setReadCBWithKey([weakSelf](const RtmpMediaSource::RingDataType &pkt, bool is_key) {
         auto strongSelf = weakSelf.lock();
         if (!strongSelf) {
             return;
@@ -277,6 +267,10 @@ void RtmpSession::sendPlayResponse(const string &err,const RtmpMediaSource::Ptr
         if(strongSelf->_paused){
             return;
         }
+        if (!strongSelf->inputGroup(strongSelf->getSock(), is_key)) {
+            //发送缓存积压严重，等待下一个关键帧
+            return;
+        }
         size_t i = 0;
         auto size = pkt->size();
         strongSelf->setSendFlushFlag(false);
@@ -284,6 +278,9 @@ void RtmpSession::sendPlayResponse(const string &err,const RtmpMediaSource::Ptr
             if(++i == size){
                 strongSelf->setSendFlushFlag(true);
             }
+            if (strongSelf->dropFrame([&]() { return rtmp->isNonReferenceFrame(); })) {
+                return;
+            }
             strongSelf->onSendMedia(rtmp);
         });
     });
@@ -322,7 +319,7 @@ void RtmpSession::doPlayResponse(const string &err,const std::function<void(bool
     });
 }
 
-void RtmpSession::doPlay(AMFDecoder &dec){
+void RtmpSession::doPlay(){
     std::shared_ptr<Ticker> ticker(new Ticker);
     weak_ptr<RtmpSession> weak_self = dynamic_pointer_cast<RtmpSession>(shared_from_this());
     std::shared_ptr<onceToken> token(new onceToken(nullptr, [ticker,weak_self](){
@@ -353,7 +350,7 @@ void RtmpSession::doPlay(AMFDecoder &dec){
 }
 
 void RtmpSession::onCmd_play2(AMFDecoder &dec) {
-    doPlay(dec);
+    doPlay();
 }
 
 string RtmpSession::getStreamId(const string &str){
@@ -396,18 +393,29 @@ void RtmpSession::onCmd_play(AMFDecoder &dec) {
     dec.load<AMFValue>();/* NULL */
     _media_info.parse(_tc_url + "/" + getStreamId(dec.load<std::string>()));
     _media_info._schema = RTMP_SCHEMA;
-    doPlay(dec);
+    weak_ptr<RtmpSession> weak_self = dynamic_pointer_cast<RtmpSession>(shared_from_this());
+    //迁移到该流所属的poller线程后再继续处理播放请求，
+    //迁移在本次收到的数据处理完毕后进行，期间可能收到其他stream id的消息，所以需要恢复play命令的stream id
+    auto stream_index = _now_stream_index;
+    if (StreamAffinity::moveSession(*this, _media_info, [weak_self, stream_index]() {
+        auto strong_self = weak_self.lock();
+        if (strong_self) {
+            strong_self->_now_stream_index = stream_index;
+            strong_self->doPlay();
+        }
+    })) {
+        return;
+    }
+    doPlay();
 }
 
 void RtmpSession::onCmd_pause(AMFDecoder &dec) {
     dec.load<AMFValue>();/* NULL */
     bool paused = dec.load<bool>();
     TraceP(this) << paused;
-    AMFValue status(AMF_OBJECT);
-    status.set("level", "status");
-    status.set("code", paused ? "NetStream.Pause.Notify" : "NetStream.Unpause.Notify");
-    status.set("description", paused ? "Paused stream." : "Unpaused stream.");
-    sendReply("onStatus", nullptr, status);
+    sendStatus("level", "status",
+               "code", paused ? "NetStream.Pause.Notify" : "NetStream.Unpause.Notify",
+               "description", paused ? "Paused stream." : "Unpaused stream.");
     //streamBegin
     sendUserControl(paused ? CONTROL_STREAM_EOF : CONTROL_STREAM_BEGIN, STREAM_MEDIA);
     _paused = paused;
@@ -501,12 +509,9 @@ void RtmpSession::onRtmpChunk(RtmpPacket &chunk_data) {
 
 void RtmpSession::onCmd_seek(AMFDecoder &dec) {
     dec.load<AMFValue>();/* NULL */
-    AMFValue status(AMF_OBJECT);
-    AMFEncoder invoke;
-    status.set("level", "status");
-    status.set("code", "NetStream.Seek.Notify");
-    status.set("description", "Seeking.");
-    sendReply("onStatus", nullptr, status);
+    sendStatus("level", "status",
+               "code", "NetStream.Seek.Notify",
+               "description", "Seeking.");
 
     auto milliSeconds = (uint32_t)(dec.load<AMFValue>().as_number());
     InfoP(this) << "rtmp seekTo(ms):" << milliSeconds;
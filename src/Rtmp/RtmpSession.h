@@ -22,12 +22,13 @@
 #include "Util/TimeTicker.h"
 #include "Network/TcpSession.h"
 #include "Common/Stamp.h"
+#include "Common/SendQueuePolicy.h"
 
 using namespace toolkit;
 
 namespace mediakit {
 
-class RtmpSession: public TcpSession ,public  RtmpProtocol , public MediaSourceEvent{
+class RtmpSession: public TcpSession ,public  RtmpProtocol , public MediaSourceEvent, public SendQueuePolicy{
 public:
     typedef std::shared_ptr<RtmpSession> Ptr;
     RtmpSession(const Socket::Ptr &sock);
@@ -47,7 +48,7 @@ private:
 
     void onCmd_play(AMFDecoder &dec);
     void onCmd_play2(AMFDecoder &dec);
-    void doPlay(AMFDecoder &dec);
+    void doPlay();
     void doPlayResponse(const string &err,const std::function<void(bool)> &cb);
     void sendPlayResponse(const string &err,const RtmpMediaSource::Ptr &src);
 
@@ -69,6 +70,15 @@ private:
         sendResponse(MSG_CMD, invoke.data());
     }
 
+    //发送onStatus命令，参数为status object的key与value交替排列，直接编码无需构造AMFValue
+    template<typename ...ARGS>
+    inline void sendStatus(ARGS &&...args) {
+        AMFEncoder invoke;
+        invoke << "onStatus" << _recv_req_id << nullptr;
+        invoke.object(std::forward<ARGS>(args)...);
+        sendResponse(MSG_CMD, invoke.data());
+    }
+
     ///////MediaSourceEvent override///////
     // 关闭
     bool close(MediaSource &sender, bool force) override;
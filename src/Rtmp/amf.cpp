@@ -10,6 +10,7 @@
 
 #include <string.h>
 #include <stdexcept>
+#include <unordered_set>
 #include "amf.h"
 #include "utils.h"
 #include "Util/util.h"
@@ -84,6 +85,11 @@ AMFValue::AMFValue(const std::string &s) :
     *_value.string = s;
 }
 
+AMFValue::AMFValue(std::string &&s) :
+        _type(AMF_STRING) {
+    _value.string = new std::string(std::move(s));
+}
+
 AMFValue::AMFValue(double n) :
         _type(AMF_NUMBER) {
     init();
@@ -107,7 +113,26 @@ AMFValue::AMFValue(const AMFValue &from) :
     *this = from;
 }
 
+AMFValue::AMFValue(AMFValue &&from) noexcept :
+        _type(from._type), _value(from._value) {
+    //直接接管对方的堆内存
+    from._type = AMF_NULL;
+}
+
+AMFValue& AMFValue::operator = (AMFValue &&from) noexcept {
+    if (this != &from) {
+        destroy();
+        _type = from._type;
+        _value = from._value;
+        from._type = AMF_NULL;
+    }
+    return *this;
+}
+
 AMFValue& AMFValue::operator = (const AMFValue &from) {
+    if (this == &from) {
+        return *this;
+    }
     destroy();
     _type = from._type;
     init();
@@ -230,12 +255,13 @@ const AMFValue& AMFValue::operator[](const char *str) const {
     if (_type != AMF_OBJECT && _type != AMF_ECMA_ARRAY) {
         throw std::runtime_error("AMF not a object");
     }
-    auto i = _value.object->find(str);
-    if (i == _value.object->end()) {
-        static AMFValue val(AMF_NULL);
-        return val;
+    for (auto &pr : *_value.object) {
+        if (pr.first == str) {
+            return pr.second;
+        }
     }
-    return i->second;
+    static AMFValue val(AMF_NULL);
+    return val;
 }
 
 void AMFValue::object_for_each(const function<void(const string &key, const AMFValue &val)> &fun) const {
@@ -250,18 +276,27 @@ void AMFValue::object_for_each(const function<void(const string &key, const AMFV
 AMFValue::operator bool() const{
     return _type != AMF_NULL;
 }
-void AMFValue::set(const std::string &s, const AMFValue &val) {
+void AMFValue::set(std::string s, AMFValue val) {
     if (_type != AMF_OBJECT && _type != AMF_ECMA_ARRAY) {
         throw std::runtime_error("AMF not a object");
     }
-    _value.object->emplace(s, val);
+    for (auto &pr : *_value.object) {
+        if (pr.first == s) {
+            //key已存在时保留原值(与std::map::emplace一致)
+            return;
+        }
+    }
+    _value.object->emplace_back(std::move(s), std::move(val));
+}
+void AMFValue::append(std::string s, AMFValue val) {
+    _value.object->emplace_back(std::move(s), std::move(val));
 }
-void AMFValue::add(const AMFValue &val) {
+void AMFValue::add(AMFValue val) {
     if (_type != AMF_STRICT_ARRAY) {
         throw std::runtime_error("AMF not a array");
     }
     assert(_type == AMF_STRICT_ARRAY);
-    _value.array->push_back(val);
+    _value.array->emplace_back(std::move(val));
 }
 
 const AMFValue::mapType &AMFValue::getMap() const {
@@ -316,6 +351,11 @@ enum {
 };
 
 ////////////////////////////////Encoder//////////////////////////////////////////
+AMFEncoder::AMFEncoder() {
+    //rtmp命令一般不超过256字节，预分配避免多次扩容
+    buf.reserve(256);
+}
+
 AMFEncoder & AMFEncoder::operator <<(const char *s) {
     if (s) {
         buf += char(AMF0_STRING);
@@ -359,13 +399,13 @@ AMFEncoder & AMFEncoder::operator <<(const int n){
 }
 
 AMFEncoder & AMFEncoder::operator <<(const double n) {
-    buf += char(AMF0_NUMBER);
     uint64_t encoded = 0;
     memcpy(&encoded, &n, 8);
-    uint32_t val = htonl(encoded >> 32);
-    buf.append((char *) &val, 4);
-    val = htonl(encoded & 0xFFFFFFFF);
-    buf.append((char *) &val, 4);
+    char bytes[9];
+    bytes[0] = char(AMF0_NUMBER);
+    set_be32(bytes + 1, (uint32_t) (encoded >> 32));
+    set_be32(bytes + 5, (uint32_t) (encoded & 0xFFFFFFFF));
+    buf.append(bytes, sizeof(bytes));
     return *this;
 }
 
@@ -390,13 +430,12 @@ AMFEncoder & AMFEncoder::operator <<(const AMFValue& value) {
         *this << value.as_boolean();
         break;
     case AMF_OBJECT: {
-        buf += char(AMF0_OBJECT);
+        begin_object();
         for (auto &pr : value.getMap()) {
             write_key(pr.first);
             *this << pr.second;
         }
-        write_key("");
-        buf += char(AMF0_OBJECT_END);
+        end_object();
     }
         break;
     case AMF_ECMA_ARRAY: {
@@ -407,8 +446,7 @@ AMFEncoder & AMFEncoder::operator <<(const AMFValue& value) {
             write_key(pr.first);
             *this << pr.second;
         }
-        write_key("");
-        buf += char(AMF0_OBJECT_END);
+        end_object();
     }
         break;
     case AMF_NULL:
@@ -434,10 +472,23 @@ AMFEncoder & AMFEncoder::operator <<(const AMFValue& value) {
 }
 
 void AMFEncoder::write_key(const std::string& s) {
-    assert(s.size() <= 0xFFFF);
-    uint16_t str_len = htons((uint16_t)s.size());
+    write_key(s.data(), s.size());
+}
+
+void AMFEncoder::write_key(const char *s, size_t len) {
+    assert(len <= 0xFFFF);
+    uint16_t str_len = htons((uint16_t)len);
     buf.append((char *) &str_len, 2);
-    buf += s;
+    buf.append(s, len);
+}
+
+void AMFEncoder::begin_object() {
+    buf += char(AMF0_OBJECT);
+}
+
+void AMFEncoder::end_object() {
+    write_key("", 0);
+    buf += char(AMF0_OBJECT_END);
 }
 
 void AMFEncoder::clear() {
@@ -627,12 +678,16 @@ AMFValue AMFDecoder::load_object() {
     if (pop_front() != AMF0_OBJECT) {
         throw std::runtime_error("Expected an object");
     }
+    //记录已解码的key，重复key以第一个为准(与set一致)
+    std::unordered_set<std::string> keys;
     while (1) {
         std::string key = load_key();
         if (key.empty())
             break;
-        AMFValue value = load<AMFValue>();
-        object.set(key, value);
+        auto val = load<AMFValue>();
+        if (keys.emplace(key).second) {
+            object.append(std::move(key), std::move(val));
+        }
     }
     if (pop_front() != AMF0_OBJECT_END) {
         throw std::runtime_error("expected object end");
@@ -650,12 +705,15 @@ AMFValue AMFDecoder::load_ecma() {
         throw std::runtime_error("Not enough data");
     }
     pos += 4;
+    std::unordered_set<std::string> keys;
     while (1) {
         std::string key = load_key();
         if (key.empty())
             break;
-        AMFValue value = load<AMFValue>();
-        object.set(key, value);
+        auto val = load<AMFValue>();
+        if (keys.emplace(key).second) {
+            object.append(std::move(key), std::move(val));
+        }
     }
     if (pop_front() != AMF0_OBJECT_END) {
         throw std::runtime_error("expected object end");
@@ -674,8 +732,7 @@ AMFValue AMFDecoder::load_arr() {
     int arrSize = load_be32(&buf[pos]);
     pos += 4;
     while (arrSize--) {
-        AMFValue value = load<AMFValue>();
-        object.add(value);
+        object.add(load<AMFValue>());
     }
     /*pos += 2;
     if (pop_front() != AMF0_OBJECT_END) {
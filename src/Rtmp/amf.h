@@ -12,6 +12,7 @@
 #define __amf_h
 
 #include <assert.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -39,18 +40,23 @@ class AMFValue;
 class AMFValue {
 public:
     friend class AMFEncoder;
-    typedef std::map<std::string, AMFValue> mapType;
+    friend class AMFDecoder;
+    //rtmp命令中的object一般只有几个到几十个字段，使用数组(按插入顺序)比std::map节省内存分配，查找也更快
+    typedef std::vector<std::pair<std::string, AMFValue> > mapType;
     typedef std::vector<AMFValue> arrayType;
 
     ~AMFValue();
     AMFValue(AMFType type = AMF_NULL);
     AMFValue(const char *s);
     AMFValue(const std::string &s);
+    AMFValue(std::string &&s);
     AMFValue(double n);
     AMFValue(int i);
     AMFValue(bool b);
     AMFValue(const AMFValue &from);
+    AMFValue(AMFValue &&from) noexcept;
     AMFValue &operator = (const AMFValue &from);
+    AMFValue &operator = (AMFValue &&from) noexcept;
 
     void clear();
     AMFType type() const ;
@@ -62,9 +68,11 @@ public:
     const AMFValue &operator[](const char *str) const;
     void object_for_each(const function<void(const string &key, const AMFValue &val)> &fun) const ;
     operator bool() const;
-    void set(const std::string &s, const AMFValue &val);
-    void add(const AMFValue &val);
+    void set(std::string s, AMFValue val);
+    void add(AMFValue val);
 private:
+    //解码时直接追加，由调用者保证key不重复，避免O(n^2)
+    void append(std::string s, AMFValue val);
     const mapType &getMap() const;
     const arrayType &getArr() const;
     void destroy();
@@ -101,6 +109,7 @@ private:
 
 class AMFEncoder {
 public:
+    AMFEncoder();
     AMFEncoder & operator <<(const char *s);
     AMFEncoder & operator <<(const std::string &s);
     AMFEncoder & operator <<(std::nullptr_t);
@@ -110,9 +119,34 @@ public:
     AMFEncoder & operator <<(const AMFValue &value);
     const std::string& data() const ;
     void clear() ;
+
+    /**
+     * 直接编码固定结构的amf object，无需构造AMFValue
+     * 参数为key与value交替排列，例如: enc.object("level", "status", "code", "NetStream.Play.Start");
+     */
+    template<typename ...ARGS>
+    AMFEncoder &object(ARGS &&...args) {
+        begin_object();
+        write_pairs(std::forward<ARGS>(args)...);
+        end_object();
+        return *this;
+    }
+
 private:
     void write_key(const std::string &s);
+    void write_key(const char *s, size_t len);
     AMFEncoder &write_undefined();
+    void begin_object();
+    void end_object();
+    void write_pairs() {}
+
+    template<typename VAL, typename ...ARGS>
+    void write_pairs(const char *key, VAL &&val, ARGS &&...args) {
+        write_key(key, strlen(key));
+        *this << val;
+        write_pairs(std::forward<ARGS>(args)...);
+    }
+
 private:
     std::string buf;
 };
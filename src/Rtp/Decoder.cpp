@@ -10,6 +10,7 @@
 
 #include "Decoder.h"
 #include "PSDecoder.h"
+#include "PSRtpDecoder.h"
 #include "TSDecoder.h"
 #include "Extension/H264.h"
 #include "Extension/H265.h"
@@ -47,6 +48,14 @@ static Decoder::Ptr createDecoder_l(DecoderImp::Type type) {
 /////////////////////////////////////////////////////////////
 
 DecoderImp::Ptr DecoderImp::createDecoder(Type type, MediaSinkInterface *sink){
+    if (type == decoder_ps_rtp) {
+#ifdef ENABLE_RTPPROXY
+        return DecoderImp::Ptr(new DecoderImp(std::make_shared<PSRtpDecoder>(), sink));
+#else
+        WarnL << "创建ps解复用器失败，请打开ENABLE_RTPPROXY然后重新编译";
+        return nullptr;
+#endif//ENABLE_RTPPROXY
+    }
     auto decoder =  createDecoder_l(type);
     if(!decoder){
         return nullptr;
@@ -58,6 +67,12 @@ size_t DecoderImp::input(const uint8_t *data, size_t bytes){
     return _decoder->input(data, bytes);
 }
 
+void DecoderImp::inputRtp(const RtpPacket::Ptr &rtp){
+#ifdef ENABLE_RTPPROXY
+    _rtp_decoder->inputRtp(rtp);
+#endif//ENABLE_RTPPROXY
+}
+
 DecoderImp::DecoderImp(const Decoder::Ptr &decoder, MediaSinkInterface *sink){
     _decoder = decoder;
     _sink = sink;
@@ -69,6 +84,19 @@ DecoderImp::DecoderImp(const Decoder::Ptr &decoder, MediaSinkInterface *sink){
     });
 }
 
+DecoderImp::DecoderImp(const std::shared_ptr<PSRtpDecoder> &decoder, MediaSinkInterface *sink){
+    _rtp_decoder = decoder;
+    _sink = sink;
+#ifdef ENABLE_RTPPROXY
+    _rtp_decoder->setOnFrame([this](int stream, int codecid, int64_t pts, int64_t dts, const Buffer::Ptr &buffer) {
+        onFrame(stream, codecid, pts, dts, buffer);
+    });
+    _rtp_decoder->setOnStream([this](int stream, int codecid, const void *extra, size_t bytes, int finish) {
+        onStream(stream, codecid, extra, bytes, finish);
+    });
+#endif//ENABLE_RTPPROXY
+}
+
 #if defined(ENABLE_RTPPROXY) || defined(ENABLE_HLS)
 #define SWITCH_CASE(codec_id) case codec_id : return #codec_id
 static const char *getCodecName(int codec_id) {
@@ -224,9 +252,84 @@ void DecoderImp::onDecode(int stream,int codecid,int flags,int64_t pts,int64_t d
             break;
     }
 }
+
+//跳过开头的aud，返回跳过的字节数
+static size_t skipAUD(const char *data, size_t bytes, bool h265) {
+    auto prefix = prefixSize(data, bytes);
+    if (!prefix || prefix >= bytes) {
+        return 0;
+    }
+    if (h265 ? H265_TYPE(data[prefix]) != H265Frame::NAL_AUD : H264_TYPE(data[prefix]) != H264Frame::NAL_AUD) {
+        return 0;
+    }
+    for (size_t i = prefix + 1; i + 3 <= bytes; ++i) {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return data[i - 1] == 0 ? i - 1 : i;
+        }
+    }
+    return bytes;
+}
+
+void DecoderImp::onFrame(int stream, int codecid, int64_t pts, int64_t dts, const Buffer::Ptr &buffer) {
+    pts /= 90;
+    dts /= 90;
+    auto data = buffer->data();
+    auto bytes = buffer->size();
+
+    //buffer已经是完整的一帧，直接包装成Frame，不再拷贝
+    switch (codecid) {
+        case PSI_STREAM_H264:
+        case PSI_STREAM_H265: {
+            bool h265 = codecid == PSI_STREAM_H265;
+            auto offset = skipAUD(data, bytes, h265);
+            if (offset >= bytes) {
+                break;
+            }
+            auto prefix = prefixSize(data + offset, bytes - offset);
+            if (h265) {
+                onFrame(std::make_shared<FrameWrapper<H265FrameNoCacheAble> >(buffer, dts, pts, prefix, offset));
+            } else {
+                onFrame(std::make_shared<FrameWrapper<H264FrameNoCacheAble> >(buffer, dts, pts, prefix, offset));
+            }
+            break;
+        }
+
+        case PSI_STREAM_AAC: {
+            uint8_t *ptr = (uint8_t *) data;
+            if (!(bytes > 7 && ptr[0] == 0xFF && (ptr[1] & 0xF0) == 0xF0)) {
+                //这不是aac
+                break;
+            }
+            onFrame(std::make_shared<FrameWrapper<FrameFromPtr> >(buffer, dts, 0, ADTS_HEADER_LEN, 0, CodecAAC));
+            break;
+        }
+
+        case PSI_STREAM_AUDIO_G711A:
+        case PSI_STREAM_AUDIO_G711U: {
+            auto codec = codecid == PSI_STREAM_AUDIO_G711A ? CodecG711A : CodecG711U;
+            onFrame(std::make_shared<FrameWrapper<FrameFromPtr> >(buffer, dts, 0, 0, 0, codec));
+            break;
+        }
+
+        case PSI_STREAM_AUDIO_OPUS: {
+            onFrame(std::make_shared<FrameWrapper<FrameFromPtr> >(buffer, dts, 0, 0, 0, CodecOpus));
+            break;
+        }
+
+        default:
+            if (codecid != 0) {
+                if (_last_unsported_print.elapsedTime() / 1000 > 5) {
+                    _last_unsported_print.resetTime();
+                    WarnL << "unsupported codec type:" << getCodecName(codecid) << " " << (int) codecid;
+                }
+            }
+            break;
+    }
+}
 #else
 void DecoderImp::onDecode(int stream,int codecid,int flags,int64_t pts,int64_t dts,const void *data,size_t bytes) {}
 void DecoderImp::onStream(int stream,int codecid,const void *extra,size_t bytes,int finish) {}
+void DecoderImp::onFrame(int stream, int codecid, int64_t pts, int64_t dts, const Buffer::Ptr &buffer) {}
 #endif
 
 void DecoderImp::onTrack(const Track::Ptr &track) {
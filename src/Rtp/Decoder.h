@@ -15,6 +15,7 @@
 #include <memory>
 #include <functional>
 #include "Common/MediaSink.h"
+#include "Rtsp/Rtsp.h"
 
 using namespace std;
 namespace mediakit {
@@ -34,6 +35,8 @@ protected:
     virtual ~Decoder() = default;
 };
 
+class PSRtpDecoder;
+
 /**
  * 合并一些时间戳相同的frame
  */
@@ -50,7 +53,9 @@ class DecoderImp{
 public:
     typedef enum {
         decoder_ts = 0,
-        decoder_ps
+        decoder_ps,
+        //直接以rtp包为输入的ps解复用器
+        decoder_ps_rtp
     }Type;
 
     typedef std::shared_ptr<DecoderImp> Ptr;
@@ -59,17 +64,25 @@ public:
     static Ptr createDecoder(Type type, MediaSinkInterface *sink);
     size_t input(const uint8_t *data, size_t bytes);
 
+    /**
+     * 输入排序后的rtp包，仅decoder_ps_rtp类型有效
+     */
+    void inputRtp(const RtpPacket::Ptr &rtp);
+
 protected:
     void onTrack(const Track::Ptr &track);
     void onFrame(const Frame::Ptr &frame);
 
 private:
     DecoderImp(const Decoder::Ptr &decoder, MediaSinkInterface *sink);
+    DecoderImp(const std::shared_ptr<PSRtpDecoder> &decoder, MediaSinkInterface *sink);
     void onDecode(int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes);
     void onStream(int stream, int codecid, const void *extra, size_t bytes, int finish);
+    void onFrame(int stream, int codecid, int64_t pts, int64_t dts, const Buffer::Ptr &buffer);
 
 private:
     Decoder::Ptr _decoder;
+    std::shared_ptr<PSRtpDecoder> _rtp_decoder;
     MediaSinkInterface *_sink;
     FrameMerger _merger;
     Ticker _last_unsported_print;
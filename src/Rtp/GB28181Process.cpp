@@ -30,11 +30,32 @@ GB28181Process::GB28181Process(const MediaInfo &media_info, MediaSinkInterface *
 
 GB28181Process::~GB28181Process() {}
 
-bool GB28181Process::inputRtp(bool, const char *data, size_t data_len) {
+bool GB28181Process::inputRtp(bool is_udp, const char *data, size_t data_len) {
+    //只有udp方式才可能丢包并请求重传
+    enableNack(is_udp && _on_nack);
     return handleOneRtp(0, TrackVideo, 90000, (unsigned char *) data, data_len);
 }
 
+void GB28181Process::setOnNack(function<void(string rtcp)> cb) {
+    _on_nack = std::move(cb);
+}
+
+void GB28181Process::onSendNack(int track_index, string rtcp) {
+    if (_on_nack) {
+        _on_nack(std::move(rtcp));
+    }
+}
+
 void GB28181Process::onRtpSorted(const RtpPacket::Ptr &rtp, int) {
+    if (_ps_decoder) {
+        //ps负载，直接解析rtp包，免去rtp合并与帧合并的内存拷贝
+        if (_save_file_ps) {
+            fwrite(rtp->data() + rtp->offset, rtp->size() - rtp->offset, 1, _save_file_ps.get());
+        }
+        _ps_decoder->inputRtp(rtp);
+        return;
+    }
+
     if (!_rtp_decoder) {
         switch (rtp->PT) {
             case 98: {
@@ -47,8 +68,6 @@ void GB28181Process::onRtpSorted(const RtpPacket::Ptr &rtp, int) {
                 if (rtp->PT != 33 && rtp->PT != 96) {
                     WarnL << "rtp payload type未识别(" << (int) rtp->PT << "),已按ts或ps负载处理";
                 }
-                //ts或ps负载
-                _rtp_decoder = std::make_shared<CommonRtpDecoder>(CodecInvalid, 32 * 1024);
                 //设置dump目录
                 GET_CONFIG(string, dump_dir, RtpProxy::kDumpDir);
                 if (!dump_dir.empty()) {
@@ -59,6 +78,15 @@ void GB28181Process::onRtpSorted(const RtpPacket::Ptr &rtp, int) {
                         }
                     });
                 }
+                if (!checkTS((uint8_t *) rtp->data() + rtp->offset, rtp->size() - rtp->offset)) {
+                    //猜测是ps负载
+                    InfoL << _media_info._streamid << " judged to be PS";
+                    _ps_decoder = DecoderImp::createDecoder(DecoderImp::decoder_ps_rtp, _interface);
+                    onRtpSorted(rtp, 0);
+                    return;
+                }
+                //ts负载
+                _rtp_decoder = std::make_shared<CommonRtpDecoder>(CodecInvalid, 32 * 1024);
                 break;
             }
         }
@@ -99,22 +127,15 @@ void GB28181Process::onRtpDecode(const Frame::Ptr &frame) {
         return;
     }
 
-    //这是TS或PS
+    //这是TS
     if (_save_file_ps) {
         fwrite(frame->data(), frame->size(), 1, _save_file_ps.get());
     }
 
     if (!_decoder) {
         //创建解码器
-        if (checkTS((uint8_t *) frame->data(), frame->size())) {
-            //猜测是ts负载
-            InfoL << _media_info._streamid << " judged to be TS";
-            _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ts, _interface);
-        } else {
-            //猜测是ps负载
-            InfoL << _media_info._streamid << " judged to be PS";
-            _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ps, _interface);
-        }
+        InfoL << _media_info._streamid << " judged to be TS";
+        _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ts, _interface);
     }
 
     if (_decoder) {
@@ -33,10 +33,16 @@ public:
      * @param data_len rtp数据长度
      * @return 是否解析成功
      */
-    bool inputRtp(bool, const char *data, size_t data_len) override;
+    bool inputRtp(bool is_udp, const char *data, size_t data_len) override;
+
+    /**
+     * 设置rtcp nack发送回调，udp方式接收时丢包后请求重传
+     */
+    void setOnNack(function<void(string rtcp)> cb);
 
 protected:
     void onRtpSorted(const RtpPacket::Ptr &rtp, int track_index) override ;
+    void onSendNack(int track_index, string rtcp) override;
     const char *onSearchPacketTail(const char *data,size_t len) override;
     ssize_t onRecvHeader(const char *data,size_t len) override { return 0; };
 
@@ -46,9 +52,12 @@ private:
 private:
     MediaInfo _media_info;
     DecoderImp::Ptr _decoder;
+    //ps负载解复用器，直接输入rtp包
+    DecoderImp::Ptr _ps_decoder;
     MediaSinkInterface *_interface;
     std::shared_ptr<FILE> _save_file_ps;
     std::shared_ptr<RtpCodec> _rtp_decoder;
+    function<void(string rtcp)> _on_nack;
 };
 
 }//namespace mediakit
@@ -0,0 +1,358 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#if defined(ENABLE_RTPPROXY)
+#include "PSRtpDecoder.h"
+
+//ps/pes起始码后的stream id
+#define PS_ID_END 0xB9
+#define PS_ID_PACK 0xBA
+#define PS_ID_SYSTEM 0xBB
+#define PS_ID_PSM 0xBC
+//单帧最大长度，超过则认为数据异常
+#define PS_MAX_FRAME_SIZE (10 * 1024 * 1024)
+
+namespace mediakit{
+
+static inline uint16_t readBE16(const char *ptr) {
+    return ((uint8_t) ptr[0] << 8) | (uint8_t) ptr[1];
+}
+
+//pes头中33位的pts/dts
+static inline int64_t readTimeStamp(const char *ptr) {
+    auto p = (const uint8_t *) ptr;
+    return ((int64_t) (p[0] & 0x0E) << 29) | (p[1] << 22) | ((p[2] & 0xFE) << 14) | (p[3] << 7) | (p[4] >> 1);
+}
+
+static inline bool isAudioOrVideo(uint8_t id) {
+    return id >= 0xC0 && id <= 0xEF;
+}
+
+void PSRtpDecoder::setOnStream(Decoder::onStream cb) {
+    _on_stream = std::move(cb);
+}
+
+void PSRtpDecoder::setOnFrame(onFrame cb) {
+    _on_frame = std::move(cb);
+}
+
+void PSRtpDecoder::inputRtp(const RtpPacket::Ptr &rtp) {
+    if (_have_seq && (uint16_t) (_last_seq + 1) != rtp->sequence) {
+        //丢包了，丢弃未完成的帧，并从下一个pack header开始重新同步
+        WarnL << "rtp丢包:" << _last_seq << " -> " << rtp->sequence;
+        reset();
+    }
+    _have_seq = true;
+    _last_seq = rtp->sequence;
+
+    auto ptr = (const uint8_t *) rtp->data() + rtp->offset;
+    auto end = (const uint8_t *) rtp->data() + rtp->size();
+    while (ptr < end) {
+        switch (_state) {
+            case state_sync: ptr = sync(ptr, end); break;
+            case state_header: ptr = readHeader(ptr, end); break;
+            case state_payload: ptr = readPayload(rtp, ptr, end); break;
+            case state_skip: ptr = skip(ptr, end); break;
+            default: return;
+        }
+    }
+}
+
+const uint8_t *PSRtpDecoder::sync(const uint8_t *ptr, const uint8_t *end) {
+    while (ptr < end) {
+        if (_header.empty()) {
+            //快速跳过非0字节
+            ptr = (const uint8_t *) memchr(ptr, 0, end - ptr);
+            if (!ptr) {
+                return end;
+            }
+        }
+        _header.push_back(*ptr++);
+        switch (_header.size()) {
+            case 1:
+            case 2: {
+                if (_header.back() != 0) {
+                    _header.clear();
+                }
+                break;
+            }
+            case 3: {
+                if (_header[2] == 0) {
+                    //00 00 00，后两个字节仍可能是起始码的一部分
+                    _header.erase(0, 1);
+                } else if (_header[2] != 1) {
+                    _header.clear();
+                }
+                break;
+            }
+            default: {
+                //00 00 01 xx，h264/h265的nalu起始码后面的字节都小于0xB9，不会被误判
+                auto id = (uint8_t) _header[3];
+                if (id >= PS_ID_END && (!_sync_pack || id == PS_ID_PACK)) {
+                    _state = state_header;
+                    return ptr;
+                }
+                _header.clear();
+                break;
+            }
+        }
+    }
+    return ptr;
+}
+
+size_t PSRtpDecoder::headerSize() const {
+    auto id = (uint8_t) _header[3];
+    switch (id) {
+        case PS_ID_END: return 4;
+        case PS_ID_PACK: {
+            if (_header.size() < 5) {
+                return 5;
+            }
+            if ((_header[4] & 0xC0) != 0x40) {
+                //mpeg1 pack header固定12字节
+                return 12;
+            }
+            if (_header.size() < 14) {
+                return 14;
+            }
+            return 14 + (_header[13] & 0x07);
+        }
+        default: break;
+    }
+
+    if (_header.size() < 6) {
+        return 6;
+    }
+    if (id == PS_ID_SYSTEM || id == PS_ID_PSM) {
+        //这两种头很小，完整读取
+        return 6 + readBE16(_header.data() + 4);
+    }
+    if (!isAudioOrVideo(id)) {
+        return 6;
+    }
+    if (_header.size() < 9) {
+        return 9;
+    }
+    if ((_header[6] & 0xC0) != 0x80) {
+        //不是mpeg2 pes头，不解析
+        return 9;
+    }
+    return 9 + (uint8_t) _header[8];
+}
+
+const uint8_t *PSRtpDecoder::readHeader(const uint8_t *ptr, const uint8_t *end) {
+    while (true) {
+        auto need = headerSize();
+        if (_header.size() >= need) {
+            onHeader();
+            return ptr;
+        }
+        if (ptr >= end) {
+            //头部跨rtp包，等待下个rtp包
+            return ptr;
+        }
+        auto size = MIN(need - _header.size(), (size_t) (end - ptr));
+        _header.append((const char *) ptr, size);
+        ptr += size;
+    }
+}
+
+void PSRtpDecoder::onHeader() {
+    auto id = (uint8_t) _header[3];
+    switch (id) {
+        case PS_ID_PACK: _sync_pack = false; break;
+        case PS_ID_PSM: onPSM(); break;
+        case PS_ID_END:
+        case PS_ID_SYSTEM: break;
+        default: {
+            if (isAudioOrVideo(id)) {
+                onPES();
+                return;
+            }
+            //其他pes(padding、私有流等)，跳过
+            _remain = readBE16(_header.data() + 4);
+            _header.clear();
+            _state = _remain ? state_skip : state_sync;
+            return;
+        }
+    }
+    _header.clear();
+    _state = state_sync;
+}
+
+void PSRtpDecoder::onPSM() {
+    auto ptr = _header.data();
+    auto size = _header.size();
+    if (size < 16) {
+        return;
+    }
+    size_t pos = 10 + readBE16(ptr + 8);
+    if (pos + 2 > size) {
+        return;
+    }
+    auto map_end = MIN(pos + 2 + readBE16(ptr + pos), size - 4/*crc32*/);
+    pos += 2;
+
+    vector<pair<int, int> > new_streams;
+    while (pos + 4 <= map_end) {
+        int stream_type = (uint8_t) ptr[pos];
+        int stream_id = (uint8_t) ptr[pos + 1];
+        pos += 4 + readBE16(ptr + pos + 2);
+        if (_streams.find(stream_id) != _streams.end()) {
+            continue;
+        }
+        auto &stream = _streams[stream_id];
+        stream.stream_type = stream_type;
+        stream.video = (stream_id & 0xF0) == 0xE0;
+        new_streams.emplace_back(stream_id, stream_type);
+    }
+
+    if (!_on_stream) {
+        return;
+    }
+    for (size_t i = 0; i < new_streams.size(); ++i) {
+        _on_stream(new_streams[i].first, new_streams[i].second, nullptr, 0, i + 1 == new_streams.size());
+    }
+}
+
+void PSRtpDecoder::onPES() {
+    auto ptr = _header.data();
+    size_t total = 6 + readBE16(ptr + 4);
+    if (_header.size() > total) {
+        WarnL << "pes头长度异常:" << _header.size() << " > " << total;
+        reset();
+        return;
+    }
+    _remain = total - _header.size();
+    _pes_stream_id = (uint8_t) ptr[3];
+
+    auto it = _streams.find(_pes_stream_id);
+    if (it == _streams.end() || (ptr[6] & 0xC0) != 0x80) {
+        //尚未收到psm或不是mpeg2 pes，跳过负载
+        _pes_stream_id = -1;
+        _header.clear();
+        _state = _remain ? state_skip : state_sync;
+        return;
+    }
+
+    int64_t pts = -1, dts = -1;
+    auto flags = ((uint8_t) ptr[7]) >> 6;
+    if ((flags & 0x02) && _header.size() >= 14) {
+        pts = readTimeStamp(ptr + 9);
+        dts = pts;
+        if (flags == 0x03 && _header.size() >= 19) {
+            dts = readTimeStamp(ptr + 14);
+        }
+    }
+
+    auto &stream = it->second;
+    auto &au = stream.au;
+    if (!au.empty() && (!stream.video || (pts != -1 && au.pts != pts))) {
+        //音频每个pes为一帧；视频时间戳变化，说明上一帧已经完整(一帧可能由多个pes组成)
+        flushAU(_pes_stream_id, stream);
+    }
+    if (au.empty()) {
+        au.pts = pts;
+        au.dts = dts;
+    }
+
+    _header.clear();
+    _state = _remain ? state_payload : state_sync;
+}
+
+const uint8_t *PSRtpDecoder::readPayload(const RtpPacket::Ptr &rtp, const uint8_t *ptr, const uint8_t *end) {
+    auto size = MIN(_remain, (size_t) (end - ptr));
+    auto it = _streams.find(_pes_stream_id);
+    if (it != _streams.end()) {
+        appendAU(it->second.au, rtp, ptr, size);
+    }
+    ptr += size;
+    _remain -= size;
+    if (_remain) {
+        return ptr;
+    }
+
+    _state = state_sync;
+    if (it != _streams.end() && !it->second.video) {
+        //音频pes接收完毕即可输出
+        flushAU(it->first, it->second);
+    }
+    return ptr;
+}
+
+const uint8_t *PSRtpDecoder::skip(const uint8_t *ptr, const uint8_t *end) {
+    auto size = MIN(_remain, (size_t) (end - ptr));
+    ptr += size;
+    _remain -= size;
+    if (!_remain) {
+        _state = state_sync;
+    }
+    return ptr;
+}
+
+void PSRtpDecoder::appendAU(AccessUnit &au, const RtpPacket::Ptr &rtp, const uint8_t *ptr, size_t size) {
+    if (!size) {
+        return;
+    }
+    if (au.bytes() + size > PS_MAX_FRAME_SIZE) {
+        WarnL << "帧太大，丢弃:" << au.bytes() + size;
+        au = AccessUnit();
+        return;
+    }
+    if (au.frame) {
+        au.frame->_buffer.append((const char *) ptr, size);
+        return;
+    }
+    if (!au.rtp) {
+        //帧的第一段数据，先引用rtp包，不拷贝
+        au.rtp = rtp;
+        au.ptr = (const char *) ptr;
+        au.size = size;
+        return;
+    }
+    //帧跨越了多个rtp包或pes，拷贝至帧缓存
+    au.frame = obtainObj();
+    au.frame->_buffer.clear();
+    au.frame->_buffer.append(au.ptr, au.size);
+    au.frame->_buffer.append((const char *) ptr, size);
+    au.rtp = nullptr;
+    au.ptr = nullptr;
+    au.size = 0;
+}
+
+void PSRtpDecoder::flushAU(int stream_id, Stream &stream) {
+    AccessUnit au;
+    std::swap(au, stream.au);
+    if (au.empty() || !au.bytes() || !_on_frame) {
+        return;
+    }
+    Buffer::Ptr buffer;
+    if (au.frame) {
+        buffer = std::move(au.frame);
+    } else {
+        //整帧都在同一个rtp包内，直接引用该rtp包
+        buffer = std::make_shared<BufferPartial>(au.rtp, au.ptr - au.rtp->data(), au.size);
+    }
+    _on_frame(stream_id, stream.stream_type, au.pts == -1 ? 0 : au.pts, au.dts == -1 ? 0 : au.dts, buffer);
+}
+
+void PSRtpDecoder::reset() {
+    for (auto &pr : _streams) {
+        pr.second.au = AccessUnit();
+    }
+    _header.clear();
+    _remain = 0;
+    _pes_stream_id = -1;
+    _sync_pack = true;
+    _state = state_sync;
+}
+
+}//namespace mediakit
+#endif//defined(ENABLE_RTPPROXY)
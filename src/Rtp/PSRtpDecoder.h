@@ -0,0 +1,111 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_PSRTPDECODER_H
+#define ZLMEDIAKIT_PSRTPDECODER_H
+
+#if defined(ENABLE_RTPPROXY)
+#include <map>
+#include "Decoder.h"
+#include "Rtsp/Rtsp.h"
+
+namespace mediakit{
+
+/**
+ * 直接以排序后的rtp包为输入的ps解复用器
+ * ps头、pes头等少量字节在跨rtp包时拷贝，es负载只拷贝一次至帧缓存(该缓存直接作为Frame输出)，
+ * 如果整帧数据都在同一个rtp包内，则直接引用该rtp包，不拷贝
+ */
+class PSRtpDecoder : public ResourcePoolHelper<FrameImp> {
+public:
+    typedef std::shared_ptr<PSRtpDecoder> Ptr;
+    typedef std::function<void(int stream, int codecid, int64_t pts, int64_t dts, const Buffer::Ptr &buffer)> onFrame;
+
+    PSRtpDecoder() = default;
+    ~PSRtpDecoder() = default;
+
+    /**
+     * 输入排序后的rtp包
+     */
+    void inputRtp(const RtpPacket::Ptr &rtp);
+
+    void setOnStream(Decoder::onStream cb);
+    void setOnFrame(onFrame cb);
+
+private:
+    typedef enum {
+        //查找起始码
+        state_sync = 0,
+        //读取ps/pes头
+        state_header,
+        //读取pes负载
+        state_payload,
+        //跳过不关心的数据
+        state_skip,
+    } State;
+
+    //一帧数据，可能引用rtp包，也可能是拷贝后的帧缓存
+    class AccessUnit {
+    public:
+        int64_t pts = -1;
+        int64_t dts = -1;
+        //引用rtp包的数据
+        RtpPacket::Ptr rtp;
+        const char *ptr = nullptr;
+        size_t size = 0;
+        //拷贝后的数据
+        FrameImp::Ptr frame;
+
+        bool empty() const { return !rtp && !frame; }
+        size_t bytes() const { return frame ? frame->_buffer.size() : size; }
+    };
+
+    class Stream {
+    public:
+        int stream_type = 0;
+        bool video = false;
+        //未输出的帧，一个视频帧可能由多个pes组成，音视频pes也可能交织
+        AccessUnit au;
+    };
+
+    const uint8_t *sync(const uint8_t *ptr, const uint8_t *end);
+    const uint8_t *readHeader(const uint8_t *ptr, const uint8_t *end);
+    const uint8_t *readPayload(const RtpPacket::Ptr &rtp, const uint8_t *ptr, const uint8_t *end);
+    const uint8_t *skip(const uint8_t *ptr, const uint8_t *end);
+
+    size_t headerSize() const;
+    void onHeader();
+    void onPSM();
+    void onPES();
+
+    void appendAU(AccessUnit &au, const RtpPacket::Ptr &rtp, const uint8_t *ptr, size_t size);
+    void flushAU(int stream_id, Stream &stream);
+    void reset();
+
+private:
+    State _state = state_sync;
+    //是否需要从pack header开始同步(初始化或丢包后)
+    bool _sync_pack = true;
+    uint16_t _last_seq = 0;
+    bool _have_seq = false;
+    //当前ps/pes头数据(只包含头部，很小)
+    string _header;
+    //当前pes剩余负载或需跳过的字节数
+    size_t _remain = 0;
+    //当前pes所属流id
+    int _pes_stream_id = -1;
+    map<int, Stream> _streams;
+    Decoder::onStream _on_stream;
+    onFrame _on_frame;
+};
+
+}//namespace mediakit
+#endif//defined(ENABLE_RTPPROXY)
+#endif //ZLMEDIAKIT_PSRTPDECODER_H
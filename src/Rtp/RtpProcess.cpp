@@ -17,6 +17,9 @@
 
 #define RTP_APP_NAME "rtp"
 
+//休眠状态恢复时等待关键帧的最长时间，超过后不再等待(设备可能不在I帧前发送ps系统头)
+static constexpr uint64_t kParkedMaxWaitMS = 5000;
+
 namespace mediakit {
 
 static string printAddress(const struct sockaddr *addr) {
@@ -70,8 +73,51 @@ RtpProcess::~RtpProcess() {
     }
 }
 
+static bool isRtp(const char *data, size_t len) {
+    return len >= 12 && (((uint8_t *) data)[0] >> 6) == 2;
+}
+
+//判断rtp负载是否为ps关键帧的起始(ps包头后紧跟系统头，国标设备只在I帧前发送系统头)
+static bool isKeyFrameStart(const char *data, size_t len) {
+    auto ptr = (uint8_t *) data;
+    if (!isRtp(data, len)) {
+        return false;
+    }
+    size_t offset = 12 + (ptr[0] & 0x0F) * 4;
+    if (ptr[0] & 0x10) {
+        //跳过扩展头
+        if (len < offset + 4) {
+            return false;
+        }
+        offset += 4 + ((ptr[offset + 2] << 8) | ptr[offset + 3]) * 4;
+    }
+    if (len < offset + 4) {
+        return false;
+    }
+    ptr += offset;
+    len -= offset;
+    if (ptr[0] == 0x47) {
+        //ts负载，无法廉价判断关键帧，直接恢复解复用
+        return true;
+    }
+    if (ptr[0] != 0x00 || ptr[1] != 0x00 || ptr[2] != 0x01 || ptr[3] != 0xBA) {
+        //不是ps包起始
+        return false;
+    }
+    if (len < 14 || (ptr[4] & 0xC0) != 0x40) {
+        //mpeg1 ps，直接恢复解复用
+        return true;
+    }
+    //跳过ps包头及其填充字节
+    size_t pack_size = 14 + (ptr[13] & 0x07);
+    if (len < pack_size + 4) {
+        return false;
+    }
+    ptr += pack_size;
+    return ptr[0] == 0x00 && ptr[1] == 0x00 && ptr[2] == 0x01 && ptr[3] == 0xBB;
+}
+
 bool RtpProcess::inputRtp(bool is_udp, const Socket::Ptr &sock, const char *data, size_t len, const struct sockaddr *addr, uint32_t *dts_out) {
-    GET_CONFIG(bool, check_source, RtpProxy::kCheckSource);
     //检查源是否合法
     if (!_addr) {
         _addr = new struct sockaddr;
@@ -87,12 +133,44 @@ bool RtpProcess::inputRtp(bool is_udp, const Socket::Ptr &sock, const char *data
         return false;
     }
 
+    _total_bytes += len;
+    ++_total_packets;
+    _bytes_speed += len;
+
+    GET_CONFIG(bool, check_source, RtpProxy::kCheckSource);
     if (check_source && memcmp(_addr, addr, sizeof(struct sockaddr)) != 0) {
+        //休眠期间也要检查，否则其他源的数据会让已经断开的流一直不超时
         DebugP(this) << "address dismatch:" << printAddress(addr) << " != " << printAddress(_addr);
         return false;
     }
 
-    _total_bytes += len;
+    if (!dts_out && !_save_file_rtp && !_muxer->isEnabled()) {
+        //无人访问、且不取时间戳、不导出调试文件时，进入休眠状态直接丢弃数据，
+        //并释放解复用器及其缓存，休眠期间收到rtp包时刷新超时计时器(代替解复用出帧)
+        if (!_parked) {
+            DebugP(this) << "无人观看，暂停解复用";
+            _parked = true;
+            _process = nullptr;
+        }
+        _parked_ticker.resetTime();
+        if (isRtp(data, len)) {
+            _last_frame_time.resetTime();
+        }
+        return false;
+    }
+
+    if (_parked) {
+        //有人观看了，等到关键帧再恢复解复用，防止新的观看者花屏
+        if (!isKeyFrameStart(data, len) && _parked_ticker.elapsedTime() < kParkedMaxWaitMS) {
+            if (isRtp(data, len)) {
+                _last_frame_time.resetTime();
+            }
+            return false;
+        }
+        DebugP(this) << "恢复解复用";
+        _parked = false;
+    }
+
     if (_save_file_rtp) {
         uint16_t size = (uint16_t)len;
         size = htons(size);
@@ -100,23 +178,43 @@ bool RtpProcess::inputRtp(bool is_udp, const Socket::Ptr &sock, const char *data
         fwrite((uint8_t *) data, len, 1, _save_file_rtp.get());
     }
     if (!_process) {
-        _process = std::make_shared<GB28181Process>(_media_info, this);
-    }
-
-    GET_CONFIG(string, dump_dir, RtpProxy::kDumpDir);
-    if (!_muxer->isEnabled() && !dts_out && dump_dir.empty()) {
-        //无人访问、且不取时间戳、不导出调试文件时，我们可以直接丢弃数据
-        _last_frame_time.resetTime();
-        return false;
+        auto process = std::make_shared<GB28181Process>(_media_info, this);
+        process->setOnNack([this](string rtcp) {
+            sendRtcp(std::move(rtcp));
+        });
+        _process = std::move(process);
     }
 
-    bool ret = _process ? _process->inputRtp(is_udp, data, len) : false;
+    bool ret = _process->inputRtp(is_udp, data, len);
     if (dts_out) {
         *dts_out = _dts;
     }
     return ret;
 }
 
+void RtpProcess::sendRtcp(string rtcp) {
+    if (!_sock || !_addr || _addr->sa_family != AF_INET) {
+        return;
+    }
+    //按照惯例，rtcp端口为rtp端口+1
+    struct sockaddr addr = *_addr;
+    auto addr_in = (struct sockaddr_in *) &addr;
+    addr_in->sin_port = htons(ntohs(addr_in->sin_port) + 1);
+    _sock->send(std::move(rtcp), &addr, sizeof(addr));
+}
+
+uint64_t RtpProcess::getTotalBytes() const {
+    return _total_bytes;
+}
+
+uint64_t RtpProcess::getTotalPackets() const {
+    return _total_packets;
+}
+
+int RtpProcess::getBytesSpeed() {
+    return _bytes_speed.getSpeed();
+}
+
 void RtpProcess::inputFrame(const Frame::Ptr &frame) {
     _last_frame_time.resetTime();
     _dts = frame->dts();
@@ -127,10 +225,24 @@ void RtpProcess::inputFrame(const Frame::Ptr &frame) {
 }
 
 void RtpProcess::addTrack(const Track::Ptr &track) {
+    auto it = _track_codec.find(track->getTrackType());
+    if (it != _track_codec.end() && it->second == track->getCodecId()) {
+        //休眠恢复后重建的解复用器再次生成了相同的track，沿用之前的track即可
+        return;
+    }
+    //首次生成或者编码改变了的track
+    _track_codec[track->getTrackType()] = track->getCodecId();
+    _track_changed = true;
     _muxer->addTrack(track);
 }
 
 void RtpProcess::addTrackCompleted() {
+    if (_track_completed && !_track_changed) {
+        //休眠恢复后重建的解复用器生成的track与之前一致
+        return;
+    }
+    _track_completed = true;
+    _track_changed = false;
     _muxer->addTrackCompleted();
 }
 
@@ -64,6 +64,14 @@ public:
     string getIdentifier() const override;
 
     int getTotalReaderCount();
+
+    /**
+     * 获取收流统计信息：累计字节数、累计rtp包数、接收速率(bytes/s)
+     */
+    uint64_t getTotalBytes() const;
+    uint64_t getTotalPackets() const;
+    int getBytesSpeed();
+
     void setListener(const std::weak_ptr<MediaSourceEvent> &listener);
 
 protected:
@@ -79,10 +87,22 @@ protected:
 
 private:
     void emitOnPublish();
+    void sendRtcp(string rtcp);
 
 private:
     uint32_t _dts = 0;
     uint64_t _total_bytes = 0;
+    uint64_t _total_packets = 0;
+    BytesSpeed _bytes_speed;
+    //无人观看时进入休眠状态，丢弃数据并释放解复用器
+    bool _parked = false;
+    //已经添加到muxer的track类型及其编码，休眠恢复后重建的解复用器会再次生成这些track
+    map<TrackType, CodecId> _track_codec;
+    //muxer是否已经addTrackCompleted，以及此后是否有新的track
+    bool _track_completed = false;
+    bool _track_changed = false;
+    //休眠期间为最后一次丢弃数据的时间，恢复时用于计算等待关键帧的时长
+    Ticker _parked_ticker;
     struct sockaddr *_addr = nullptr;
     Socket::Ptr _sock;
     MediaInfo _media_info;
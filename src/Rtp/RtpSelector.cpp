@@ -20,6 +20,8 @@ INSTANCE_IMP(RtpSelector);
 void RtpSelector::clear(){
     lock_guard<decltype(_mtx_map)> lck(_mtx_map);
     _map_rtp_process.clear();
+    _map_ssrc.clear();
+    ++_generation;
 }
 
 bool RtpSelector::inputRtp(const Socket::Ptr &sock, const char *data, size_t data_len,
@@ -29,12 +31,12 @@ bool RtpSelector::inputRtp(const Socket::Ptr &sock, const char *data, size_t dat
         WarnL << "get ssrc from rtp failed:" << data_len;
         return false;
     }
-    auto process = getProcess(printSSRC(ssrc), true);
+    auto process = getProcess(ssrc);
     if (process) {
         try {
             return process->inputRtp(true, sock, data, data_len, addr, dts_out);
         } catch (...) {
-            delProcess(printSSRC(ssrc), process.get());
+            delProcess(process->getIdentifier(), process.get());
             throw;
         }
     }
@@ -65,6 +67,49 @@ RtpProcess::Ptr RtpSelector::getProcess(const string &stream_id,bool makeNew) {
     return ref->getProcess();
 }
 
+RtpProcess::Ptr RtpSelector::getProcess(uint32_t ssrc) {
+    //每个poller线程缓存本线程处理过的ssrc，单端口分片模式下同一ssrc固定由同一线程接收，
+    //命中缓存时无需加全局锁
+    struct ProcessCache {
+        uint64_t generation = 0;
+        SSRCTable<weak_ptr<RtpProcess> > processes;
+    };
+    static thread_local ProcessCache s_cache;
+
+    auto generation = _generation.load(memory_order_acquire);
+    if (s_cache.generation != generation) {
+        //有rtp处理器被删除，清空缓存
+        s_cache.processes.clear();
+        s_cache.generation = generation;
+    }
+
+    auto cached = s_cache.processes.find(ssrc);
+    if (cached) {
+        auto process = cached->lock();
+        if (process) {
+            return process;
+        }
+    }
+
+    RtpProcess::Ptr process;
+    {
+        lock_guard<decltype(_mtx_map)> lck(_mtx_map);
+        auto helper = _map_ssrc.find(ssrc);
+        if (helper) {
+            process = (*helper)->getProcess();
+        } else {
+            //该ssrc首次出现，只有此时才需要格式化流id
+            auto stream_id = printSSRC(ssrc);
+            process = getProcess(stream_id, true);
+            auto &ref = _map_rtp_process[stream_id];
+            ref->setSSRC(ssrc);
+            _map_ssrc[ssrc] = ref.get();
+        }
+    }
+    s_cache.processes[ssrc] = process;
+    return process;
+}
+
 void RtpSelector::createTimer() {
     if (!_timer) {
         //创建超时管理定时器
@@ -92,29 +137,34 @@ void RtpSelector::delProcess(const string &stream_id,const RtpProcess *ptr) {
             return;
         }
         process = it->second->getProcess();
+        uint32_t ssrc;
+        if (it->second->getSSRC(ssrc)) {
+            _map_ssrc.erase(ssrc);
+        }
         _map_rtp_process.erase(it);
+        ++_generation;
     }
     process->onDetach();
 }
 
 void RtpSelector::onManager() {
-    List<RtpProcess::Ptr> clear_list;
+    //在锁外检查超时，避免流很多时长时间阻塞收包线程
+    vector<RtpProcess::Ptr> processes;
     {
         lock_guard<decltype(_mtx_map)> lck(_mtx_map);
-        for (auto it = _map_rtp_process.begin(); it != _map_rtp_process.end();) {
-            if (it->second->getProcess()->alive()) {
-                ++it;
-                continue;
-            }
-            WarnL << "RtpProcess timeout:" << it->first;
-            clear_list.emplace_back(it->second->getProcess());
-            it = _map_rtp_process.erase(it);
+        processes.reserve(_map_rtp_process.size());
+        for (auto &pr : _map_rtp_process) {
+            processes.emplace_back(pr.second->getProcess());
         }
     }
 
-    clear_list.for_each([](const RtpProcess::Ptr &process) {
-        process->onDetach();
-    });
+    for (auto &process : processes) {
+        if (process->alive()) {
+            continue;
+        }
+        WarnL << "RtpProcess timeout:" << process->getIdentifier();
+        delProcess(process->getIdentifier(), process.get());
+    }
 }
 
 RtpSelector::RtpSelector() {
@@ -158,5 +208,15 @@ RtpProcess::Ptr &RtpProcessHelper::getProcess() {
     return _process;
 }
 
+void RtpProcessHelper::setSSRC(uint32_t ssrc) {
+    _has_ssrc = true;
+    _ssrc = ssrc;
+}
+
+bool RtpProcessHelper::getSSRC(uint32_t &ssrc) const {
+    ssrc = _ssrc;
+    return _has_ssrc;
+}
+
 }//namespace mediakit
 #endif//defined(ENABLE_RTPPROXY)
\ No newline at end of file
@@ -14,6 +14,8 @@
 #if defined(ENABLE_RTPPROXY)
 #include <stdint.h>
 #include <mutex>
+#include <atomic>
+#include <vector>
 #include <unordered_map>
 #include "RtpProcess.h"
 #include "Common/MediaSource.h"
@@ -29,6 +31,12 @@ public:
     void attachEvent();
     RtpProcess::Ptr & getProcess();
 
+    /**
+     * 单端口多流模式下，记录该处理器对应的ssrc
+     */
+    void setSSRC(uint32_t ssrc);
+    bool getSSRC(uint32_t &ssrc) const;
+
 protected:
     // 通知其停止推流
     bool close(MediaSource &sender,bool force) override;
@@ -39,6 +47,124 @@ private:
     weak_ptr<RtpSelector > _parent;
     RtpProcess::Ptr _process;
     string _stream_id;
+    bool _has_ssrc = false;
+    uint32_t _ssrc = 0;
+};
+
+/**
+ * 以ssrc为key的开放寻址哈希表(线性探测)，相比unordered_map无需为每个元素单独申请内存，查找时内存连续
+ * 删除元素时后移填补空位，不留删除标记，所以长期增删后查找性能不退化
+ */
+template <typename T>
+class SSRCTable {
+public:
+    SSRCTable() = default;
+    ~SSRCTable() = default;
+
+    T *find(uint32_t ssrc) {
+        if (!_size) {
+            return nullptr;
+        }
+        for (auto i = index(ssrc);; i = (i + 1) & _mask) {
+            auto &slot = _slots[i];
+            if (!slot.used) {
+                return nullptr;
+            }
+            if (slot.ssrc == ssrc) {
+                return &slot.value;
+            }
+        }
+    }
+
+    T &operator[](uint32_t ssrc) {
+        if ((_size + 1) * 2 > _slots.size()) {
+            //负载因子保持在0.5以下
+            rehash(_slots.empty() ? 16 : _slots.size() * 2);
+        }
+        for (auto i = index(ssrc);; i = (i + 1) & _mask) {
+            auto &slot = _slots[i];
+            if (!slot.used) {
+                slot.used = true;
+                slot.ssrc = ssrc;
+                slot.value = T();
+                ++_size;
+                return slot.value;
+            }
+            if (slot.ssrc == ssrc) {
+                return slot.value;
+            }
+        }
+    }
+
+    bool erase(uint32_t ssrc) {
+        if (!_size) {
+            return false;
+        }
+        auto i = index(ssrc);
+        while (true) {
+            auto &slot = _slots[i];
+            if (!slot.used) {
+                return false;
+            }
+            if (slot.ssrc == ssrc) {
+                break;
+            }
+            i = (i + 1) & _mask;
+        }
+        //把后续冲突的元素前移填补空位
+        auto hole = i;
+        for (auto j = (i + 1) & _mask; _slots[j].used; j = (j + 1) & _mask) {
+            auto home = index(_slots[j].ssrc);
+            //home不在(hole, j]区间内时，该元素可以移动到空位
+            if (((j - home) & _mask) >= ((j - hole) & _mask)) {
+                _slots[hole] = std::move(_slots[j]);
+                hole = j;
+            }
+        }
+        _slots[hole].used = false;
+        _slots[hole].value = T();
+        --_size;
+        return true;
+    }
+
+    void clear() {
+        _slots.clear();
+        _mask = 0;
+        _size = 0;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    size_t index(uint32_t ssrc) const {
+        //ssrc一般为随机数或者国标编码的后几位，乘法散列后混合高低位
+        uint32_t hash = ssrc * 2654435761U;
+        return (size_t) (hash ^ (hash >> 16)) & _mask;
+    }
+
+    void rehash(size_t capacity) {
+        vector<Slot> slots(capacity);
+        slots.swap(_slots);
+        _mask = capacity - 1;
+        _size = 0;
+        for (auto &slot : slots) {
+            if (slot.used) {
+                (*this)[slot.ssrc] = std::move(slot.value);
+            }
+        }
+    }
+
+private:
+    struct Slot {
+        bool used = false;
+        uint32_t ssrc = 0;
+        T value;
+    };
+    size_t _mask = 0;
+    size_t _size = 0;
+    vector<Slot> _slots;
 };
 
 class RtpSelector : public std::enable_shared_from_this<RtpSelector>{
@@ -85,10 +211,20 @@ private:
     void onManager();
     void createTimer();
 
+    /**
+     * 根据ssrc获取rtp处理器，优先查找本线程缓存
+     */
+    RtpProcess::Ptr getProcess(uint32_t ssrc);
+
 private:
+    //rtp处理器被删除时递增，用于使各线程的ssrc缓存失效
+    atomic<uint64_t> _generation{0};
     Timer::Ptr _timer;
     recursive_mutex _mtx_map;
+    //以流id为key，供api及tcp/指定流id的端口使用
     unordered_map<string,RtpProcessHelper::Ptr> _map_rtp_process;
+    //单端口多流模式下以ssrc为key的索引，与_map_rtp_process同步增删
+    SSRCTable<RtpProcessHelper *> _map_ssrc;
 };
 
 }//namespace mediakit
@@ -18,9 +18,8 @@ namespace mediakit{
 
 RtpSender::RtpSender(uint32_t ssrc, uint8_t payload_type) {
     _poller = EventPollerPool::Instance().getPoller();
-    _interface = std::make_shared<RtpCachePS>([this](std::shared_ptr<List<Buffer::Ptr> > list) {
-        onFlushRtpList(std::move(list));
-    }, ssrc, payload_type);
+    _ssrc = ssrc;
+    _payload_type = payload_type;
 }
 
 RtpSender::~RtpSender() {
@@ -98,25 +97,66 @@ void RtpSender::onConnect(){
 }
 
 void RtpSender::addTrack(const Track::Ptr &track){
+    if (!_interface) {
+        //使用共享编码器时不会调用本函数，此时才创建自己的编码器
+        _interface = std::make_shared<RtpCachePS>([this](std::shared_ptr<List<Buffer::Ptr> > list) {
+            onFlushRtpList(std::move(list));
+        }, _ssrc, _payload_type);
+    }
     _interface->addTrack(track);
 }
 
 void RtpSender::addTrackCompleted(){
-    _interface->addTrackCompleted();
+    if (_interface) {
+        _interface->addTrackCompleted();
+    }
 }
 
 void RtpSender::resetTracks(){
-    _interface->resetTracks();
+    if (_interface) {
+        _interface->resetTracks();
+    }
+}
+
+bool RtpSender::isConnected() const {
+    return _is_connect;
 }
 
 //此函数在其他线程执行
 void RtpSender::inputFrame(const Frame::Ptr &frame) {
-    if (_is_connect) {
+    if (_is_connect && _interface) {
         //连接成功后才做实质操作(节省cpu资源)
         _interface->inputFrame(frame);
     }
 }
 
+//此函数在其他线程执行
+void RtpSender::inputRtpList(const std::shared_ptr<List<Buffer::Ptr> > &rtp_list, bool copy) {
+    if (!_is_connect) {
+        return;
+    }
+    auto out = std::make_shared<List<Buffer::Ptr> >();
+    rtp_list->for_each([&](Buffer::Ptr &packet) {
+        Buffer::Ptr rtp = packet;
+        if (copy) {
+            auto buffer = std::make_shared<BufferRaw>();
+            buffer->assign(packet->data(), packet->size());
+            rtp = std::move(buffer);
+        }
+        //跳过rtp over tcp的4个字节头，只改写rtp头中的seq与ssrc
+        auto ptr = (uint8_t *) rtp->data() + 4;
+        auto seq = _seq++;
+        ptr[2] = seq >> 8;
+        ptr[3] = seq & 0xFF;
+        ptr[8] = _ssrc >> 24;
+        ptr[9] = (_ssrc >> 16) & 0xFF;
+        ptr[10] = (_ssrc >> 8) & 0xFF;
+        ptr[11] = _ssrc & 0xFF;
+        out->emplace_back(std::move(rtp));
+    });
+    onFlushRtpList(std::move(out));
+}
+
 //此函数在其他线程执行
 void RtpSender::onFlushRtpList(shared_ptr<List<Buffer::Ptr> > rtp_list) {
     if(!_is_connect){
@@ -168,5 +208,62 @@ void RtpSender::onErr(const SockException &ex, bool is_connect) {
     }, _poller);
 }
 
+/////////////////////////////RtpSenderGroup/////////////////////////////////
+
+RtpSenderGroup::RtpSenderGroup(uint8_t payload_type) {
+    //共享编码器的ssrc无意义，发送时会被改写为各发送目标的ssrc
+    _encoder = std::make_shared<RtpCachePS>([this](std::shared_ptr<List<Buffer::Ptr> > list) {
+        onFlushRtpList(std::move(list));
+    }, 0, payload_type);
+}
+
+void RtpSenderGroup::addSender(const string &ssrc, const RtpSender::Ptr &sender) {
+    _senders[ssrc] = sender;
+}
+
+size_t RtpSenderGroup::removeSender(const string &ssrc) {
+    if (ssrc.empty()) {
+        auto size = _senders.size();
+        _senders.clear();
+        return size;
+    }
+    return _senders.erase(ssrc);
+}
+
+bool RtpSenderGroup::empty() const {
+    return _senders.empty();
+}
+
+void RtpSenderGroup::inputFrame(const Frame::Ptr &frame) {
+    for (auto &pr : _senders) {
+        if (pr.second->isConnected()) {
+            //至少有一个目标连接成功才做编码(节省cpu资源)
+            _encoder->inputFrame(frame);
+            return;
+        }
+    }
+}
+
+void RtpSenderGroup::addTrack(const Track::Ptr &track) {
+    _encoder->addTrack(track);
+}
+
+void RtpSenderGroup::addTrackCompleted() {
+    _encoder->addTrackCompleted();
+}
+
+void RtpSenderGroup::resetTracks() {
+    _encoder->resetTracks();
+}
+
+void RtpSenderGroup::onFlushRtpList(std::shared_ptr<List<Buffer::Ptr> > rtp_list) {
+    size_t i = 0;
+    auto size = _senders.size();
+    for (auto &pr : _senders) {
+        //最后一个发送目标直接改写共享的rtp包，其他目标需要拷贝后改写
+        pr.second->inputRtpList(rtp_list, ++i != size);
+    }
+}
+
 }//namespace mediakit
 #endif// defined(ENABLE_RTPPROXY)
\ No newline at end of file
@@ -61,6 +61,19 @@ public:
      */
     virtual void resetTracks() override;
 
+    /**
+     * 是否已经连接目标端口
+     */
+    bool isConnected() const;
+
+    /**
+     * 发送共享编码器生成的rtp包，本对象不再自行做ps/rtp编码
+     * 发送前会把ssrc与seq改写为本发送目标的值
+     * @param rtp_list 共享编码器输出的rtp包
+     * @param copy 是否需要拷贝rtp包后再改写(其他发送目标也引用了这些rtp包时必须拷贝)
+     */
+    void inputRtpList(const std::shared_ptr<List<Buffer::Ptr> > &rtp_list, bool copy);
+
 private:
     //合并写输出
     void onFlushRtpList(std::shared_ptr<List<Buffer::Ptr> > rtp_list);
@@ -72,6 +85,9 @@ private:
 private:
     bool _is_udp;
     bool _is_connect = false;
+    uint8_t _payload_type;
+    uint16_t _seq = 0;
+    uint32_t _ssrc;
     string _dst_url;
     uint16_t _dst_port;
 	uint16_t _src_port;
@@ -81,6 +97,51 @@ private:
     MediaSinkInterface::Ptr _interface;
 };
 
+/**
+ * 同一路流级联至多个上级平台时，共享一份ps/rtp编码结果，
+ * 只改写每个发送目标的ssrc与seq，避免每个目标重复做ps复用与rtp打包
+ * 本对象非线程安全，由调用者加锁
+ */
+class RtpSenderGroup : public MediaSinkInterface {
+public:
+    typedef std::shared_ptr<RtpSenderGroup> Ptr;
+
+    /**
+     * @param payload_type 共享编码器的pt，同一路流内pt与mtu(rtp.rtpMaxSize)相同的发送目标共用同一组
+     */
+    RtpSenderGroup(uint8_t payload_type = 96);
+    ~RtpSenderGroup() override = default;
+
+    /**
+     * 添加发送目标，已存在相同ssrc的目标将被替换
+     */
+    void addSender(const string &ssrc, const RtpSender::Ptr &sender);
+
+    /**
+     * 移除发送目标
+     * @param ssrc 为空时移除全部
+     * @return 移除的个数
+     */
+    size_t removeSender(const string &ssrc);
+
+    /**
+     * 发送目标是否为空
+     */
+    bool empty() const;
+
+    void inputFrame(const Frame::Ptr &frame) override;
+    void addTrack(const Track::Ptr &track) override;
+    void addTrackCompleted() override;
+    void resetTracks() override;
+
+private:
+    void onFlushRtpList(std::shared_ptr<List<Buffer::Ptr> > rtp_list);
+
+private:
+    MediaSinkInterface::Ptr _encoder;
+    unordered_map<string, RtpSender::Ptr> _senders;
+};
+
 }//namespace mediakit
 #endif// defined(ENABLE_RTPPROXY)
 #endif //ZLMEDIAKIT_RTPSENDER_H
@@ -11,6 +11,10 @@
 #if defined(ENABLE_RTPPROXY)
 #include "RtpServer.h"
 #include "RtpSelector.h"
+#include "Common/config.h"
+#if defined(__linux__)
+#include <linux/filter.h>
+#endif
 namespace mediakit{
 
 RtpServer::RtpServer() {
@@ -22,10 +26,80 @@ RtpServer::~RtpServer() {
     }
 }
 
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+//给SO_REUSEPORT分组挂载cbpf程序，按rtp ssrc对分组内socket个数取模，使同一路流固定由同一socket(线程)接收
+static bool attachSSRCSteering(int fd, uint32_t shards) {
+    //reuseport bpf程序的数据起始位置为udp负载，rtp头第8个字节开始为ssrc
+    struct sock_filter code[] = {
+            {BPF_LD | BPF_W | BPF_ABS, 0, 0, 8},
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, shards},
+            {BPF_RET | BPF_A, 0, 0, 0},
+    };
+    struct sock_fprog prog = {sizeof(code) / sizeof(code[0]), code};
+    return 0 == setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+}
+#endif
+
+vector<Socket::Ptr> RtpServer::createUdpShards(uint16_t local_port, const char *local_ip) {
+    vector<Socket::Ptr> ret;
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+    GET_CONFIG(uint32_t, udp_shards, RtpProxy::kUdpShards);
+    vector<EventPoller::Ptr> pollers;
+    EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+        pollers.emplace_back(dynamic_pointer_cast<EventPoller>(executor));
+    });
+    auto shards = udp_shards ? udp_shards : pollers.size();
+    if (shards <= 1 || pollers.empty()) {
+        return ret;
+    }
+
+    //开启SO_REUSEPORT后其他进程也能绑定同一端口并被内核分走部分ssrc，
+    //所以先用不带任何端口复用选项的socket探测，端口已被占用时报错，不开启分片
+    int probe_fd = (int) socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (probe_fd == -1) {
+        return ret;
+    }
+    bool in_use = SockUtil::bindSock(probe_fd, local_ip, local_port) == -1;
+    string err = in_use ? get_uv_errmsg(true) : "";
+    close(probe_fd);
+    if (in_use) {
+        throw std::runtime_error(StrPrinter << "bindUdpSock on " << local_ip << ":" << local_port << " failed:" << err);
+    }
+
+    for (size_t i = 0; i < shards; ++i) {
+        //分片个数可以大于poller个数，此时多个socket共用一个poller
+        auto sock = Socket::createSocket(pollers[i % pollers.size()], true);
+        if (!sock->bindUdpSock(local_port, local_ip, true)) {
+            WarnL << "创建rtp udp分片失败:" << local_ip << ":" << local_port << " " << get_uv_errmsg(true);
+            return vector<Socket::Ptr>();
+        }
+        //设置udp socket读缓存
+        SockUtil::setRecvBuf(sock->rawFD(), 4 * 1024 * 1024);
+        ret.emplace_back(std::move(sock));
+    }
+
+    //cbpf返回的下标为socket加入分组的顺序，所以必须在所有socket绑定完毕后挂载
+    if (!attachSSRCSteering(ret[0]->rawFD(), (uint32_t) ret.size())) {
+        //挂载失败时内核按四元组hash分流，同一个摄像头仍然固定由同一socket接收
+        WarnL << "挂载rtp ssrc分流cbpf程序失败:" << get_uv_errmsg(true);
+    }
+    InfoL << "rtp单端口模式启用" << ret.size() << "个udp分片:" << local_ip << ":" << local_port;
+#endif
+    return ret;
+}
+
 void RtpServer::start(uint16_t local_port, const string &stream_id,  bool enable_tcp, const char *local_ip) {
+    vector<Socket::Ptr> udp_shards;
+    if (stream_id.empty() && local_port) {
+        //单端口多流模式，尝试在多个线程上收包
+        udp_shards = createUdpShards(local_port, local_ip);
+    }
+
     //创建udp服务器
     Socket::Ptr udp_server = Socket::createSocket(nullptr, true);
-    if (local_port == 0) {
+    if (!udp_shards.empty()) {
+        udp_server = udp_shards[0];
+    } else if (local_port == 0) {
         //随机端口，rtp端口采用偶数
         Socket::Ptr rtcp_server = Socket::createSocket(nullptr, true);
         auto pair = std::make_pair(udp_server, rtcp_server);
@@ -56,26 +130,100 @@ void RtpServer::start(uint16_t local_port, const string &stream_id,  bool enable
         });
     } else {
         //未指定流id，一个端口多个流，通过ssrc来分流
+        if (udp_shards.empty()) {
+            udp_shards.emplace_back(udp_server);
+        }
         auto &ref = RtpSelector::Instance();
-        udp_server->setOnRead([&ref, udp_server](const Buffer::Ptr &buf, struct sockaddr *addr, int) {
-            ref.inputRtp(udp_server, buf->data(), buf->size(), addr);
-        });
+        for (auto &sock : udp_shards) {
+            //分片模式下每个socket在各自的poller线程触发回调，循环引用在_on_clearup中去除
+            sock->setOnRead([&ref, sock](const Buffer::Ptr &buf, struct sockaddr *addr, int) {
+                ref.inputRtp(sock, buf->data(), buf->size(), addr);
+            });
+        }
     }
 
-    _on_clearup = [udp_server, process, stream_id]() {
+    _on_clearup = [udp_server, udp_shards, process, stream_id]() {
         //去除循环引用
         udp_server->setOnRead(nullptr);
+        for (auto &sock : udp_shards) {
+            sock->setOnRead(nullptr);
+        }
         if (process) {
             //删除rtp处理器
             RtpSelector::Instance().delProcess(stream_id, process.get());
         }
     };
 
+    _stream_id = stream_id;
     _tcp_server = tcp_server;
     _udp_server = udp_server;
+    _udp_shards = udp_shards;
     _rtp_process = process;
 }
 
+void RtpServer::connectToServer(const string &url, uint16_t port, const function<void(const SockException &ex)> &cb) {
+    if (!_udp_server) {
+        cb(SockException(Err_other, "rtp服务器未启动"));
+        return;
+    }
+    auto sock = Socket::createSocket(_udp_server->getPoller(), false);
+    //未开启tcp被动模式时，使用与udp相同的本地端口，与sdp中协商的端口一致
+    uint16_t local_port = _tcp_server ? 0 : _udp_server->get_local_port();
+    weak_ptr<RtpServer> weak_self = shared_from_this();
+    sock->connect(url, port, [weak_self, sock, cb, url, port](const SockException &err) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            cb(SockException(Err_other, "rtp服务器已销毁"));
+            return;
+        }
+        if (err) {
+            WarnL << "连接rtp tcp主动模式目标失败:" << url << ":" << port << " " << err.what();
+        } else {
+            strong_self->onConnect(sock);
+        }
+        cb(err);
+    }, 5.0F, "0.0.0.0", local_port);
+}
+
+void RtpServer::onConnect(const Socket::Ptr &sock) {
+    auto session = std::make_shared<RtpSession>(sock);
+    session->setStreamID(_stream_id);
+
+    weak_ptr<RtpSession> weak_session = session;
+    sock->setOnRead([weak_session](const Buffer::Ptr &buf, struct sockaddr *, int) {
+        auto strong_session = weak_session.lock();
+        if (strong_session) {
+            strong_session->onRecv(buf);
+        }
+    });
+
+    weak_ptr<RtpServer> weak_self = shared_from_this();
+    sock->setOnErr([weak_self, weak_session](const SockException &err) {
+        auto strong_session = weak_session.lock();
+        if (!strong_session) {
+            return;
+        }
+        strong_session->onError(err);
+        auto strong_self = weak_self.lock();
+        if (strong_self && strong_self->_tcp_session == strong_session) {
+            //移除会话，下次可以重新连接
+            strong_self->_tcp_session = nullptr;
+            strong_self->_tcp_session_timer = nullptr;
+        }
+    });
+
+    //与TcpServer一致，定时触发会话的onManager，用于超时检测
+    _tcp_session_timer = std::make_shared<Timer>(2.0f, [weak_session]() {
+        auto strong_session = weak_session.lock();
+        if (!strong_session) {
+            return false;
+        }
+        strong_session->onManager();
+        return true;
+    }, sock->getPoller());
+    _tcp_session = std::move(session);
+}
+
 void RtpServer::setOnDetach(const function<void()> &cb){
     if(_rtp_process){
         _rtp_process->setOnDetach(cb);
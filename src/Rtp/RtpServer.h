@@ -15,6 +15,7 @@
 #include <memory>
 #include "Network/Socket.h"
 #include "Network/TcpServer.h"
+#include "Poller/Timer.h"
 #include "RtpSession.h"
 
 using namespace std;
@@ -25,7 +26,7 @@ namespace mediakit{
 /**
  * RTP服务器，支持UDP/TCP
  */
-class RtpServer {
+class RtpServer : public std::enable_shared_from_this<RtpServer> {
 public:
     typedef std::shared_ptr<RtpServer> Ptr;
     typedef function<void(const Buffer::Ptr &buf)> onRecv;
@@ -42,6 +43,14 @@ public:
      */
     void start(uint16_t local_port, const string &stream_id = "", bool enable_tcp = true, const char *local_ip = "0.0.0.0");
 
+    /**
+     * tcp主动模式，连接设备的tcp端口并在该连接上接收rtp，必须在start之后调用
+     * @param url 设备ip或域名
+     * @param port 设备端口
+     * @param cb 连接结果回调，在本对象poller线程触发
+     */
+    void connectToServer(const string &url, uint16_t port, const function<void(const SockException &ex)> &cb);
+
     /**
      * 获取绑定的本地端口
      */
@@ -67,11 +76,29 @@ public:
      */
     void resumeRtpCheck();
 
+private:
+    /**
+     * 单端口模式下，在多个poller线程上创建绑定同一端口的udp socket，并按ssrc分流
+     * @return 创建的socket，失败或无需分片时返回空
+     */
+    static vector<Socket::Ptr> createUdpShards(uint16_t local_port, const char *local_ip);
+
+    /**
+     * tcp主动模式连接成功后创建rtp会话
+     */
+    void onConnect(const Socket::Ptr &sock);
+
 protected:
     Socket::Ptr _udp_server;
+    //单端口分片模式下的所有udp socket(包含_udp_server)
+    vector<Socket::Ptr> _udp_shards;
     TcpServer::Ptr _tcp_server;
     RtpProcess::Ptr _rtp_process;
     function<void()> _on_clearup;
+    string _stream_id;
+    //tcp主动模式下的rtp会话及其定时管理器
+    std::shared_ptr<RtpSession> _tcp_session;
+    Timer::Ptr _tcp_session_timer;
 };
 
 }//namespace mediakit
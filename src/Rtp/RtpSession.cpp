@@ -20,6 +20,10 @@ void RtpSession::attachServer(const TcpServer &server) {
     _stream_id = const_cast<TcpServer &>(server)[kStreamID];
 }
 
+void RtpSession::setStreamID(const string &stream_id) {
+    _stream_id = stream_id;
+}
+
 RtpSession::RtpSession(const Socket::Ptr &sock) : TcpSession(sock) {
     DebugP(this);
     socklen_t addr_len = sizeof(addr);
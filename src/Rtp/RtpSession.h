@@ -29,6 +29,8 @@ public:
     void onError(const SockException &err) override;
     void onManager() override;
     void attachServer(const TcpServer &server) override;
+    //tcp主动模式下由RtpServer设置流id
+    void setStreamID(const string &stream_id);
 
 protected:
     // 通知其停止推流
@@ -11,6 +11,7 @@
 #if defined(ENABLE_RTPPROXY)
 #include <string.h>
 #include "RtpSplitter.h"
+#include "Common/config.h"
 namespace mediakit{
 
 static const char kEHOME_MAGIC[] = "\x01\x00\x01\x00";
@@ -19,21 +20,6 @@ static const int  kEHOME_OFFSET = 256;
 RtpSplitter::RtpSplitter() {}
 RtpSplitter::~RtpSplitter() {}
 
-ssize_t RtpSplitter::onRecvHeader(const char *data,size_t len){
-    //忽略偏移量
-    data += _offset;
-    len -= _offset;
-
-    if (_is_ehome && len > 12 && data[12] == '\r') {
-        //这是ehome,移除第12个字节
-        memmove((char *) data + 1, data, 12);
-        data += 1;
-        len -= 1;
-    }
-    onRtpPacket(data, len);
-    return 0;
-}
-
 static bool isEhome(const char *data, size_t len){
     if (len < 4) {
         return false;
@@ -41,44 +27,85 @@ static bool isEhome(const char *data, size_t len){
     return memcmp(data, kEHOME_MAGIC, sizeof(kEHOME_MAGIC) - 1) == 0;
 }
 
-const char *RtpSplitter::onSearchPacketTail(const char *data, size_t len) {
+static size_t getRtpLength(const char *data) {
+    return (((uint8_t *) data)[0] << 8) | ((uint8_t *) data)[1];
+}
+
+size_t RtpSplitter::getPacketSize(const char *data, size_t len, size_t &offset) {
     if (len < 4) {
         //数据不够
-        return nullptr;
+        return 4;
     }
 
     if (isEhome(data, len)) {
         //是ehome协议
         if (len < kEHOME_OFFSET + 4) {
             //数据不够
-            return nullptr;
+            return kEHOME_OFFSET + 4;
         }
-        //忽略ehome私有头后是rtsp样式的rtp，多4个字节，
-        _offset = kEHOME_OFFSET + 4;
+        //忽略ehome私有头后是rtsp样式的rtp，多4个字节
         _is_ehome = true;
-        //忽略ehome私有头
-        return onSearchPacketTail_l(data + kEHOME_OFFSET + 2, len - kEHOME_OFFSET - 2);
+        offset = kEHOME_OFFSET + 4;
+        return offset + getRtpLength(data + kEHOME_OFFSET + 2);
     }
 
     if (data[0] == '$') {
         //可能是4个字节的rtp头
-        _offset = 4;
-        return onSearchPacketTail_l(data + 2, len - 2);
+        offset = 4;
+        return offset + getRtpLength(data + 2);
     }
     //两个字节的rtp头
-    _offset = 2;
-    return onSearchPacketTail_l(data, len);
+    offset = 2;
+    return offset + getRtpLength(data);
 }
 
-const char *RtpSplitter::onSearchPacketTail_l(const char *data, size_t len) {
-    //这是rtp包
-    uint16_t length = (((uint8_t *) data)[0] << 8) | ((uint8_t *) data)[1];
-    if (len < (size_t)(length + 2)) {
-        //数据不够
-        return nullptr;
+void RtpSplitter::onPacket(const char *data, size_t len) {
+    if (_is_ehome && len > 12 && data[12] == '\r') {
+        //这是ehome,移除第12个字节
+        memmove((char *) data + 1, data, 12);
+        data += 1;
+        len -= 1;
+    }
+    onRtpPacket(data, len);
+}
+
+void RtpSplitter::input(const char *data, size_t len) {
+    size_t offset = 0;
+    while (!_pending.empty()) {
+        //先补齐上次未收全的rtp包，每次只拷贝所需的字节
+        auto size = getPacketSize(_pending.data(), _pending.size(), offset);
+        if (size > _pending.size()) {
+            if (!len) {
+                //数据还是不够
+                return;
+            }
+            auto bytes = MIN(size - _pending.size(), len);
+            _pending.append(data, bytes);
+            data += bytes;
+            len -= bytes;
+            continue;
+        }
+        //rtp包已经完整，回调后清空缓存(保留内存)
+        onPacket(&_pending[offset], size - offset);
+        _pending.clear();
     }
-    //返回rtp包末尾
-    return data + 2 + length;
+
+    //剩余数据就地拆包，无需拷贝
+    while (len) {
+        auto size = getPacketSize(data, len, offset);
+        if (size > len) {
+            //不完整的rtp包，缓存起来等待后续数据
+            _pending.assign(data, len);
+            return;
+        }
+        onPacket(data + offset, size - offset);
+        data += size;
+        len -= size;
+    }
+}
+
+size_t RtpSplitter::remainDataSize() const {
+    return _pending.size();
 }
 
 }//namespace mediakit
@@ -12,14 +12,32 @@
 #define ZLMEDIAKIT_RTPSPLITTER_H
 
 #if defined(ENABLE_RTPPROXY)
-#include "Http/HttpRequestSplitter.h"
+#include <string>
+#include <stdint.h>
+#include <sys/types.h>
 
 namespace mediakit{
 
-class RtpSplitter : public HttpRequestSplitter{
+/**
+ * tcp方式rtp拆包器，支持2字节长度头、rtsp样式4字节头以及ehome私有头
+ * 完整的rtp包直接在输入数据上就地拆分回调，只有跨越两次读取边界的rtp包才会拷贝重组
+ */
+class RtpSplitter {
 public:
     RtpSplitter();
-    ~RtpSplitter() override;
+    virtual ~RtpSplitter();
+
+    /**
+     * 输入tcp流数据
+     * @param data 数据指针，ehome模式下会就地修改数据
+     * @param len 数据长度
+     */
+    void input(const char *data, size_t len);
+
+    /**
+     * 暂存的不完整rtp包大小
+     */
+    size_t remainDataSize() const;
 
 protected:
     /**
@@ -29,14 +47,19 @@ protected:
      */
     virtual void onRtpPacket(const char *data, size_t len) = 0;
 
-protected:
-    ssize_t onRecvHeader(const char *data, size_t len) override;
-    const char *onSearchPacketTail(const char *data, size_t len) override;
-    const char *onSearchPacketTail_l(const char *data, size_t len);
+private:
+    /**
+     * 获取第一个rtp包(包含包头)的总长度
+     * @param offset 包头长度
+     * @return 总长度，数据不够解析包头时返回解析包头所需最少字节数
+     */
+    size_t getPacketSize(const char *data, size_t len, size_t &offset);
+    void onPacket(const char *data, size_t len);
 
 private:
     bool _is_ehome = false;
-    size_t _offset = 0;
+    //跨越读取边界的不完整rtp包，只拷贝补齐本rtp包所需的字节，内存复用
+    std::string _pending;
 };
 
 }//namespace mediakit
@@ -0,0 +1,159 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <vector>
+#include "RtpNack.h"
+#include "Util/logger.h"
+#include "Network/sockutil.h"
+
+using namespace toolkit;
+
+//seq跳变超过该值认为是推流端重置，不请求重传
+#define NACK_MAX_GAP 512
+//检查间隔，避免每个rtp包都遍历丢包列表
+#define NACK_CHECK_MS 10
+//乱序窗口，发现丢包后等待该时长仍未收到才请求重传，避免普通的乱序也触发nack
+#define NACK_REORDER_MS 20
+//单个rtcp nack包最多携带的fci个数
+#define NACK_MAX_FCI 64
+
+namespace mediakit {
+
+static atomic<uint64_t> s_missing{0};
+static atomic<uint64_t> s_recovered{0};
+static atomic<uint64_t> s_lost{0};
+static atomic<uint64_t> s_nack_packets{0};
+static atomic<uint64_t> s_nack_seqs{0};
+
+void RtpNackContext::clear() {
+    _started = false;
+    _max_seq = 0;
+    _last_check_ms = 0;
+    _missing.clear();
+}
+
+void RtpNackContext::inputRtp(uint16_t seq, uint64_t now_ms) {
+    if (!_started) {
+        _started = true;
+        _max_seq = seq;
+        return;
+    }
+
+    auto diff = (int16_t) (seq - _max_seq);
+    if (diff <= 0) {
+        //乱序包或重传包
+        auto it = _missing.find(seq);
+        if (it != _missing.end()) {
+            _missing.erase(it);
+            ++s_recovered;
+        }
+        return;
+    }
+
+    if (diff > NACK_MAX_GAP) {
+        //seq跳变太大，可能是推流端重置了
+        WarnL << "rtp seq跳变:" << _max_seq << " -> " << seq;
+        s_lost += _missing.size();
+        _missing.clear();
+        _max_seq = seq;
+        return;
+    }
+
+    for (uint16_t i = _max_seq + 1; i != seq; ++i) {
+        //记录丢失的包，超过乱序窗口后请求重传
+        _missing.emplace(i, Missing{now_ms, 0});
+        ++s_missing;
+    }
+    _max_seq = seq;
+}
+
+bool RtpNackContext::isWaiting(uint16_t seq) const {
+    return _missing.find(seq) != _missing.end();
+}
+
+string RtpNackContext::makeNack(uint64_t now_ms, uint32_t max_ms, uint32_t ssrc) {
+    if (_missing.empty() || now_ms - _last_check_ms < NACK_CHECK_MS) {
+        return "";
+    }
+    _last_check_ms = now_ms;
+
+    //在最大等待时间内大约请求4次
+    auto interval = max_ms / 4 > NACK_CHECK_MS ? max_ms / 4 : NACK_CHECK_MS;
+    vector<uint16_t> seqs;
+    for (auto it = _missing.begin(); it != _missing.end();) {
+        auto &missing = it->second;
+        auto elapsed = now_ms > missing.first_ms ? now_ms - missing.first_ms : 0;
+        if (elapsed >= max_ms) {
+            //等待重传超时，放弃该包
+            it = _missing.erase(it);
+            ++s_lost;
+            continue;
+        }
+        if (elapsed < NACK_REORDER_MS) {
+            //可能只是乱序，暂不请求重传
+            ++it;
+            continue;
+        }
+        if (!missing.nack_ms || now_ms - missing.nack_ms >= interval) {
+            missing.nack_ms = now_ms;
+            seqs.emplace_back(it->first);
+        }
+        ++it;
+    }
+    if (seqs.empty()) {
+        return "";
+    }
+
+    //fci: 16位pid + 16位blp，blp第i位代表pid + i + 1丢失
+    vector<uint32_t> fcis;
+    for (size_t i = 0; i < seqs.size() && fcis.size() < NACK_MAX_FCI;) {
+        uint16_t pid = seqs[i++];
+        uint16_t blp = 0;
+        while (i < seqs.size() && (uint16_t) (seqs[i] - pid) <= 16) {
+            blp |= 1 << ((uint16_t) (seqs[i] - pid) - 1);
+            ++i;
+        }
+        fcis.emplace_back(htonl((pid << 16) | blp));
+    }
+
+    string rtcp(12 + 4 * fcis.size(), '\0');
+    auto ptr = (uint8_t *) rtcp.data();
+    //V=2, P=0, FMT=1(generic nack)
+    ptr[0] = 0x81;
+    //PT=205(RTPFB)
+    ptr[1] = 205;
+    //长度(以4字节为单位，减1)
+    auto length = rtcp.size() / 4 - 1;
+    ptr[2] = (length >> 8) & 0xFF;
+    ptr[3] = length & 0xFF;
+    //与接收者报告一致，我们使用媒体源ssrc + 1作为自己的ssrc
+    uint32_t sender_ssrc = htonl(ssrc + 1);
+    uint32_t media_ssrc = htonl(ssrc);
+    memcpy(ptr + 4, &sender_ssrc, 4);
+    memcpy(ptr + 8, &media_ssrc, 4);
+    memcpy(ptr + 12, fcis.data(), 4 * fcis.size());
+
+    ++s_nack_packets;
+    s_nack_seqs += seqs.size();
+    return rtcp;
+}
+
+RtpNackStatistic RtpNackContext::getStatistic() {
+    RtpNackStatistic ret;
+    ret.missing = s_missing;
+    ret.recovered = s_recovered;
+    ret.lost = s_lost;
+    ret.nack_packets = s_nack_packets;
+    ret.nack_seqs = s_nack_seqs;
+    return ret;
+}
+
+}//namespace mediakit
@@ -0,0 +1,95 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_RTPNACK_H
+#define ZLMEDIAKIT_RTPNACK_H
+
+#include <map>
+#include <string>
+#include <stdint.h>
+using namespace std;
+
+namespace mediakit {
+
+/**
+ * 丢包重传统计信息(全局)
+ */
+class RtpNackStatistic {
+public:
+    //检测到丢失的rtp包个数
+    uint64_t missing = 0;
+    //通过重传恢复的rtp包个数
+    uint64_t recovered = 0;
+    //等待重传超时，最终丢弃的rtp包个数
+    uint64_t lost = 0;
+    //发送的rtcp nack包个数
+    uint64_t nack_packets = 0;
+    //请求重传的seq个数(包含重复请求)
+    uint64_t nack_seqs = 0;
+};
+
+/**
+ * 接收端丢包检测与重传请求(RFC 4585 generic nack)
+ * 根据seq跳变记录丢失的包，按一定间隔重复请求重传，超过最大等待时间后放弃
+ */
+class RtpNackContext {
+public:
+    RtpNackContext() = default;
+    ~RtpNackContext() = default;
+
+    /**
+     * 清空状态
+     */
+    void clear();
+
+    /**
+     * 收到rtp包(排序前)
+     * @param seq rtp序列号
+     * @param now_ms 当前时间戳，单位毫秒
+     */
+    void inputRtp(uint16_t seq, uint64_t now_ms);
+
+    /**
+     * 是否正在等待该包的重传
+     */
+    bool isWaiting(uint16_t seq) const;
+
+    /**
+     * 生成rtcp nack包，并淘汰等待超时的丢包
+     * @param now_ms 当前时间戳，单位毫秒
+     * @param max_ms 等待重传的最长时间，单位毫秒
+     * @param ssrc 媒体源ssrc
+     * @return rtcp nack包，为空时无需发送
+     */
+    string makeNack(uint64_t now_ms, uint32_t max_ms, uint32_t ssrc);
+
+    /**
+     * 获取全局统计信息
+     */
+    static RtpNackStatistic getStatistic();
+
+private:
+    class Missing {
+    public:
+        //发现丢包的时间
+        uint64_t first_ms;
+        //最近一次请求重传的时间
+        uint64_t nack_ms;
+    };
+
+    bool _started = false;
+    //收到的最大seq
+    uint16_t _max_seq = 0;
+    uint64_t _last_check_ms = 0;
+    map<uint16_t, Missing> _missing;
+};
+
+}//namespace mediakit
+#endif //ZLMEDIAKIT_RTPNACK_H
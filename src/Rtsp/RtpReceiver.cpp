@@ -92,6 +92,7 @@ bool RtpReceiver::handleOneRtp(int track_index, TrackType type, int samplerate,
                 //ssrc切换后清除老数据
                 WarnL << "ssrc更换:" << _ssrc[track_index] << " -> " << rtp.ssrc;
                 _rtp_sortor[track_index].clear();
+                _nack[track_index].clear();
                 _ssrc[track_index] = rtp.ssrc;
             }
             return false;
@@ -136,16 +137,47 @@ bool RtpReceiver::handleOneRtp(int track_index, TrackType type, int samplerate,
     memcpy(payload_ptr + 4, rtp_raw_ptr, rtp_raw_len);
     //排序rtp
     auto seq = rtp_ptr->sequence;
-    _rtp_sortor[track_index].sortPacket(seq, std::move(rtp_ptr));
+    auto ssrc = rtp_ptr->ssrc;
+    GET_CONFIG(uint32_t, nack_max_ms, Rtp::kNackMaxMS);
+    bool nack = _enable_nack && nack_max_ms;
+    auto &sortor = _rtp_sortor[track_index];
+    if (nack) {
+        _nack[track_index].inputRtp(seq, getCurrentMillisecond());
+    }
+    sortor.setWaitLost(nack);
+    sortor.sortPacket(seq, std::move(rtp_ptr));
+    if (nack) {
+        handleNack(track_index, ssrc, nack_max_ms);
+    }
     return true;
 }
 
+void RtpReceiver::handleNack(int track_index, uint32_t ssrc, uint32_t nack_max_ms) {
+    auto &nack = _nack[track_index];
+    auto rtcp = nack.makeNack(getCurrentMillisecond(), nack_max_ms, ssrc);
+    if (!rtcp.empty()) {
+        onSendNack(track_index, std::move(rtcp));
+    }
+    //已经放弃重传的包不再阻塞排序
+    auto &sortor = _rtp_sortor[track_index];
+    while (sortor.isBlocked() && !nack.isWaiting(sortor.getNextSeq())) {
+        sortor.skipLost();
+    }
+}
+
+void RtpReceiver::enableNack(bool enable) {
+    _enable_nack = enable;
+}
+
 void RtpReceiver::clear() {
     CLEAR_ARR(_ssrc);
     CLEAR_ARR(_ssrc_err_count);
     for (auto &sortor : _rtp_sortor) {
         sortor.clear();
     }
+    for (auto &nack : _nack) {
+        nack.clear();
+    }
 }
 
 void RtpReceiver::setPoolSize(size_t size) {
@@ -16,6 +16,7 @@
 #include <memory>
 #include "RtpCodec.h"
 #include "RtspMediaSource.h"
+#include "RtpNack.h"
 using namespace std;
 using namespace toolkit;
 
@@ -84,6 +85,43 @@ public:
         }
     }
 
+    /**
+     * 设置是否等待丢失的包(等待重传)，等待时排序缓存最多缓存kMax个包
+     */
+    void setWaitLost(bool wait_lost) {
+        _wait_lost = wait_lost;
+    }
+
+    /**
+     * 下个应该输出的包是否缺失
+     */
+    bool isBlocked() const {
+        return !_rtp_sort_cache_map.empty() && _rtp_sort_cache_map.find(_next_seq_out) == _rtp_sort_cache_map.end();
+    }
+
+    /**
+     * 获取下个应该输出的序列号
+     */
+    SEQ getNextSeq() const {
+        return _next_seq_out;
+    }
+
+    /**
+     * 放弃等待缺失的包，输出后续的包
+     */
+    void skipLost() {
+        if (!isBlocked()) {
+            return;
+        }
+        //跳至下一个已收到的包，考虑seq回环
+        auto it = _rtp_sort_cache_map.lower_bound(_next_seq_out);
+        if (it == _rtp_sort_cache_map.end()) {
+            it = _rtp_sort_cache_map.begin();
+        }
+        popIterator(it);
+        tryPopPacket();
+    }
+
 private:
     void popPacket() {
         auto it = _rtp_sort_cache_map.begin();
@@ -99,7 +137,6 @@ private:
                 //等足够多的数据后才处理回环, 因为后面还可能出现大的SEQ
                 return;
             }
-            ++_seq_cycle_count;
             //找到大的SEQ并清空掉，然后从小的SEQ重新开始排序
             auto hit = _rtp_sort_cache_map.upper_bound((SEQ) (_next_seq_out - _rtp_sort_cache_map.size()));
             while (hit != _rtp_sort_cache_map.end()) {
@@ -119,21 +156,29 @@ private:
         auto seq = it->first;
         auto data = std::move(it->second);
         _rtp_sort_cache_map.erase(it);
+        if ((SEQ) (seq + 1) < _next_seq_out) {
+            //seq回环了
+            ++_seq_cycle_count;
+        }
         _next_seq_out = seq + 1;
         _cb(seq, data);
     }
 
     void tryPopPacket() {
         int count = 0;
-        while ((!_rtp_sort_cache_map.empty() && _rtp_sort_cache_map.begin()->first == _next_seq_out)) {
-            //找到下个包，直接输出
-            popPacket();
+        while (!_rtp_sort_cache_map.empty()) {
+            //找到下个包，直接输出(seq回环时下个包不一定在头部)
+            auto it = _rtp_sort_cache_map.find(_next_seq_out);
+            if (it == _rtp_sort_cache_map.end()) {
+                break;
+            }
+            popIterator(it);
             ++count;
         }
 
         if (count) {
             setSortSize();
-        } else if (_rtp_sort_cache_map.size() > _max_sort_size) {
+        } else if (_rtp_sort_cache_map.size() > (_wait_lost ? kMax : _max_sort_size)) {
             //排序缓存溢出，不再继续排序
             popPacket();
             setSortSize();
@@ -154,6 +199,8 @@ private:
     size_t _seq_cycle_count = 0;
     //排序缓存长度
     size_t _max_sort_size = kMin;
+    //是否等待丢失的包重传
+    bool _wait_lost = false;
     //rtp排序缓存，根据seq排序
     map<SEQ, T> _rtp_sort_cache_map;
     //回调
@@ -184,18 +231,37 @@ protected:
      */
     virtual void onRtpSorted(const RtpPacket::Ptr &rtp, int track_index) {}
 
+    /**
+     * 丢包后需要发送rtcp nack请求重传
+     * @param track_index track索引
+     * @param rtcp rtcp nack包，不包含rtp over tcp的4个字节头
+     */
+    virtual void onSendNack(int track_index, string rtcp) {}
+
+    /**
+     * 开启或关闭丢包重传请求，只在udp方式接收时开启，
+     * 开启后还需要配置rtp.nackMaxMS才会生效
+     */
+    void enableNack(bool enable);
+
     void clear();
     void setPoolSize(size_t size);
     size_t getJitterSize(int track_index) const;
     size_t getCycleCount(int track_index) const;
     uint32_t getSSRC(int track_index) const;
 
+private:
+    void handleNack(int track_index, uint32_t ssrc, uint32_t nack_max_ms);
+
 private:
     uint32_t _ssrc[2] = {0, 0};
     //ssrc不匹配计数
     size_t _ssrc_err_count[2] = {0, 0};
     //rtp排序缓存，根据seq排序
     PacketSortor<RtpPacket::Ptr> _rtp_sortor[2];
+    //丢包重传请求
+    bool _enable_nack = false;
+    RtpNackContext _nack[2];
     //rtp循环池
     RtspMediaSource::PoolType _rtp_pool;
 };
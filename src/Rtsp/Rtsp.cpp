@@ -9,8 +9,10 @@
  */
 
 #include <stdlib.h>
+#include <atomic>
 #include "Rtsp.h"
 #include "Common/Parser.h"
+#include "Common/config.h"
 
 namespace mediakit{
 
@@ -389,19 +391,47 @@ static void makeSockPair_l(std::pair<Socket::Ptr, Socket::Ptr> &pair, const stri
     }
 }
 
- void makeSockPair(std::pair<Socket::Ptr, Socket::Ptr> &pair, const string &local_ip){
-     int try_count = 0;
-     while (true) {
-         try {
-             makeSockPair_l(pair, local_ip);
-             break;
-         } catch (...) {
-             if (++try_count == 3) {
-                 throw;
-             }
-             WarnL << "open udp socket failed, retry: " << try_count;
-         }
-     }
+//在端口范围内分配rtp/rtcp端口对，rtp端口为偶数，rtcp端口为rtp端口+1
+static bool makeSockPairFromRange(std::pair<Socket::Ptr, Socket::Ptr> &pair, const string &local_ip, uint16_t min_port, uint16_t max_port) {
+    //多个线程通过原子计数器轮流分配，无需加锁
+    static atomic<uint32_t> s_pair_index(0);
+    min_port += min_port % 2;
+    uint32_t pair_count = (max_port + 1 - min_port) / 2;
+    //端口被占用时尝试下一个端口对，最多尝试一轮
+    for (uint32_t i = 0; i < pair_count; ++i) {
+        uint16_t port = min_port + 2 * (s_pair_index++ % pair_count);
+        if (!pair.first->bindUdpSock(port, local_ip.data())) {
+            continue;
+        }
+        if (pair.second->bindUdpSock(port + 1, local_ip.data())) {
+            return true;
+        }
+    }
+    pair.first->closeSock();
+    return false;
+}
+
+void makeSockPair(std::pair<Socket::Ptr, Socket::Ptr> &pair, const string &local_ip){
+    GET_CONFIG(string, port_range, Rtp::kPortRange);
+    unsigned int min_port = 0, max_port = 0;
+    if (2 == sscanf(port_range.data(), "%u-%u", &min_port, &max_port) && min_port + 1 < max_port && max_port <= 0xFFFF) {
+        if (!makeSockPairFromRange(pair, local_ip, min_port, max_port)) {
+            throw runtime_error(StrPrinter << "no available udp port pair in range:" << port_range);
+        }
+        return;
+    }
+    int try_count = 0;
+    while (true) {
+        try {
+            makeSockPair_l(pair, local_ip);
+            break;
+        } catch (...) {
+            if (++try_count == 3) {
+                throw;
+            }
+            WarnL << "open udp socket failed, retry: " << try_count;
+        }
+    }
 }
 
 string printSSRC(uint32_t ui32Ssrc) {
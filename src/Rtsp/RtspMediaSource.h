@@ -79,6 +79,18 @@ public:
         return _sdp;
     }
 
+    /**
+     * 获取sdp中可用的track，sdp在设置时已经解析好，这里返回其拷贝，播放器可以自由修改
+     */
+    vector<SdpTrack::Ptr> getAvailableTrack() const {
+        vector<SdpTrack::Ptr> ret;
+        ret.reserve(_available_tracks.size());
+        for (auto &track : _available_tracks) {
+            ret.emplace_back(std::make_shared<SdpTrack>(*track));
+        }
+        return ret;
+    }
+
     /**
      * 获取相应轨道的ssrc
      */
@@ -146,6 +158,8 @@ public:
         _tracks[TrackVideo] = sdp_parser.getTrack(TrackVideo);
         _tracks[TrackAudio] = sdp_parser.getTrack(TrackAudio);
         _have_video = (bool) _tracks[TrackVideo];
+        //缓存解析结果，大量播放器同时连接时无需每个都重新解析sdp
+        _available_tracks = sdp_parser.getAvailableTrack();
         if (_ring) {
             regist();
         }
@@ -209,6 +223,7 @@ private:
     string _sdp;
     RingType::Ptr _ring;
     SdpTrack::Ptr _tracks[TrackMax];
+    vector<SdpTrack::Ptr> _available_tracks;
 };
 
 } /* namespace mediakit */
@@ -270,6 +270,8 @@ void RtspPlayer::handleResSETUP(const Parser &parser, unsigned int track_idx) {
     }
     auto transport_map = Parser::parseArgs(strTransport, ";", "=");
     RtspSplitter::enableRecvRtp(_rtp_type == Rtsp::RTP_TCP);
+    //只有udp单播才可能丢包并请求重传
+    RtpReceiver::enableNack(_rtp_type == Rtsp::RTP_UDP);
     string ssrc = transport_map["ssrc"];
     if(!ssrc.empty()){
         sscanf(ssrc.data(), "%x", &_sdp_track[track_idx]->_ssrc);
@@ -613,6 +615,12 @@ void RtspPlayer::sendReceiverReport(bool over_tcp, int track_idx){
     }
 }
 
+void RtspPlayer::onSendNack(int track_idx, string rtcp) {
+    if (_rtp_type == Rtsp::RTP_UDP && _rtcp_sock[track_idx]) {
+        _rtcp_sock[track_idx]->send(std::move(rtcp));
+    }
+}
+
 void RtspPlayer::onRtpSorted(const RtpPacket::Ptr &rtppt, int trackidx){
     //统计丢包率
     if (_rtp_seq_start[trackidx] == 0 || rtppt->sequence < _rtp_seq_start[trackidx]) {
@@ -71,6 +71,11 @@ protected:
      */
     void onRtpSorted(const RtpPacket::Ptr &rtp, int track_idx) override;
 
+    /**
+     * udp方式接收时，丢包后发送rtcp nack请求重传
+     */
+    void onSendNack(int track_idx, string rtcp) override;
+
     /**
      * 收到RTCP包回调
      * @param track_idx track索引
@@ -11,6 +11,7 @@
 #include <atomic>
 #include <iomanip>
 #include "Common/config.h"
+#include "Common/StreamAffinity.h"
 #include "UDPServer.h"
 #include "RtspSession.h"
 #include "Util/mini.h"
@@ -20,6 +21,8 @@
 #include "Util/TimeTicker.h"
 #include "Util/NoticeCenter.h"
 #include "Network/sockutil.h"
+#include "Extension/H264.h"
+#include "Extension/H265.h"
 
 #define RTSP_SERVER_SEND_RTCP 0
 
@@ -364,15 +367,28 @@ void RtspSession::handleReq_Describe(const Parser &parser) {
         });
     };
 
-    if(_rtsp_realm.empty()){
-        //广播是否需要rtsp专属认证事件
-        if (!NoticeCenter::Instance().emitEvent(Broadcast::kBroadcastOnGetRtspRealm, _media_info, invoker, static_cast<SockInfo &>(*this))) {
-            //无人监听此事件，说明无需认证
-            invoker("");
+    auto describe = [weakSelf, invoker]() {
+        auto strongSelf = weakSelf.lock();
+        if (!strongSelf) {
+            //本对象已经销毁
+            return;
         }
-    }else{
-        invoker(_rtsp_realm);
+        if (strongSelf->_rtsp_realm.empty()) {
+            //广播是否需要rtsp专属认证事件
+            if (!NoticeCenter::Instance().emitEvent(Broadcast::kBroadcastOnGetRtspRealm, strongSelf->_media_info, invoker, static_cast<SockInfo &>(*strongSelf))) {
+                //无人监听此事件，说明无需认证
+                invoker("");
+            }
+        } else {
+            invoker(strongSelf->_rtsp_realm);
+        }
+    };
+
+    //迁移到该流所属的poller线程后再继续处理播放请求，rtsp over http的get/post连接相互关联，不迁移
+    if (_http_x_sessioncookie.empty() && StreamAffinity::moveSession(*this, _media_info, describe)) {
+        return;
     }
+    describe();
 }
 
 void RtspSession::onAuthSuccess() {
@@ -392,7 +408,7 @@ void RtspSession::onAuthSuccess() {
             return;
         }
         //找到了相应的rtsp流
-        strongSelf->_sdp_track = SdpParser(rtsp_src->getSdp()).getAvailableTrack();
+        strongSelf->_sdp_track = rtsp_src->getAvailableTrack();
         if (strongSelf->_sdp_track.empty()) {
             //该流无效
             DebugL << "无trackInfo，该流无效";
@@ -668,6 +684,8 @@ void RtspSession::handleReq_Setup(const Parser &parser) {
 
         _rtp_socks[trackIdx] = pr.first;
         _rtcp_socks[trackIdx] = pr.second;
+        //udp推流时丢包可以请求重传
+        RtpReceiver::enableNack(true);
 
         //设置客户端内网端口信息
         string strClientPort = FindField(parser["Transport"].data(), "client_port=", NULL);
@@ -782,6 +800,10 @@ void RtspSession::handleReq_Play(const Parser &parser) {
             shutdown(SockException(Err_shutdown, "track not setuped"));
             return;
         }
+        if (track->_type == TrackVideo) {
+            _video_codec = strcasecmp(track->_codec.data(), "H264") == 0 ? CodecH264 :
+                           strcasecmp(track->_codec.data(), "H265") == 0 ? CodecH265 : CodecInvalid;
+        }
         track->_ssrc = play_src->getSsrc(track->_type);
         track->_seq = play_src->getSeqence(track->_type);
         track->_time_stamp = play_src->getTimeStamp(track->_type);
@@ -810,14 +832,23 @@ void RtspSession::handleReq_Play(const Parser &parser) {
             }
             strongSelf->shutdown(SockException(Err_shutdown, "rtsp ring buffer detached"));
         });
-        _play_reader->setReadCB([weakSelf](const RtspMediaSource::RingDataType &pack) {
+        _play_reader->setReadCBWithKey([weakSelf](const RtspMediaSource::RingDataType &pack, bool is_key) {
             auto strongSelf = weakSelf.lock();
             if (!strongSelf) {
                 return;
             }
-            if (strongSelf->_enable_send_rtp) {
-                strongSelf->sendRtpPacket(pack);
+            if (!strongSelf->_enable_send_rtp) {
+                return;
+            }
+            //只有rtp over tcp才存在发送缓存积压
+            if (strongSelf->_rtp_type == Rtsp::RTP_TCP && !strongSelf->inputGroup(strongSelf->getSock(), is_key)) {
+                //积压严重，丢弃整组数据，直到直播流的下一个关键帧
+                pack->for_each([&](const RtpPacket::Ptr &rtp) {
+                    strongSelf->dropRtpPacket(rtp);
+                });
+                return;
             }
+            strongSelf->sendRtpPacket(pack);
         });
     }
 }
@@ -903,6 +934,12 @@ inline void RtspSession::send_NotAcceptable() {
     sendRtspResponse("406 Not Acceptable",{"Connection","Close"});
 }
 
+void RtspSession::onSendNack(int track_idx, string rtcp) {
+    if (_rtp_type == Rtsp::RTP_UDP && _rtcp_socks[track_idx]) {
+        _rtcp_socks[track_idx]->send(std::move(rtcp));
+    }
+}
+
 void RtspSession::onRtpSorted(const RtpPacket::Ptr &rtp, int track_idx) {
     if (_start_stamp[track_idx] == -1) {
         //记录起始时间戳
@@ -1131,19 +1168,82 @@ inline void RtspSession::onSendRtpPacket(const RtpPacket::Ptr &pkt){
 #endif
 }
 
+//判断rtp包是否为非参考帧的第一个包，只判断slice，sei、参数集等不会被丢弃
+static bool isNonReferenceRtp(const RtpPacket::Ptr &rtp, CodecId codec) {
+    if (rtp->type != TrackVideo || rtp->size() < rtp->offset + 3) {
+        return false;
+    }
+    auto payload = (uint8_t *) rtp->data() + rtp->offset;
+    switch (codec) {
+        case CodecH264: {
+            auto type = H264_TYPE(payload[0]);
+            if (type == 28) {
+                //fu-a分片，nri在fu indicator中，nal类型在fu header中
+                type = H264_TYPE(payload[1]);
+            }
+            //非idr的slice且nal_ref_idc为0(stap-a等聚合包不丢弃)
+            return type >= H264Frame::NAL_B_P && type < H264Frame::NAL_IDR && (payload[0] & 0x60) == 0;
+        }
+        case CodecH265: {
+            auto type = H265_TYPE(payload[0]);
+            if (type == 49) {
+                //fu分片
+                type = payload[2] & 0x3f;
+            }
+            //TRAIL_N、TSA_N、STSA_N、RADL_N、RASL_N等子层非参考帧
+            return type <= 14 && type % 2 == 0;
+        }
+        default: return false;
+    }
+}
+
+void RtspSession::dropRtpPacket(const RtpPacket::Ptr &rtp) {
+    if (rtp->type < 0 || rtp->type >= TrackMax) {
+        return;
+    }
+    ++_seq_offset[rtp->type];
+    if (rtp->type == TrackVideo) {
+        //mark位标记一帧的最后一个包
+        _video_frame_start = rtp->mark;
+    }
+}
+
+void RtspSession::sendRtpPacketOverTcp(const RtpPacket::Ptr &rtp) {
+    if (rtp->type < 0 || rtp->type >= TrackMax || !_seq_offset[rtp->type] || rtp->size() < 4 + 12) {
+        send(rtp);
+        return;
+    }
+    //rtp包在所有播放器间共享，不能修改；只拷贝rtp over tcp的4个字节头和12个字节rtp头并修正seq，负载直接引用原rtp包
+    auto header = std::make_shared<BufferRaw>(4 + 12);
+    header->assign(rtp->data(), 4 + 12);
+    auto seq = htons((uint16_t) (rtp->sequence - _seq_offset[rtp->type]));
+    //seq位于rtp头第2~3字节
+    memcpy(header->data() + 4 + 2, &seq, 2);
+    send(std::move(header));
+    send(std::make_shared<BufferPartial>(rtp, 4 + 12, rtp->size() - 4 - 12));
+}
 void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
     switch (_rtp_type) {
         case Rtsp::RTP_TCP: {
-            size_t i = 0;
-            auto size = pkt->size();
             setSendFlushFlag(false);
             pkt->for_each([&](const RtpPacket::Ptr &rtp) {
-                onSendRtpPacket(rtp);
-                if (++i == size) {
-                    setSendFlushFlag(true);
+                if (rtp->type == TrackVideo) {
+                    if (_video_frame_start) {
+                        //拥塞时按整帧丢弃，在帧的第一个包时决定是否丢弃该帧
+                        _video_frame_drop = dropFrame([&]() { return isNonReferenceRtp(rtp, _video_codec); });
+                    }
+                    if (_video_frame_drop) {
+                        dropRtpPacket(rtp);
+                        return;
+                    }
+                    _video_frame_start = rtp->mark;
                 }
-                send(rtp);
+                onSendRtpPacket(rtp);
+                sendRtpPacketOverTcp(rtp);
             });
+            //最后一个rtp包可能被丢弃，所以在整组数据发送完毕后再flush
+            setSendFlushFlag(true);
+            getSock()->flushAll();
         }
             break;
         case Rtsp::RTP_UDP: {
@@ -26,6 +26,7 @@
 #include "RtpReceiver.h"
 #include "RtspMediaSourceImp.h"
 #include "Common/Stamp.h"
+#include "Common/SendQueuePolicy.h"
 
 using namespace std;
 using namespace toolkit;
@@ -53,7 +54,7 @@ private:
     Buffer::Ptr _rtp;
 };
 
-class RtspSession: public TcpSession, public RtspSplitter, public RtpReceiver , public MediaSourceEvent{
+class RtspSession: public TcpSession, public RtspSplitter, public RtpReceiver , public MediaSourceEvent, public SendQueuePolicy{
 public:
     typedef std::shared_ptr<RtspSession> Ptr;
     typedef std::function<void(const string &realm)> onGetRealm;
@@ -79,6 +80,7 @@ protected:
 
     ////RtpReceiver override////
     void onRtpSorted(const RtpPacket::Ptr &rtp, int track_idx) override;
+    void onSendNack(int track_idx, string rtcp) override;
 
     ///////MediaSourceEvent override///////
     // 关闭
@@ -153,6 +155,10 @@ private:
     void sendRtpPacket(const RtspMediaSource::RingDataType &pkt);
     //触发rtcp发送
     void onSendRtpPacket(const RtpPacket::Ptr &rtp);
+    //拥塞时丢弃rtp包，并累加该track后续rtp包seq的修正值
+    void dropRtpPacket(const RtpPacket::Ptr &rtp);
+    //丢包后修正seq再发送，避免播放器把主动丢弃的包当作网络丢包
+    void sendRtpPacketOverTcp(const RtpPacket::Ptr &rtp);
     //回复客户端
     bool sendRtspResponse(const string &res_code, const std::initializer_list<string> &header, const string &sdp = "", const char *protocol = "RTSP/1.0");
     bool sendRtspResponse(const string &res_code, const StrCaseMap &header = StrCaseMap(), const string &sdp = "", const char *protocol = "RTSP/1.0");
@@ -166,6 +172,14 @@ private:
     bool _emit_on_play = false;
     //是否开始发送rtp
     bool _enable_send_rtp;
+    //播放时视频track的编码格式，用于拥塞时判断非参考帧
+    CodecId _video_codec = CodecInvalid;
+    //下一个视频rtp包是否为一帧的开始，拥塞时按整帧丢弃
+    bool _video_frame_start = true;
+    //是否正在丢弃当前视频帧
+    bool _video_frame_drop = false;
+    //各track因拥塞丢弃的rtp包个数，发送时从seq中减去，TrackType为数组下标
+    uint16_t _seq_offset[TrackMax] = {0};
     //推流或拉流客户端采用的rtp传输方式
     Rtsp::eRtpType _rtp_type = Rtsp::RTP_Invalid;
     //收到的seq，回复时一致
@@ -26,8 +26,9 @@ UDPServer::~UDPServer() {
 }
 
 Socket::Ptr UDPServer::getSock(SocketHelper &helper, const char* local_ip, int interleaved, uint16_t local_port) {
+    //避免每次拼接字符串作为key
+    uint64_t key = ((uint64_t) inet_addr(local_ip) << 32) | (uint32_t) interleaved;
     lock_guard<mutex> lck(_mtx_udp_sock);
-    string key = StrPrinter << local_ip << ":" << interleaved << endl;
     auto it = _udp_sock_map.find(key);
     if (it == _udp_sock_map.end()) {
         Socket::Ptr sock = helper.createSocket();
@@ -67,7 +68,7 @@ void UDPServer::stopListenPeer(const char* peer_ip, void* obj) {
     }
 }
 
-void UDPServer::onErr(const string &key, const SockException &err) {
+void UDPServer::onErr(uint64_t key, const SockException &err) {
     WarnL << err.what();
     lock_guard<mutex> lck(_mtx_udp_sock);
     _udp_sock_map.erase(key);
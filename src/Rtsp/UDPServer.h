@@ -37,12 +37,13 @@ public:
 private:
     UDPServer();
     void onRecv(int interleaved, const Buffer::Ptr &buf, struct sockaddr *peer_addr);
-    void onErr(const string &strKey,const SockException &err);
+    void onErr(uint64_t key, const SockException &err);
 
 private:
     mutex _mtx_udp_sock;
     mutex _mtx_on_recv;
-    unordered_map<string, Socket::Ptr> _udp_sock_map;
+    //key为本地ip与interleaved的组合
+    unordered_map<uint64_t, Socket::Ptr> _udp_sock_map;
     unordered_map<string, unordered_map<void *, onRecvData> > _on_recv_map;
 };
 
@@ -0,0 +1,240 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <random>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Rtmp/amf.h"
+
+using namespace std;
+using namespace toolkit;
+
+//obs推流时发送的connect命令
+static string makeConnect() {
+    AMFValue obj(AMF_OBJECT);
+    obj.set("app", "live");
+    obj.set("type", "nonprivate");
+    obj.set("flashVer", "FMLE/3.0 (compatible; FMSc/1.0)");
+    obj.set("swfUrl", "rtmp://127.0.0.1/live");
+    obj.set("tcUrl", "rtmp://127.0.0.1/live");
+    obj.set("fpad", false);
+    obj.set("capabilities", 15.0);
+    obj.set("audioCodecs", 4071.0);
+    obj.set("videoCodecs", 252.0);
+    obj.set("videoFunction", 1.0);
+    obj.set("pageUrl", "rtmp://127.0.0.1/live");
+    obj.set("objectEncoding", 0.0);
+    AMFEncoder enc;
+    enc << "connect" << 1.0 << obj;
+    return enc.data();
+}
+
+static string makeMetadata() {
+    AMFValue obj(AMF_ECMA_ARRAY);
+    obj.set("duration", 0.0);
+    obj.set("width", 1920.0);
+    obj.set("height", 1080.0);
+    obj.set("videocodecid", 7.0);
+    obj.set("audiocodecid", 10.0);
+    obj.set("framerate", 25.0);
+    obj.set("encoder", "obs-output module (libobs version 27.0.1)");
+    AMFValue arr(AMF_STRICT_ARRAY);
+    arr.add(1.0);
+    arr.add("two");
+    arr.add(AMFValue(AMF_OBJECT));
+    obj.set("array", arr);
+    AMFEncoder enc;
+    enc << "@setDataFrame" << "onMetaData" << obj;
+    return enc.data();
+}
+
+//解码全部amf值，直到数据结束
+static size_t decodeAll(const BufferLikeString &buf, vector<AMFValue> *out = nullptr) {
+    AMFDecoder dec(buf, 0);
+    size_t count = 0;
+    while (true) {
+        try {
+            auto val = dec.load<AMFValue>();
+            if (out) {
+                out->emplace_back(std::move(val));
+            }
+            ++count;
+        } catch (std::exception &) {
+            break;
+        }
+    }
+    return count;
+}
+
+//解码后再编码应该与原始数据一致(object按原始顺序编码)
+static bool checkRoundTrip(const string &data) {
+    vector<AMFValue> values;
+    decodeAll(data, &values);
+    AMFEncoder enc;
+    for (auto &val : values) {
+        enc << val;
+    }
+    return enc.data() == data;
+}
+
+static void benchmark(int count) {
+    BufferLikeString connect = makeConnect();
+    Ticker ticker;
+    for (int i = 0; i < count; ++i) {
+        AMFDecoder dec(connect, 0);
+        dec.load<std::string>();
+        dec.load<double>();
+        auto params = dec.load<AMFValue>();
+        if (params["app"].as_string().empty()) {
+            break;
+        }
+    }
+    auto elapsed = ticker.elapsedTime() + 1;
+    InfoL << "decode connect:" << count * 1000 / elapsed << "/s";
+
+    ticker.resetTime();
+    size_t bytes = 0;
+    string stream_id = "test";
+    for (int i = 0; i < count; ++i) {
+        AMFValue status(AMF_OBJECT);
+        status.set("level", "status");
+        status.set("code", "NetStream.Play.Start");
+        status.set("description", "Started playing.");
+        status.set("details", stream_id);
+        status.set("clientid", "0");
+        AMFEncoder invoke;
+        invoke << "onStatus" << 0.0 << nullptr << status;
+        bytes += invoke.data().size();
+    }
+    elapsed = ticker.elapsedTime() + 1;
+    InfoL << "encode onStatus by AMFValue:" << count * 1000 / elapsed << "/s";
+
+    ticker.resetTime();
+    for (int i = 0; i < count; ++i) {
+        AMFEncoder invoke;
+        invoke << "onStatus" << 0.0 << nullptr;
+        invoke.object("level", "status",
+                      "code", "NetStream.Play.Start",
+                      "description", "Started playing.",
+                      "details", stream_id,
+                      "clientid", "0");
+        bytes += invoke.data().size();
+    }
+    elapsed = ticker.elapsedTime() + 1;
+    InfoL << "encode onStatus by AMFEncoder::object:" << count * 1000 / elapsed << "/s";
+}
+
+//随机修改合法数据后解码，解码器只能抛异常，不能崩溃或越界
+static void fuzz(int count) {
+    vector<string> seeds = {makeConnect(), makeMetadata()};
+    mt19937 rng(0);
+    Ticker ticker;
+    size_t values = 0;
+    for (int i = 0; i < count; ++i) {
+        string data = seeds[i % seeds.size()];
+        int mutations = 1 + rng() % 8;
+        while (mutations--) {
+            size_t pos = rng() % data.size();
+            switch (rng() % 4) {
+                case 0: data[pos] = (char) rng(); break;
+                case 1: data[pos] ^= 1 << (rng() % 8); break;
+                case 2: data.insert(pos, 1, (char) rng()); break;
+                default: data.resize(pos ? pos : 1); break;
+            }
+        }
+        values += decodeAll(data);
+    }
+    InfoL << "fuzz " << count << " inputs, decoded " << values << " values, elapsed(ms):" << ticker.elapsedTime();
+}
+
+//ecma array中的重复key以第一个为准，与set()一致
+static bool checkDuplicateKey() {
+    string data("\x08\x00\x00\x00\x02", 5);
+    AMFEncoder enc;
+    for (auto width : {1920.0, 1280.0}) {
+        data.append("\x00\x05width", 7);
+        enc.clear();
+        enc << width;
+        data += enc.data();
+    }
+    //object end
+    data.append("\x00\x00\x09", 3);
+
+    vector<AMFValue> values;
+    if (decodeAll(data, &values) != 1) {
+        return false;
+    }
+    auto &obj = values[0];
+    obj.set("width", 640.0);
+    size_t size = 0;
+    obj.object_for_each([&](const string &key, const AMFValue &val) { ++size; });
+    return obj.type() == AMF_ECMA_ARRAY && size == 1 && obj["width"].as_number() == 1920;
+}
+
+//大量key的对象解码耗时应与key数量成线性关系，重复key以第一个为准
+static bool checkManyKeys(int count) {
+    auto write_key = [](string &data, const string &key) {
+        data += (char) (key.size() >> 8);
+        data += (char) (key.size() & 0xFF);
+        data += key;
+    };
+    //amf0 object
+    string data(1, (char) 0x03);
+    AMFEncoder enc;
+    for (int i = 0; i < count; ++i) {
+        write_key(data, to_string(i));
+        enc.clear();
+        enc << (double) i;
+        data += enc.data();
+    }
+    write_key(data, "0");
+    enc.clear();
+    enc << "dup";
+    data += enc.data();
+    //object end
+    write_key(data, "");
+    data += (char) 0x09;
+
+    Ticker ticker;
+    vector<AMFValue> values;
+    if (decodeAll(data, &values) != 1) {
+        return false;
+    }
+    InfoL << "decode object with " << count << " keys, elapsed(ms):" << ticker.elapsedTime();
+    //重复key不重复保存
+    size_t size = 0;
+    values[0].object_for_each([&](const string &key, const AMFValue &val) { ++size; });
+    return size == (size_t) count && values[0]["0"].type() == AMF_NUMBER && values[0]["0"].as_number() == 0
+           && values[0][to_string(count - 1).data()].as_number() == count - 1;
+}
+
+int main(int argc, char *argv[]) {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    if (!checkRoundTrip(makeConnect()) || !checkRoundTrip(makeMetadata())) {
+        ErrorL << "amf round trip failed";
+        return -1;
+    }
+    if (!checkDuplicateKey()) {
+        ErrorL << "amf object with duplicate key decode failed";
+        return -1;
+    }
+    if (!checkManyKeys(100000)) {
+        ErrorL << "amf object with many keys decode failed";
+        return -1;
+    }
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    benchmark(count);
+    fuzz(count);
+    return 0;
+}
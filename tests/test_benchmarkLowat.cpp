@@ -0,0 +1,267 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Util/RingBuffer.h"
+#include "Util/TimeTicker.h"
+#include "Network/TcpServer.h"
+#include "Network/sockutil.h"
+#include "Common/config.h"
+#include "Common/SendQueuePolicy.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+
+//每帧数据头: 8字节生成时间戳(毫秒) + 4字节帧长度(包含帧头)
+static constexpr size_t kHeaderSize = 12;
+static RingBuffer<Buffer::Ptr>::Ptr s_ring;
+//拥塞时被丢弃的帧数
+static atomic<uint64_t> s_drop_frames{0};
+
+//模拟播放器会话，收到任意数据后开始播放，拥塞时按SendQueuePolicy跳至下一个关键帧
+class ViewerSession : public TcpSession, public SendQueuePolicy {
+public:
+    ViewerSession(const Socket::Ptr &sock) : TcpSession(sock) {}
+    ~ViewerSession() override = default;
+
+    void onRecv(const Buffer::Ptr &buf) override {
+        if (_reader) {
+            return;
+        }
+        weak_ptr<ViewerSession> weak_self = dynamic_pointer_cast<ViewerSession>(shared_from_this());
+        _reader = s_ring->attach(getPoller(), false);
+        _reader->setReadCBWithKey([weak_self](const Buffer::Ptr &frame, bool is_key) {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return;
+            }
+            if (!strong_self->inputGroup(strong_self->getSock(), is_key)) {
+                ++s_drop_frames;
+                return;
+            }
+            strong_self->send(frame);
+        });
+    }
+
+    void onError(const SockException &err) override {}
+    void onManager() override {}
+
+private:
+    RingBuffer<Buffer::Ptr>::RingReader::Ptr _reader;
+};
+
+class Viewer {
+public:
+    int fd = -1;
+    bool slow = false;
+    //当前帧已收到的帧头字节数
+    size_t header_got = 0;
+    //当前帧剩余未收到的字节数
+    size_t remain = 0;
+    char header[kHeaderSize];
+};
+
+class LatencyStat {
+public:
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    void input(uint64_t latency) {
+        ++count;
+        sum += latency;
+        max = MAX(max, latency);
+    }
+};
+
+static void onViewerData(Viewer &viewer, const char *data, size_t size, LatencyStat &stat) {
+    while (size) {
+        if (viewer.remain == 0) {
+            //接收帧头
+            auto len = MIN(kHeaderSize - viewer.header_got, size);
+            memcpy(viewer.header + viewer.header_got, data, len);
+            viewer.header_got += len;
+            data += len;
+            size -= len;
+            if (viewer.header_got < kHeaderSize) {
+                break;
+            }
+            uint64_t stamp;
+            uint32_t frame_size;
+            memcpy(&stamp, viewer.header, 8);
+            memcpy(&frame_size, viewer.header + 8, 4);
+            stat.input(getCurrentMillisecond() - stamp);
+            viewer.header_got = 0;
+            viewer.remain = frame_size - kHeaderSize;
+            continue;
+        }
+        auto len = MIN(viewer.remain, size);
+        viewer.remain -= len;
+        data += len;
+        size -= len;
+    }
+}
+
+//内核tcp协议栈占用的内存(包括服务器与播放器两端的socket缓存)，单位字节
+static uint64_t kernelTcpMemory() {
+    ifstream in("/proc/net/sockstat");
+    string line;
+    while (getline(in, line)) {
+        auto pos = line.find("TCP:");
+        if (pos == string::npos) {
+            continue;
+        }
+        pos = line.find(" mem ");
+        if (pos == string::npos) {
+            break;
+        }
+        return atoll(line.data() + pos + 5) * sysconf(_SC_PAGESIZE);
+    }
+    return 0;
+}
+
+static uint64_t processRss() {
+    ifstream in("/proc/self/statm");
+    uint64_t size = 0, rss = 0;
+    in >> size >> rss;
+    return rss * sysconf(_SC_PAGESIZE);
+}
+
+int main(int argc, char *argv[]) {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+
+    if (argc < 2) {
+        ErrorL << "\r\n测试方法:./test_benchmarkLowat viewer_count [notsent_lowat] [seconds] [kbps] [slow_percent]\r\n"
+               << "例如你想测试10000个播放器(其中10%网络只有码率一半带宽)在开启TCP_NOTSENT_LOWAT(16KB)时的内存与延时，可以输入以下命令:\r\n"
+               << "./test_benchmarkLowat 10000 16384 30 512 10\r\n"
+               << "再把notsent_lowat置0运行一次作为对比，需要先通过ulimit -n调大文件描述符个数\r\n"
+               << endl;
+        return 0;
+    }
+    int viewer_count = atoi(argv[1]);
+    int notsent_lowat = argc > 2 ? atoi(argv[2]) : 16 * 1024;
+    int seconds = argc > 3 ? atoi(argv[3]) : 30;
+    int kbps = argc > 4 ? atoi(argv[4]) : 512;
+    int slow_percent = argc > 5 ? atoi(argv[5]) : 10;
+
+    //25fps，每秒一个关键帧
+    size_t frame_size = MAX(kHeaderSize, (size_t) kbps * 1024 / 8 / 25);
+    //慢速播放器每10ms可读取的字节数(只有码率一半的带宽)
+    size_t slow_budget = MAX((size_t) 1, (size_t) kbps * 1024 / 8 / 2 / 100);
+
+    s_ring = std::make_shared<RingBuffer<Buffer::Ptr> >();
+    TcpServer::Ptr server(new TcpServer());
+    server->setNotSentLowat(notsent_lowat);
+    server->start<ViewerSession>(0, "127.0.0.1");
+    auto port = server->getPort();
+
+    //生成数据帧
+    auto frame_index = std::make_shared<uint64_t>(0);
+    auto source_poller = EventPollerPool::Instance().getPoller();
+    source_poller->doDelayTask(40, [frame_index, frame_size]() -> uint64_t {
+        auto frame = std::make_shared<BufferRaw>(frame_size);
+        frame->setSize(frame_size);
+        uint64_t stamp = getCurrentMillisecond();
+        uint32_t size = (uint32_t) frame_size;
+        memcpy(frame->data(), &stamp, 8);
+        memcpy(frame->data() + 8, &size, 4);
+        s_ring->write(frame, (*frame_index)++ % 25 == 0);
+        return 40;
+    });
+
+    //创建播放器
+    int epoll_fd = epoll_create(1024);
+    vector<Viewer> viewers(viewer_count);
+    for (int i = 0; i < viewer_count; ++i) {
+        auto &viewer = viewers[i];
+        viewer.fd = SockUtil::connect("127.0.0.1", port, false);
+        if (viewer.fd == -1) {
+            ErrorL << "connect failed:" << get_uv_errmsg();
+            return -1;
+        }
+        SockUtil::setNoBlocked(viewer.fd);
+        //限制播放器接收缓存，模拟公网下数据主要积压在服务器端的情况
+        SockUtil::setRecvBuf(viewer.fd, 32 * 1024);
+        viewer.slow = i * 100 < viewer_count * slow_percent;
+        ::send(viewer.fd, "p", 1, 0);
+        if (!viewer.slow) {
+            struct epoll_event ev = {0};
+            ev.events = EPOLLIN;
+            ev.data.ptr = &viewer;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, viewer.fd, &ev);
+        }
+    }
+    InfoL << "viewers:" << viewer_count << ", notsent_lowat:" << notsent_lowat << ", frame size:" << frame_size;
+
+    LatencyStat fast_stat, slow_stat;
+    uint64_t max_kernel_mem = 0, max_rss = 0;
+    char buf[64 * 1024];
+    struct epoll_event events[1024];
+    Ticker ticker, sample_ticker;
+    while (ticker.elapsedTime() < (uint64_t) seconds * 1000) {
+        //正常播放器有数据即读取
+        int ret = epoll_wait(epoll_fd, events, 1024, 10);
+        for (int i = 0; i < ret; ++i) {
+            auto &viewer = *(Viewer *) events[i].data.ptr;
+            auto n = ::recv(viewer.fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                onViewerData(viewer, buf, n, fast_stat);
+            }
+        }
+        if (sample_ticker.elapsedTime() >= 10) {
+            sample_ticker.resetTime();
+            //慢速播放器每10ms按带宽限制读取
+            for (auto &viewer : viewers) {
+                if (!viewer.slow) {
+                    continue;
+                }
+                auto n = ::recv(viewer.fd, buf, MIN(slow_budget, sizeof(buf)), 0);
+                if (n > 0) {
+                    onViewerData(viewer, buf, n, slow_stat);
+                }
+            }
+            max_kernel_mem = MAX(max_kernel_mem, kernelTcpMemory());
+            max_rss = MAX(max_rss, processRss());
+        }
+    }
+
+    InfoL << "viewers:" << viewer_count
+          << ", notsent_lowat:" << notsent_lowat
+          << ", kernel tcp mem(MB):" << max_kernel_mem / 1024 / 1024
+          << ", rss(MB):" << max_rss / 1024 / 1024
+          << ", fast avg/max latency(ms):" << (fast_stat.count ? fast_stat.sum / fast_stat.count : 0) << "/" << fast_stat.max
+          << ", slow avg/max latency(ms):" << (slow_stat.count ? slow_stat.sum / slow_stat.count : 0) << "/" << slow_stat.max
+          << ", dropped frames:" << s_drop_frames.load();
+
+    for (auto &viewer : viewers) {
+        close(viewer.fd);
+    }
+    close(epoll_fd);
+    return 0;
+}
+
+#else
+int main(int argc, char *argv[]) {
+    cout << "only linux supported" << endl;
+    return 0;
+}
+#endif //defined(__linux__)
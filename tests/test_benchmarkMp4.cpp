@@ -0,0 +1,120 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <iostream>
+#include <vector>
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Common/config.h"
+#include "Record/MP4Demuxer.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#ifdef ENABLE_MP4
+class VodSession {
+public:
+    MP4Demuxer::Ptr demuxer;
+    uint64_t frames = 0;
+    int64_t first_stamp = -1;
+    int64_t last_stamp = 0;
+    bool eof = false;
+};
+
+//单线程模拟多个点播会话交替读取mp4文件，统计单核能支撑的实时点播会话数
+static void benchmark(const string &file, int session_count, size_t read_ahead_size) {
+    mINI::Instance()[Record::kReadAheadSize] = read_ahead_size;
+    NoticeCenter::Instance().emitEvent(Broadcast::kBroadcastReloadConfig);
+
+    vector<VodSession> sessions(session_count);
+    for (int i = 0; i < session_count; ++i) {
+        auto &session = sessions[i];
+        session.demuxer = std::make_shared<MP4Demuxer>();
+        session.demuxer->openMP4(file);
+        //每个会话从不同位置开始播放
+        session.demuxer->seekTo(session.demuxer->getDurationMS() * i / session_count);
+    }
+
+    Ticker ticker;
+    uint64_t total_frames = 0;
+    int64_t total_media_ms = 0;
+    int alive = session_count;
+    while (alive) {
+        alive = 0;
+        for (auto &session : sessions) {
+            if (session.eof) {
+                continue;
+            }
+            //每个会话每次读取500毫秒数据(与MP4Reader的sampleMS一致)
+            int64_t start_stamp = -1;
+            bool key_frame;
+            while (!session.eof) {
+                auto frame = session.demuxer->readFrame(key_frame, session.eof);
+                if (!frame) {
+                    continue;
+                }
+                ++session.frames;
+                if (session.first_stamp == -1) {
+                    session.first_stamp = frame->dts();
+                }
+                if (start_stamp == -1) {
+                    start_stamp = frame->dts();
+                }
+                session.last_stamp = MAX(session.last_stamp, (int64_t) frame->dts());
+                if (frame->dts() - start_stamp > 500) {
+                    break;
+                }
+            }
+            if (!session.eof) {
+                ++alive;
+            }
+        }
+    }
+    for (auto &session : sessions) {
+        total_frames += session.frames;
+        if (session.first_stamp != -1) {
+            total_media_ms += session.last_stamp - session.first_stamp;
+        }
+    }
+
+    int64_t elapsed = ticker.elapsedTime() + 1;
+    InfoL << "readAheadSize:" << read_ahead_size
+          << ", sessions:" << session_count
+          << ", frames:" << total_frames
+          << ", elapsed(ms):" << elapsed
+          << ", frames/s:" << total_frames * 1000 / elapsed
+          << ", realtime sessions per core:" << total_media_ms / elapsed;
+}
+#endif //ENABLE_MP4
+
+int main(int argc, char *argv[]) {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+
+#ifdef ENABLE_MP4
+    if (argc < 2) {
+        ErrorL << "\r\n测试方法:./test_benchmarkMp4 mp4_file [session_count]\r\n"
+               << "例如你想测试100个会话同时点播test.mp4的性能，可以输入以下命令:\r\n"
+               << "./test_benchmarkMp4 ./test.mp4 100\r\n"
+               << endl;
+        return 0;
+    }
+    int session_count = argc > 2 ? atoi(argv[2]) : 100;
+    //关闭预读
+    benchmark(argv[1], session_count, 0);
+    //开启预读
+    benchmark(argv[1], session_count, 1024 * 1024);
+#else
+    ErrorL << "ENABLE_MP4 not defined";
+#endif //ENABLE_MP4
+    return 0;
+}
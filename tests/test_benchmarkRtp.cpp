@@ -0,0 +1,172 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Util/TimeTicker.h"
+#include "Network/sockutil.h"
+#include "Poller/EventPoller.h"
+#include "Common/config.h"
+#include "Rtp/RtpServer.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(ENABLE_RTPPROXY) && defined(__linux__)
+//读取/proc/net/snmp中udp的统计信息
+static bool getUdpStatistic(uint64_t &in_datagrams, uint64_t &rcvbuf_errors) {
+    ifstream snmp("/proc/net/snmp");
+    string line;
+    vector<string> keys;
+    while (getline(snmp, line)) {
+        if (line.find("Udp:") != 0) {
+            continue;
+        }
+        auto fields = split(line, " ");
+        if (keys.empty()) {
+            keys = fields;
+            continue;
+        }
+        for (size_t i = 0; i < fields.size() && i < keys.size(); ++i) {
+            if (keys[i] == "InDatagrams") {
+                in_datagrams = strtoull(fields[i].data(), nullptr, 10);
+            } else if (keys[i] == "RcvbufErrors") {
+                rcvbuf_errors = strtoull(fields[i].data(), nullptr, 10);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+//每个发送线程负责一部分ssrc，使用同一个socket循环发送，源地址相同，只能依靠ssrc分流
+static void sendRtp(uint16_t port, int index, int threads, int streams, atomic_bool &exit_flag, atomic<uint64_t> &sent) {
+    static constexpr int kBatch = 64;
+    static constexpr int kPayload = 1024;
+    int fd = SockUtil::bindUdpSock(0, "127.0.0.1");
+    SockUtil::setNoBlocked(fd, false);
+    SockUtil::setSendBuf(fd, 4 * 1024 * 1024);
+    struct sockaddr_in peer = {0};
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(port);
+    peer.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    vector<uint32_t> ssrcs;
+    for (int i = index; i < streams; i += threads) {
+        ssrcs.emplace_back(0x10000000 + i);
+    }
+    if (ssrcs.empty()) {
+        close(fd);
+        return;
+    }
+
+    vector<string> packets(kBatch, string(12 + kPayload, '\0'));
+    struct mmsghdr msgs[kBatch];
+    struct iovec iovs[kBatch];
+    uint16_t seq = 0;
+    size_t ssrc_index = 0;
+    while (!exit_flag) {
+        for (int i = 0; i < kBatch; ++i) {
+            auto &packet = packets[i];
+            auto ptr = (uint8_t *) packet.data();
+            uint32_t ssrc = htonl(ssrcs[ssrc_index++ % ssrcs.size()]);
+            uint16_t seq_n = htons(seq++);
+            uint32_t stamp = htonl(seq * 3600);
+            ptr[0] = 0x80;
+            ptr[1] = 96;
+            memcpy(ptr + 2, &seq_n, 2);
+            memcpy(ptr + 4, &stamp, 4);
+            memcpy(ptr + 8, &ssrc, 4);
+            iovs[i].iov_base = ptr;
+            iovs[i].iov_len = packet.size();
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_name = &peer;
+            msgs[i].msg_hdr.msg_namelen = sizeof(peer);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        auto ret = sendmmsg(fd, msgs, kBatch, 0);
+        if (ret > 0) {
+            sent += ret;
+        }
+    }
+    close(fd);
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+
+#if defined(ENABLE_RTPPROXY) && defined(__linux__)
+    if (argc < 2) {
+        ErrorL << "\r\n测试方法:./test_benchmarkRtp shards [streams] [seconds] [sender_threads] [port]\r\n"
+               << "在本机回环网卡上模拟大量摄像头往同一个端口推rtp，统计单端口模式下不同分片数的收包能力，例如:\r\n"
+               << "./test_benchmarkRtp 1 2000 10 4\r\n"
+               << "./test_benchmarkRtp 4 2000 10 4\r\n"
+               << endl;
+        return 0;
+    }
+    int shards = atoi(argv[1]);
+    int streams = argc > 2 ? atoi(argv[2]) : 2000;
+    int seconds = argc > 3 ? atoi(argv[3]) : 10;
+    int threads = argc > 4 ? atoi(argv[4]) : 4;
+    uint16_t port = argc > 5 ? atoi(argv[5]) : 10000;
+
+    //每个分片一个poller线程
+    EventPollerPool::setPoolSize(MAX(shards, 1));
+    mINI::Instance()[RtpProxy::kUdpShards] = MAX(shards, 1);
+
+    auto server = std::make_shared<RtpServer>();
+    server->start(port, "", false, "127.0.0.1");
+
+    atomic_bool exit_flag{false};
+    atomic<uint64_t> sent{0};
+    vector<std::shared_ptr<thread> > senders;
+    for (int i = 0; i < threads; ++i) {
+        senders.emplace_back(std::make_shared<thread>([&, i]() {
+            sendRtp(port, i, threads, streams, exit_flag, sent);
+        }));
+    }
+
+    //预热，让所有ssrc创建完RtpProcess
+    sleep(2);
+    uint64_t in_start = 0, err_start = 0, in_end = 0, err_end = 0;
+    getUdpStatistic(in_start, err_start);
+    uint64_t sent_start = sent;
+    Ticker ticker;
+    sleep(seconds);
+    getUdpStatistic(in_end, err_end);
+    uint64_t sent_end = sent;
+    auto elapsed = ticker.elapsedTime() + 1;
+    exit_flag = true;
+    for (auto &sender : senders) {
+        sender->join();
+    }
+
+    InfoL << "shards:" << shards
+          << ", streams:" << streams
+          << ", sent pps:" << (sent_end - sent_start) * 1000 / elapsed
+          << ", received pps:" << (in_end - in_start) * 1000 / elapsed
+          << ", dropped pps:" << (err_end - err_start) * 1000 / elapsed;
+    server = nullptr;
+    sleep(1);
+#else
+    ErrorL << "ENABLE_RTPPROXY not defined or not linux";
+#endif
+    return 0;
+}
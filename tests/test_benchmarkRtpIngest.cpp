@@ -0,0 +1,454 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <time.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Util/TimeTicker.h"
+#include "Network/sockutil.h"
+#include "Poller/EventPoller.h"
+#include "Common/config.h"
+#include "Common/MultiMediaSourceMuxer.h"
+#include "Rtsp/RtspMediaSource.h"
+#include "Rtp/RtpServer.h"
+#include "Rtp/GB28181Process.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(ENABLE_RTPPROXY) && defined(__linux__)
+//rtp_proxy.dumpDir导出的文件格式: 2字节长度(网络字节序) + rtp
+static bool loadDump(const string &path, vector<string> &packets) {
+    FILE *fp = fopen(path.data(), "rb");
+    if (!fp) {
+        WarnL << "open file failed:" << path;
+        return false;
+    }
+    uint8_t len_buf[2];
+    while (2 == fread(len_buf, 1, 2, fp)) {
+        size_t len = (len_buf[0] << 8) | len_buf[1];
+        if (len < 12) {
+            break;
+        }
+        string rtp(len, '\0');
+        if (len != fread((char *) rtp.data(), 1, len, fp)) {
+            break;
+        }
+        packets.emplace_back(std::move(rtp));
+    }
+    fclose(fp);
+    return !packets.empty();
+}
+
+static uint64_t cpuTimeUS(clockid_t clock_id = CLOCK_THREAD_CPUTIME_ID) {
+    struct timespec ts;
+    clock_gettime(clock_id, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static uint64_t processCpuTimeUS() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+//读取/proc/net/snmp中udp的统计信息
+static void getUdpStatistic(uint64_t &in_datagrams, uint64_t &rcvbuf_errors) {
+    ifstream snmp("/proc/net/snmp");
+    string line;
+    vector<string> keys;
+    while (getline(snmp, line)) {
+        if (line.find("Udp:") != 0) {
+            continue;
+        }
+        auto fields = split(line, " ");
+        if (keys.empty()) {
+            keys = fields;
+            continue;
+        }
+        for (size_t i = 0; i < fields.size() && i < keys.size(); ++i) {
+            if (keys[i] == "InDatagrams") {
+                in_datagrams = strtoull(fields[i].data(), nullptr, 10);
+            } else if (keys[i] == "RcvbufErrors") {
+                rcvbuf_errors = strtoull(fields[i].data(), nullptr, 10);
+            }
+        }
+        return;
+    }
+}
+
+////////////////////////////////////////离线分阶段测试////////////////////////////////////////
+
+//rtp排序阶段，输出排序后的rtp包
+class SortStage : public RtpReceiver {
+public:
+    vector<RtpPacket::Ptr> sorted;
+
+    void input(string &rtp) {
+        handleOneRtp(0, TrackVideo, 90000, (unsigned char *) rtp.data(), rtp.size());
+    }
+
+protected:
+    void onRtpSorted(const RtpPacket::Ptr &rtp, int) override {
+        sorted.emplace_back(rtp);
+    }
+};
+
+//ps/ts解复用阶段，输出track与未分帧的frame
+class DemuxSink : public MediaSinkInterface {
+public:
+    vector<Track::Ptr> tracks;
+    vector<Frame::Ptr> frames;
+
+    void addTrack(const Track::Ptr &track) override { tracks.emplace_back(track); }
+    void resetTracks() override {}
+    void inputFrame(const Frame::Ptr &frame) override { frames.emplace_back(Frame::getCacheAbleFrame(frame)); }
+};
+
+class DemuxStage : public GB28181Process {
+public:
+    DemuxStage(const MediaInfo &info, MediaSinkInterface *sink) : GB28181Process(info, sink) {}
+    using GB28181Process::onRtpSorted;
+};
+
+//track分帧阶段(例如h264拆分sps/pps/idr)
+class SplitStage : public MediaSink {
+public:
+    vector<Frame::Ptr> frames;
+
+protected:
+    void onTrackFrame(const Frame::Ptr &frame) override { frames.emplace_back(Frame::getCacheAbleFrame(frame)); }
+};
+
+class StageTicker {
+public:
+    StageTicker(const char *name) : _name(name) {
+        _cpu = cpuTimeUS();
+    }
+
+    uint64_t print(size_t packets, size_t frames) {
+        auto cpu = cpuTimeUS() - _cpu + 1;
+        _StrPrinter printer;
+        printer << _name << " cpu(us):" << cpu << ", us/packet:" << (double) cpu / MAX(packets, (size_t) 1);
+        if (frames) {
+            printer << ", us/frame:" << (double) cpu / frames << ", frames/s per core:" << frames * 1000000 / cpu;
+        }
+        InfoL << printer;
+        return cpu;
+    }
+
+private:
+    const char *_name;
+    uint64_t _cpu;
+};
+
+//单线程依次执行各处理阶段，统计每个阶段的cpu耗时，返回每个rtp包的总处理耗时(us)
+static double benchmarkStages(vector<string> packets) {
+    uint64_t total = 0;
+    SortStage sort_stage;
+    StageTicker sort_ticker("sort");
+    for (auto &packet : packets) {
+        sort_stage.input(packet);
+    }
+    total += sort_ticker.print(packets.size(), 0);
+
+    DemuxSink demux_sink;
+    MediaInfo info;
+    info._streamid = "benchmark";
+    DemuxStage demux_stage(info, &demux_sink);
+    StageTicker demux_ticker("demux");
+    for (auto &rtp : sort_stage.sorted) {
+        demux_stage.onRtpSorted(rtp, 0);
+    }
+    total += demux_ticker.print(packets.size(), demux_sink.frames.size());
+
+    SplitStage split_stage;
+    for (auto &track : demux_sink.tracks) {
+        split_stage.addTrack(track);
+    }
+    split_stage.addTrackCompleted();
+    StageTicker split_ticker("track split");
+    for (auto &frame : demux_sink.frames) {
+        split_stage.inputFrame(frame);
+    }
+    total += split_ticker.print(packets.size(), split_stage.frames.size());
+
+    //hls与mp4涉及磁盘io，不参与测试
+    auto muxer = std::make_shared<MultiMediaSourceMuxer>(DEFAULT_VHOST, "benchmark", "stages", 0.0, true, true, false, false);
+    for (auto &track : split_stage.getTracks(false)) {
+        muxer->addTrack(track);
+    }
+    muxer->addTrackCompleted();
+    StageTicker mux_ticker("muxers");
+    for (auto &frame : split_stage.frames) {
+        muxer->inputFrame(frame);
+    }
+    total += mux_ticker.print(packets.size(), split_stage.frames.size());
+
+    InfoL << "packets:" << packets.size() << ", sorted:" << sort_stage.sorted.size()
+          << ", demuxed frames:" << demux_sink.frames.size() << ", split frames:" << split_stage.frames.size();
+    return (double) total / MAX(packets.size(), (size_t) 1);
+}
+
+////////////////////////////////////////网络回放测试////////////////////////////////////////
+
+//模拟的摄像头，循环回放同一个dump文件，改写ssrc、seq与时间戳
+class Camera {
+public:
+    const vector<string> *packets;
+    uint32_t ssrc;
+    size_t index = 0;
+    uint16_t seq = 0;
+    uint32_t stamp_offset = 0;
+    //回放起始时间(毫秒)，错开各个摄像头的发送时刻
+    uint64_t start_ms = 0;
+    int fd = -1;
+
+    //生成下一个rtp包，返回其应该发送的时刻(毫秒)
+    uint64_t next(string &out) {
+        auto &packet = (*packets)[index];
+        auto first_stamp = readStamp((*packets)[0]);
+        auto stamp = readStamp(packet) - first_stamp;
+        out = packet;
+        auto ptr = (uint8_t *) out.data();
+        uint16_t seq_n = htons(seq++);
+        uint32_t stamp_n = htonl(stamp + stamp_offset);
+        uint32_t ssrc_n = htonl(ssrc);
+        memcpy(ptr + 2, &seq_n, 2);
+        memcpy(ptr + 4, &stamp_n, 4);
+        memcpy(ptr + 8, &ssrc_n, 4);
+        auto due = start_ms + (stamp + stamp_offset) / 90;
+        if (++index == packets->size()) {
+            //循环回放，时间戳继续递增
+            index = 0;
+            stamp_offset += stamp + 3600;
+        }
+        return due;
+    }
+
+private:
+    static uint32_t readStamp(const string &packet) {
+        uint32_t stamp;
+        memcpy(&stamp, packet.data() + 4, 4);
+        return ntohl(stamp);
+    }
+};
+
+static void sendThread(vector<Camera> cameras, uint16_t port, bool udp, bool realtime, atomic_bool &exit_flag,
+                       atomic<uint64_t> &sent) {
+    struct sockaddr_in peer = {0};
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(port);
+    peer.sin_addr.s_addr = inet_addr("127.0.0.1");
+
+    int udp_fd = -1;
+    if (udp) {
+        udp_fd = SockUtil::bindUdpSock(0, "127.0.0.1");
+        SockUtil::setNoBlocked(udp_fd, false);
+        SockUtil::setSendBuf(udp_fd, 4 * 1024 * 1024);
+    } else {
+        for (auto &camera : cameras) {
+            camera.fd = SockUtil::connect("127.0.0.1", port, false);
+            if (camera.fd == -1) {
+                WarnL << "connect failed:" << get_uv_errmsg();
+            }
+        }
+    }
+
+    Ticker ticker;
+    string packet;
+    vector<uint64_t> due(cameras.size(), 0);
+    while (!exit_flag) {
+        auto now = ticker.elapsedTime();
+        bool idle = true;
+        for (size_t i = 0; i < cameras.size(); ++i) {
+            auto &camera = cameras[i];
+            //实时模式下一次发送所有到期的包，否则每个摄像头轮流发送一个包
+            while (!exit_flag && (!realtime || due[i] <= now)) {
+                due[i] = camera.next(packet);
+                ssize_t ret;
+                if (udp) {
+                    ret = sendto(udp_fd, packet.data(), packet.size(), 0, (struct sockaddr *) &peer, sizeof(peer));
+                } else {
+                    uint8_t len[2] = {(uint8_t) (packet.size() >> 8), (uint8_t) (packet.size() & 0xFF)};
+                    packet.insert(0, (char *) len, 2);
+                    ret = camera.fd == -1 ? -1 : ::send(camera.fd, packet.data(), packet.size(), MSG_NOSIGNAL);
+                }
+                if (ret > 0) {
+                    ++sent;
+                }
+                idle = false;
+                if (!realtime) {
+                    break;
+                }
+            }
+        }
+        if (realtime && idle) {
+            usleep(1000);
+        }
+    }
+
+    if (udp_fd != -1) {
+        close(udp_fd);
+    }
+    for (auto &camera : cameras) {
+        if (camera.fd != -1) {
+            close(camera.fd);
+        }
+    }
+}
+
+static void benchmarkIngest(const vector<vector<string> > &dumps, int camera_count, int seconds, bool udp, bool realtime,
+                            int threads, uint16_t port, double stage_us_per_packet) {
+    //rtp_proxy在无人观看时会直接丢弃数据，所以这里为每个rtsp源挂载一个读取器，并统计输出的视频帧数
+    atomic<uint64_t> frames{0};
+    mutex readers_mtx;
+    vector<RtspMediaSource::RingType::RingReader::Ptr> readers;
+    NoticeCenter::Instance().addListener(nullptr, Broadcast::kBroadcastMediaChanged, [&](BroadcastMediaChangedArgs) {
+        if (!bRegist || sender.getSchema() != RTSP_SCHEMA) {
+            return;
+        }
+        auto src = dynamic_cast<RtspMediaSource *>(&sender);
+        if (!src) {
+            return;
+        }
+        auto reader = src->getRing()->attach(EventPollerPool::Instance().getPoller(), false);
+        reader->setReadCB([&frames](const RtspMediaSource::RingDataType &pack) {
+            pack->for_each([&](const RtpPacket::Ptr &rtp) {
+                if (rtp->type == TrackVideo && rtp->mark) {
+                    ++frames;
+                }
+            });
+        });
+        lock_guard<mutex> lck(readers_mtx);
+        readers.emplace_back(std::move(reader));
+    });
+
+    auto server = std::make_shared<RtpServer>();
+    server->start(port, "", !udp, "127.0.0.1");
+
+    atomic_bool exit_flag{false};
+    atomic<uint64_t> sent{0};
+    vector<vector<Camera> > groups(threads);
+    for (int i = 0; i < camera_count; ++i) {
+        Camera camera;
+        camera.packets = &dumps[i % dumps.size()];
+        camera.ssrc = 0x20000000 + i;
+        camera.start_ms = i * 40 / MAX(camera_count / 25, 1);
+        groups[i % threads].emplace_back(camera);
+    }
+    vector<std::shared_ptr<thread> > senders;
+    for (auto &group : groups) {
+        senders.emplace_back(std::make_shared<thread>([&, group]() {
+            sendThread(group, port, udp, realtime, exit_flag, sent);
+        }));
+    }
+
+    //预热，等待所有流注册完毕
+    sleep(3);
+    auto senders_cpu = [&]() {
+        uint64_t ret = 0;
+        for (auto &sender : senders) {
+            clockid_t clock_id;
+            if (0 == pthread_getcpuclockid(sender->native_handle(), &clock_id)) {
+                ret += cpuTimeUS(clock_id);
+            }
+        }
+        return ret;
+    };
+    uint64_t in_start = 0, err_start = 0, in_end = 0, err_end = 0;
+    getUdpStatistic(in_start, err_start);
+    uint64_t sent_start = sent, frames_start = frames;
+    uint64_t cpu_start = processCpuTimeUS() - senders_cpu();
+    Ticker ticker;
+    sleep(seconds);
+    uint64_t cpu_end = processCpuTimeUS() - senders_cpu();
+    getUdpStatistic(in_end, err_end);
+    uint64_t sent_end = sent, frames_end = frames;
+    auto elapsed = ticker.elapsedTime() + 1;
+    exit_flag = true;
+    for (auto &sender : senders) {
+        sender->join();
+    }
+
+    auto packets = sent_end - sent_start;
+    auto cpu = cpu_end - cpu_start + 1;
+    InfoL << (udp ? "udp" : "tcp") << (realtime ? " realtime" : " fast")
+          << ", cameras:" << camera_count
+          << ", readers:" << readers.size()
+          << ", sent pps:" << packets * 1000 / elapsed
+          << ", frames/s:" << (frames_end - frames_start) * 1000 / elapsed
+          << ", server cpu:" << cpu * 100 / (elapsed * 1000) << "%"
+          << ", us/packet:" << (double) cpu / MAX(packets, (uint64_t) 1)
+          << ", socket read+dispatch us/packet(derived):" << (double) cpu / MAX(packets, (uint64_t) 1) - stage_us_per_packet;
+    if (udp) {
+        InfoL << "udp received pps:" << (in_end - in_start) * 1000 / elapsed
+              << ", dropped pps:" << (err_end - err_start) * 1000 / elapsed;
+    }
+
+    NoticeCenter::Instance().delListener(nullptr, Broadcast::kBroadcastMediaChanged);
+    {
+        lock_guard<mutex> lck(readers_mtx);
+        readers.clear();
+    }
+    server = nullptr;
+    sleep(1);
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+    Logger::Instance().setWriter(std::make_shared<AsyncLogWriter>());
+
+#if defined(ENABLE_RTPPROXY) && defined(__linux__)
+    if (argc < 2) {
+        ErrorL << "\r\n测试方法:./test_benchmarkRtpIngest dump_file[,dump_file...] [cameras] [seconds] [udp|tcp] [realtime|fast] [sender_threads] [port]\r\n"
+               << "dump文件由rtp_proxy.dumpDir配置项导出(*.rtp)，先单线程统计各处理阶段的cpu耗时，\r\n"
+               << "然后在本机回环网卡上模拟多个摄像头回放dump文件，统计整体接入能力，例如:\r\n"
+               << "./test_benchmarkRtpIngest ./34020000001320000001.rtp 200 10 udp realtime\r\n"
+               << endl;
+        return 0;
+    }
+
+    vector<vector<string> > dumps;
+    for (auto &path : split(argv[1], ",")) {
+        vector<string> packets;
+        if (loadDump(path, packets)) {
+            dumps.emplace_back(std::move(packets));
+        }
+    }
+    if (dumps.empty()) {
+        ErrorL << "no valid dump file";
+        return -1;
+    }
+    int cameras = argc > 2 ? atoi(argv[2]) : 100;
+    int seconds = argc > 3 ? atoi(argv[3]) : 10;
+    bool udp = argc > 4 ? strcasecmp(argv[4], "tcp") != 0 : true;
+    bool realtime = argc > 5 ? strcasecmp(argv[5], "fast") != 0 : true;
+    int threads = argc > 6 ? atoi(argv[6]) : 2;
+    uint16_t port = argc > 7 ? atoi(argv[7]) : 10000;
+
+    auto stage_us_per_packet = benchmarkStages(dumps[0]);
+    if (cameras > 0) {
+        benchmarkIngest(dumps, cameras, seconds, udp, realtime, MAX(threads, 1), port, stage_us_per_packet);
+    }
+#else
+    ErrorL << "ENABLE_RTPPROXY not defined or not linux";
+#endif
+    return 0;
+}
@@ -0,0 +1,247 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Extension/H264.h"
+#include "Extension/G711.h"
+#include "Http/HttpRequestSplitter.h"
+#include "Rtp/Decoder.h"
+#include "Rtp/PSEncoder.h"
+#include "Rtp/GB28181Process.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(ENABLE_RTPPROXY)
+
+//按编码分别记录解复用出的帧
+class FrameRecorder : public MediaSinkInterface {
+public:
+    void addTrack(const Track::Ptr &track) override {
+        ++tracks;
+    }
+
+    void addTrackCompleted() override {}
+
+    void resetTracks() override {}
+
+    void inputFrame(const Frame::Ptr &frame) override {
+        auto &frames = this->frames[frame->getCodecId()];
+        if (frame->getCodecId() != CodecH264) {
+            frames.emplace_back(StrPrinter << frame->dts() << " " << frame->pts() << " "
+                                           << string(frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize()));
+            return;
+        }
+        //与H264Track一样忽略aud，ps流解复用会去掉帧中间的aud，rtp解复用只去掉帧开头的aud
+        _StrPrinter printer;
+        printer << frame->dts() << " " << frame->pts();
+        splitH264(frame->data(), frame->size(), frame->prefixSize(), [&](const char *ptr, size_t len, size_t prefix) {
+            if (H264_TYPE(ptr[prefix]) != H264Frame::NAL_AUD) {
+                printer << " " << string(ptr + prefix, len - prefix);
+            }
+        });
+        frames.emplace_back(printer);
+    }
+
+    int tracks = 0;
+    map<CodecId, vector<string> > frames;
+};
+
+//把ps流编码成rtp，同时保留完整的ps流
+class PSRtpEncoder : public PSEncoderImp {
+public:
+    PSRtpEncoder() : PSEncoderImp(0x1234, 96) {}
+
+    void onPS(uint32_t stamp, void *packet, size_t bytes) override {
+        ps.append((char *) packet, bytes);
+        PSEncoderImp::onPS(stamp, packet, bytes);
+    }
+
+    void onRTP(Buffer::Ptr rtp) override {
+        //去掉rtp over tcp的4个字节头
+        rtps.emplace_back(rtp->data() + 4, rtp->size() - 4);
+    }
+
+    string ps;
+    vector<string> rtps;
+};
+
+//通过ps流解复用(原有方式)，作为对照
+class PSStreamDecoder : public HttpRequestSplitter {
+public:
+    PSStreamDecoder(MediaSinkInterface *sink) {
+        _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ps, sink);
+    }
+
+protected:
+    const char *onSearchPacketTail(const char *data, size_t len) override {
+        auto ret = _decoder->input((uint8_t *) data, len);
+        return ret > 0 ? data + ret : nullptr;
+    }
+
+    ssize_t onRecvHeader(const char *data, size_t len) override {
+        return 0;
+    }
+
+private:
+    DecoderImp::Ptr _decoder;
+};
+
+static void makeStream(PSRtpEncoder &encoder) {
+    encoder.addTrack(std::make_shared<H264Track>());
+    encoder.addTrack(std::make_shared<G711Track>(CodecG711A, 8000, 1, 16));
+    string sps("\x00\x00\x00\x01\x67\x64\x00\x1f\xac\xd9\x40\x50\x05\xbb\x01\x10", 16);
+    string pps("\x00\x00\x00\x01\x68\xeb\xe3\xcb\x22\xc0", 10);
+    //大帧会被拆分成多个ps包，ps包又会被拆分到多个rtp包
+    size_t sizes[] = {50, 900, 1350, 1500, 3000, 20000, 150000};
+    srand(1);
+    for (int i = 0; i < 200; ++i) {
+        uint32_t stamp = i * 40;
+        bool key = i % 25 == 0;
+        if (key) {
+            encoder.inputFrame(std::make_shared<H264FrameNoCacheAble>((char *) sps.data(), sps.size(), stamp, stamp, 4));
+            encoder.inputFrame(std::make_shared<H264FrameNoCacheAble>((char *) pps.data(), pps.size(), stamp, stamp, 4));
+        }
+        string nal = string("\x00\x00\x00\x01", 4) + (key ? "\x65" : "\x41");
+        nal.resize(nal.size() + sizes[i % 7]);
+        for (size_t j = 5; j < nal.size(); ++j) {
+            nal[j] = rand() % 200 + 1;
+        }
+        encoder.inputFrame(std::make_shared<H264FrameNoCacheAble>((char *) nal.data(), nal.size(), stamp, stamp + 80, 4));
+        for (int j = 0; j < 2; ++j) {
+            string g711(160, '\x55');
+            g711[0] = i;
+            g711[1] = j;
+            encoder.inputFrame(std::make_shared<FrameFromPtr>(CodecG711A, (char *) g711.data(), g711.size(), stamp + j * 20));
+        }
+    }
+}
+
+//rtp包负载是否以ps包头开始
+static bool isPackStart(const string &rtp) {
+    auto ptr = (uint8_t *) rtp.data();
+    return rtp.size() > 16 && ptr[12] == 0 && ptr[13] == 0 && ptr[14] == 1 && ptr[15] == 0xBA;
+}
+
+//ps流解复用时最后一帧要等到下个ps包才输出，rtp解复用在rtp mark位时即可输出，所以最多多出最后一帧
+static bool isSameFrames(const FrameRecorder &from_rtp, const FrameRecorder &from_ps) {
+    if (from_rtp.frames.size() != from_ps.frames.size()) {
+        return false;
+    }
+    for (auto &pr : from_ps.frames) {
+        auto it = from_rtp.frames.find(pr.first);
+        if (it == from_rtp.frames.end() || it->second.size() < pr.second.size() || it->second.size() > pr.second.size() + 1
+            || !equal(pr.second.begin(), pr.second.end(), it->second.begin())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//sub中的帧是否都按顺序出现在all中
+static bool isSubsequence(const vector<string> &sub, const vector<string> &all) {
+    size_t pos = 0;
+    for (auto &frame : sub) {
+        while (pos < all.size() && all[pos] != frame) {
+            ++pos;
+        }
+        if (pos++ >= all.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t frameCount(const FrameRecorder &recorder) {
+    size_t ret = 0;
+    for (auto &pr : recorder.frames) {
+        ret += pr.second.size();
+    }
+    return ret;
+}
+
+int main(int argc, char *argv[]) {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    PSRtpEncoder encoder;
+    makeStream(encoder);
+    size_t split_packs = 0;
+    for (auto &rtp : encoder.rtps) {
+        if (!isPackStart(rtp)) {
+            ++split_packs;
+        }
+    }
+
+    //对照组：完整ps流
+    FrameRecorder expected;
+    PSStreamDecoder ps_decoder(&expected);
+    for (size_t i = 0; i < encoder.ps.size(); i += 1400) {
+        ps_decoder.input(encoder.ps.data() + i, MIN(1400, encoder.ps.size() - i));
+    }
+
+    MediaInfo info;
+    info._streamid = "test";
+
+    //不丢包时，直接从rtp包解复用的结果与ps流一致
+    FrameRecorder lossless;
+    {
+        GB28181Process process(info, &lossless);
+        for (auto &rtp : encoder.rtps) {
+            process.inputRtp(true, rtp.data(), rtp.size());
+        }
+    }
+
+    //丢掉一个ps包中间的rtp包，该ps包内的帧被丢弃，其他帧不受影响
+    FrameRecorder lossy;
+    size_t lost_index = 0;
+    {
+        GB28181Process process(info, &lossy);
+        for (size_t i = 0; i < encoder.rtps.size(); ++i) {
+            if (!lost_index && i > encoder.rtps.size() / 2 && !isPackStart(encoder.rtps[i])) {
+                lost_index = i;
+                continue;
+            }
+            process.inputRtp(true, encoder.rtps[i].data(), encoder.rtps[i].size());
+        }
+    }
+
+    bool ok = split_packs > 0 && lossless.tracks == 2 && isSameFrames(lossless, expected) && lossy.tracks == 2;
+    for (auto &pr : lossless.frames) {
+        auto &frames = lossy.frames[pr.first];
+        ok = ok && isSubsequence(frames, pr.second);
+    }
+    auto lossless_count = frameCount(lossless);
+    auto lossy_count = frameCount(lossy);
+    //只丢一个rtp包，最多影响该包所在的帧及其后同一ps包内的帧
+    ok = ok && lossy_count < lossless_count && lossless_count - lossy_count <= 4;
+
+    cout << "rtp包个数:" << encoder.rtps.size()
+         << " 不以ps包头开始的rtp包个数:" << split_packs
+         << " 对照帧数:" << frameCount(expected)
+         << " 不丢包帧数:" << lossless_count
+         << " 丢掉第" << lost_index << "个rtp包后帧数:" << lossy_count << endl;
+    if (!ok) {
+        cout << "ps rtp解复用结果不正确" << endl;
+        return -1;
+    }
+    return 0;
+}
+
+#else
+int main(int argc, char *argv[]) {
+    return 0;
+}
+#endif//ENABLE_RTPPROXY
@@ -0,0 +1,93 @@
+﻿/*
+ * Copyright (c) 2016 The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/xia-chu/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <iostream>
+#include "Util/logger.h"
+#include "Common/config.h"
+#include "Common/SendQueuePolicy.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#define CHECK(exp) \
+    if (!(exp)) { \
+        ErrorL << "check failed at line " << __LINE__ << ": " #exp; \
+        return false; \
+    }
+
+static void setWatermark(uint32_t max_ms, size_t max_bytes) {
+    mINI::Instance()[General::kSendQueueMaxMS] = max_ms;
+    mINI::Instance()[General::kSendQueueMaxBytes] = max_bytes;
+    NoticeCenter::Instance().emitEvent(Broadcast::kBroadcastReloadConfig);
+}
+
+//默认关闭拥塞控制，任何积压都不丢弃
+static bool testDisabled() {
+    setWatermark(0, 0);
+    SendQueuePolicy policy;
+    CHECK(policy.inputGroup(100 * 1024 * 1024, 60 * 1000, false));
+    CHECK(!policy.dropFrame([]() { return true; }));
+    CHECK(policy.getDropCount() == 0 && policy.getSkipCount() == 0);
+    return true;
+}
+
+//按积压时长判断：超过一半丢非参考帧，超过水位等待下一个关键帧
+static bool testDelayWatermark() {
+    setWatermark(1000, 0);
+    SendQueuePolicy policy;
+    //无积压
+    CHECK(policy.inputGroup(0, 0, false));
+    CHECK(!policy.dropFrame([]() { return true; }));
+
+    //超过水位一半，只丢非参考帧
+    CHECK(policy.inputGroup(1024, 600, false));
+    CHECK(policy.dropFrame([]() { return true; }));
+    CHECK(!policy.dropFrame([]() { return false; }));
+    CHECK(policy.getDropCount() == 1);
+
+    //超过水位，丢弃整组数据
+    CHECK(!policy.inputGroup(1024, 1000, false));
+    CHECK(policy.getSkipCount() == 1);
+    //积压消除前，即使是关键帧也继续丢弃
+    CHECK(!policy.inputGroup(1024, 100, false));
+    CHECK(!policy.inputGroup(1024, 600, true));
+    //积压消除后，从关键帧开始恢复发送
+    CHECK(!policy.inputGroup(0, 0, false));
+    CHECK(policy.inputGroup(0, 0, true));
+    CHECK(!policy.dropFrame([]() { return true; }));
+    CHECK(policy.getSkipCount() == 1);
+    return true;
+}
+
+//按积压字节数判断
+static bool testBytesWatermark() {
+    setWatermark(0, 1000);
+    SendQueuePolicy policy;
+    CHECK(policy.inputGroup(499, 60 * 1000, false));
+    CHECK(!policy.dropFrame([]() { return true; }));
+    CHECK(policy.inputGroup(500, 0, false));
+    CHECK(policy.dropFrame([]() { return true; }));
+    CHECK(!policy.inputGroup(1000, 0, true));
+    CHECK(policy.inputGroup(0, 0, true));
+    CHECK(policy.getQueueBytes() == 0);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    //设置日志
+    Logger::Instance().add(std::make_shared<ConsoleChannel>());
+
+    if (!testDisabled() || !testDelayWatermark() || !testBytesWatermark()) {
+        return -1;
+    }
+    InfoL << "all tests passed";
+    return 0;
+}
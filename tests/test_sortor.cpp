@@ -9,10 +9,13 @@
  */
 
 #include <map>
+#include <set>
 #include <list>
+#include <vector>
 #include <iostream>
 #include <functional>
 #include "Rtsp/RtpReceiver.h"
+#include "Rtsp/RtpNack.h"
 using namespace std;
 using namespace mediakit;
 
@@ -270,6 +273,96 @@ void test_rand(){
 #endif
 }
 
+//解析rtcp nack包中请求重传的seq
+static void parseNack(const string &rtcp, set<uint16_t> &nack_seqs) {
+    auto ptr = (const uint8_t *) rtcp.data();
+    for (size_t i = 12; i + 4 <= rtcp.size(); i += 4) {
+        uint16_t pid = (ptr[i] << 8) | ptr[i + 1];
+        uint16_t blp = (ptr[i + 2] << 8) | ptr[i + 3];
+        nack_seqs.emplace(pid);
+        for (int bit = 0; bit < 16; ++bit) {
+            if (blp & (1 << bit)) {
+                nack_seqs.emplace((uint16_t) (pid + bit + 1));
+            }
+        }
+    }
+}
+
+//开启nack时(setWaitLost(true))，seq回环附近出现乱序、丢包、重传，与RtpReceiver::handleNack处理方式一致
+bool test_wait_lost() {
+    static constexpr uint32_t kNackMaxMS = 100;
+    PacketSortor<uint16_t, uint16_t> sortor;
+    RtpNackContext nack;
+    vector<uint16_t> sorted_list;
+    set<uint16_t> nack_seqs;
+    uint64_t now_ms = 1000;
+    sortor.setOnSort([&](uint16_t seq, const uint16_t &packet) {
+        sorted_list.push_back(seq);
+    });
+    sortor.setWaitLost(true);
+
+    auto check_nack = [&]() {
+        auto rtcp = nack.makeNack(now_ms, kNackMaxMS, 0x12345678);
+        parseNack(rtcp, nack_seqs);
+        while (sortor.isBlocked() && !nack.isWaiting(sortor.getNextSeq())) {
+            sortor.skipLost();
+        }
+    };
+    auto input = [&](uint16_t seq) {
+        nack.inputRtp(seq, now_ms);
+        sortor.sortPacket(seq, seq);
+        check_nack();
+    };
+
+    //0xFFFF晚到2个包(普通乱序)，0xFFFE与3彻底丢失，5丢失后重传恢复
+    set<uint16_t> lost = {0xFFFE, 3};
+    vector<uint16_t> expected;
+    for (uint16_t seq = 0xFFFF - 30; seq != 60; ++seq) {
+        if (!lost.count(seq)) {
+            expected.push_back(seq);
+        }
+        if (lost.count(seq) || seq == 0xFFFF || seq == 5) {
+            continue;
+        }
+        now_ms += 1;
+        input(seq);
+        if (seq == 1) {
+            input(0xFFFF);
+        }
+    }
+    //等待重传期间，排序在第一个丢失的包处阻塞
+    bool blocked = !sorted_list.empty() && sorted_list.back() == 0xFFFD && sortor.isBlocked();
+
+    //收到重传包，然后等待超时放弃剩余的丢包
+    now_ms += 5;
+    input(5);
+    now_ms += kNackMaxMS;
+    check_nack();
+    sortor.flush();
+
+    bool nack_ok = nack_seqs == set<uint16_t>{0xFFFE, 3, 5};
+    bool sort_ok = sorted_list == expected;
+    cout << "等待丢包时阻塞:" << blocked
+         << " 请求重传的包:" << nack_seqs.size()
+         << " 输出数据个数:" << sorted_list.size() << "/" << expected.size()
+         << " 回环次数:" << sortor.getCycleCount() << endl;
+    if (!nack_ok) {
+        cout << "请求重传的包不正确:";
+        for (auto seq : nack_seqs) {
+            cout << seq << " ";
+        }
+        cout << endl;
+    }
+    if (!sort_ok) {
+        cout << "排序后:";
+        for (auto seq : sorted_list) {
+            cout << seq << " ";
+        }
+        cout << endl;
+    }
+    return blocked && nack_ok && sort_ok && sortor.getCycleCount() == 1;
+}
+
 //该测试程序用于检验rtp排序算法的正确性
 int main(int argc, char *argv[]) {
     //测试真实的rtp seq
@@ -279,5 +372,12 @@ int main(int argc, char *argv[]) {
     //模拟rtp乱序、回环、丢包、重复情况
     cout << "###### 模拟的rtp seq #####" << endl;
     test_rand();
+
+    //模拟开启nack时seq回环、乱序、丢包、重传情况
+    cout << "###### 等待重传的rtp seq #####" << endl;
+    if (!test_wait_lost()) {
+        cout << "等待重传时排序结果不正确" << endl;
+        return -1;
+    }
     return 0;
 }
\ No newline at end of file